@@ -8,6 +8,17 @@
  * e DatabaseCleanup centralizado
  * 
  * @author Marcos Rinaldi
+ * @version 3.2 - esp/active com ETag (304 sem corpo se o ESP já tem a mesma
+ *               resposta) e config + etapa atual numa consulta só
+ * @version 3.1 - Estado em delta ('base' = 'seq' do último estado confirmado),
+ *               mesclado no snapshot gravado antes de salvar
+ * @version 3.0 - Corpo em MessagePack (application/msgpack) no esp/batch; o
+ *               ESP não comprime mais o estado, e decompressStateData()
+ *               normaliza o formato longo para os mesmos valores
+ * @version 2.9 - esp/batch: 'seq' idempotente por época (esp_uplink_ids) e
+ *               'dt' com o horário do ESP para os registros da fila offline
+ * @version 2.8 - esp/batch: estado, controle, heartbeat, leituras e iSpindel
+ *               num POST só, numa transação, com cleanup único por tabela
  * @version 2.7 - Fix pausedAtEpoch em esp/active e active (frontend)
  *               Bug: $row['paused_at'] → $config['paused_at'] (variável errada)
  *               Bug: paused_at ausente no SELECT de esp/active
@@ -45,6 +56,7 @@ $_SESSION['last_activity'] = time();
 
 require_once $_SERVER['DOCUMENT_ROOT'] . '/config/database.php';
 require_once __DIR__ . '/classes/DatabaseCleanup.php';
+require_once __DIR__ . '/classes/MsgPack.php';
 
 $alertSystemAvailable = false;
 try {
@@ -153,6 +165,20 @@ function decompressStateData(&$data) {
         foreach ($csMap as $short => $long) { if (isset($cs[$short])) { $cs[$long] = $cs[$short]; unset($cs[$short]); } }
         if (isset($cs['state']) && is_string($cs['state']) && isset($messageMap[$cs['state']])) $cs['state'] = $messageMap[$cs['state']];
     }
+
+    // Formato longo (firmware em MessagePack não comprime): chega aos mesmos
+    // valores que o formato comprimido expandido acima
+    if (isset($data['timeRemaining']) && is_array($data['timeRemaining'])) {
+        $trs = &$data['timeRemaining'];
+        if (isset($trs['status']) && is_string($trs['status']) && isset($statusMap[$trs['status']])) $trs['status'] = $statusMap[$trs['status']];
+        unset($trs);
+        $data['targetReached'] = true; // como o 'tr' em lista
+    }
+    if (isset($data['control_status']['state']) && is_string($data['control_status']['state'])) {
+        foreach (['Cooling' => 'Resfriando', 'Heating' => 'Aquecendo', 'Waiting' => 'Aguardando', 'Idle' => 'Ocioso'] as $en => $pt) {
+            if (strpos($data['control_status']['state'], $en) !== false) { $data['control_status']['state'] = $pt; break; }
+        }
+    }
 }
 
 function requireAuth() {
@@ -188,6 +214,24 @@ function sendResponse($data, $code = 200, $options = 0) {
     exit;
 }
 
+// Resposta com ETag (hash do corpo): se o ESP mandar o mesmo ETag em
+// If-None-Match, volta 304 sem corpo e ele não precisa ler nada
+function sendCachedResponse($data) {
+    $body = json_encode($data);
+    $etag = '"' . substr(md5($body), 0, 16) . '"';
+
+    header('ETag: ' . $etag);
+    header('Cache-Control: no-cache');
+
+    if (($_SERVER['HTTP_IF_NONE_MATCH'] ?? '') === $etag) {
+        http_response_code(304);
+        exit;
+    }
+
+    echo $body;
+    exit;
+}
+
 // ==================== FUNÇÕES DE ALERTA ====================
 
 function checkAlertsIfEnabled($pdo, $configId) {
@@ -220,11 +264,152 @@ function triggerGravityReachedAlert($pdo, $configId, $currentGravity, $targetGra
     catch (Exception $e) { error_log("[API] ❌ Erro alerta gravidade: " . $e->getMessage()); }
 }
 
+// ==================== GRAVAÇÃO DOS REGISTROS DO ESP ====================
+// Usadas pelos endpoints individuais e pelo esp/batch. Lançam
+// InvalidArgumentException para dados incompletos e não fazem cleanup
+// (quem chama decide quando, fora da transação do lote).
+
+// Registros que passaram pela fila offline do ESP trazem 'dt' (epoch do
+// instante em que foram gerados) e 'seq' (número único do registro).
+function deviceEpoch($input) {
+    $dt = isset($input['dt']) ? (int)$input['dt'] : 0;
+    return $dt > 1577836800 ? $dt : null; // antes de 2020: relógio sem sync
+}
+
+// (época, seq): a época é sorteada pelo ESP quando o contador nasce; se o
+// contador zerar, a época muda e os números novos não colidem com os antigos.
+function ensureSequenceTable($pdo) {
+    $pdo->exec("
+        CREATE TABLE IF NOT EXISTS esp_uplink_ids (
+            epoch INT UNSIGNED NOT NULL,
+            seq INT UNSIGNED NOT NULL,
+            received_at TIMESTAMP DEFAULT CURRENT_TIMESTAMP,
+            PRIMARY KEY (epoch, seq),
+            INDEX idx_received (received_at)
+        )
+    ");
+}
+
+// "seq" no corpo do lote: a época das sequências dos registros
+function sequenceEpoch($input) {
+    return isset($input['seq']) ? (int)$input['seq'] : 0;
+}
+
+// true se o registro é novo (ou não tem 'seq'); false se já foi gravado
+function claimSequence($pdo, $input, $epoch) {
+    if (!isset($input['seq'])) return true;
+    $stmt = $pdo->prepare("INSERT IGNORE INTO esp_uplink_ids (epoch, seq) VALUES (?, ?)"); $stmt->execute([$epoch, (int)$input['seq']]);
+    return $stmt->rowCount() > 0;
+}
+
+function saveReadingRecord($pdo, $input) {
+    $configId      = $input['config_id']      ?? $input['cid'] ?? null;
+    $tempFridge    = $input['temp_fridge']    ?? $input['tf']  ?? null;
+    $tempFermenter = $input['temp_fermenter'] ?? $input['tb']  ?? null;
+    $tempTarget    = $input['temp_target']    ?? $input['tt']  ?? null;
+    if ($tempFridge === null || $tempFermenter === null || $tempTarget === null) throw new InvalidArgumentException('Dados incompletos: temperaturas obrigatórias');
+    if (!$configId) {
+        $stmt = $pdo->prepare("SELECT id FROM configurations WHERE status = 'active' ORDER BY started_at DESC LIMIT 1"); $stmt->execute(); $ac = $stmt->fetch();
+        $configId = $ac ? $ac['id'] : null;
+        if (!$configId) error_log("[API] Salvando leitura sem fermentação ativa");
+    }
+    $stmt = $pdo->prepare("INSERT INTO readings (config_id, temp_fridge, temp_fermenter, temp_target, reading_timestamp) VALUES (?, ?, ?, ?, COALESCE(FROM_UNIXTIME(?), NOW()))"); $stmt->execute([$configId, $tempFridge, $tempFermenter, $tempTarget, deviceEpoch($input)]); $readingId = $pdo->lastInsertId();
+    error_log(sprintf("[API] ✅ Leitura salva: ID=%d, Config=%s, Ferm=%.1f, Fridge=%.1f, Target=%.1f", $readingId, $configId ?? 'null', $tempFermenter, $tempFridge, $tempTarget));
+    return ['config_id' => $configId, 'reading_id' => $readingId];
+}
+
+function saveIspindelRecord($pdo, $input) {
+    $name = $input['name'] ?? 'iSpindel'; $temperature = $input['temperature'] ?? null; $gravity = $input['gravity'] ?? null; $battery = $input['battery'] ?? null; $configIdFromEsp = $input['config_id'] ?? null;
+    if ($temperature === null || $gravity === null) throw new InvalidArgumentException('temperature and gravity are required');
+    $configId = null;
+    if ($configIdFromEsp) { $stmt = $pdo->prepare("SELECT id FROM configurations WHERE id = ? AND status = 'active'"); $stmt->execute([$configIdFromEsp]); if ($stmt->fetch()) $configId = $configIdFromEsp; }
+    if (!$configId) { $stmt = $pdo->prepare("SELECT c.id FROM configurations c WHERE c.status = 'active' LIMIT 1"); $stmt->execute(); $ac = $stmt->fetch(); $configId = $ac ? $ac['id'] : null; }
+    $stmt = $pdo->prepare("INSERT INTO ispindel_readings (config_id, name, temperature, gravity, battery, reading_timestamp) VALUES (?, ?, ?, ?, ?, COALESCE(FROM_UNIXTIME(?), NOW()))"); $stmt->execute([$configId, $name, $temperature, $gravity, $battery, deviceEpoch($input)]);
+    return ['config_id' => $configId];
+}
+
+function saveControlRecord($pdo, $input) {
+    $configId = $input['config_id'] ?? null; $setpoint = $input['setpoint'] ?? null; $cooling = $input['cooling'] ?? false; $heating = $input['heating'] ?? false;
+    if (!$configId || $setpoint === null) throw new InvalidArgumentException('Dados incompletos');
+    $pdo->prepare("INSERT INTO controller_states (config_id, setpoint, cooling, heating) VALUES (?, ?, ?, ?)")->execute([$configId, $setpoint, $cooling, $heating]);
+    return ['config_id' => $configId];
+}
+
+// Delta do ESP: só os campos que mudaram desde o estado 'base' (o 'seq' de
+// um estado já gravado); null remove o campo. Vira um estado completo, e
+// timestamp passa a ser a hora do servidor (o ESP só o manda nos keyframes).
+function mergeStateDelta($pdo, $configId, $delta) {
+    $base = (int)$delta['base']; unset($delta['base']);
+    $stmt = $pdo->prepare("SELECT state_data FROM fermentation_states WHERE config_id = ? ORDER BY id DESC LIMIT 20"); $stmt->execute([$configId]);
+    $snapshot = null;
+    while ($row = $stmt->fetch()) {
+        $data = json_decode($row['state_data'], true);
+        if (is_array($data) && (int)($data['seq'] ?? 0) === $base) { $snapshot = $data; break; }
+    }
+    if ($snapshot === null) throw new InvalidArgumentException("Estado base {$base} não encontrado; aguardando estado completo");
+    unset($snapshot['dt']); // horário do ESP vale só para o registro em que veio
+    foreach ($delta as $k => $v) { if ($v === null) unset($snapshot[$k]); else $snapshot[$k] = $v; }
+    if (!isset($delta['timestamp'])) $snapshot['timestamp'] = time();
+    return $snapshot;
+}
+
+function saveFermentationStateRecord($pdo, $input) {
+    $configId = $input['config_id'] ?? $input['cid'] ?? null;
+    if (!$configId) throw new InvalidArgumentException('config_id é obrigatório');
+    decompressStateData($input);
+    if (isset($input['base'])) $input = mergeStateDelta($pdo, $configId, $input);
+    $stageStartEpoch = null;
+    if      (isset($input['stageStartEpoch'])) $stageStartEpoch = (int)$input['stageStartEpoch'];
+    elseif  (isset($input['stageStart']))      $stageStartEpoch = (int)$input['stageStart'];
+    elseif  (isset($input['sst']))             $stageStartEpoch = (int)$input['sst'];
+    $targetReached = null;
+    if (isset($input['targetReached'])) { $targetReached = $input['targetReached'] ? 1 : 0; }
+    elseif (isset($input['tr'])) { if (is_bool($input['tr'])) $targetReached = $input['tr'] ? 1 : 0; elseif (is_array($input['tr'])) $targetReached = 1; }
+    error_log("[API] fermentation-state: configId={$configId}, stageStartEpoch=" . ($stageStartEpoch ?? 'NULL') . ", targetReached=" . ($targetReached ?? 'NULL'));
+    $deviceEpoch = deviceEpoch($input);
+    $pdo->prepare("INSERT INTO fermentation_states (config_id, state_data, stage_started_epoch, target_reached, state_timestamp) VALUES (?, ?, ?, ?, COALESCE(FROM_UNIXTIME(?), NOW()))")->execute([$configId, json_encode($input), $stageStartEpoch, $targetReached, $deviceEpoch]);
+    $stageIndex    = $input['currentStageIndex'] ?? $input['csi'] ?? null;
+    $MIN_VALID_EPOCH = 1577836800; // 2020-01-01
+
+    if ($stageIndex !== null && $stageStartEpoch && $stageStartEpoch > $MIN_VALID_EPOCH) {
+        $stmt = $pdo->prepare("
+            UPDATE stages
+            SET start_time = FROM_UNIXTIME(?)
+            WHERE config_id = ? AND stage_index = ?
+        ");
+        error_log("[API] fermentation-state: atualizando start_time (epoch={$stageStartEpoch}, targetReached=" . ($targetReached ? 'true' : 'false') . ")");
+        $stmt->execute([$stageStartEpoch, $configId, $stageIndex]);
+    } elseif ($stageStartEpoch !== null && $stageStartEpoch <= $MIN_VALID_EPOCH) {
+        error_log("[API] fermentation-state: ⚠️ epoch inválido ({$stageStartEpoch}) — start_time NÃO atualizado");
+    }
+
+    if ($targetReached && $stageIndex !== null) {
+        $pdo->prepare("UPDATE stages SET target_reached_time = COALESCE(target_reached_time, FROM_UNIXTIME(?), NOW()) WHERE config_id = ? AND stage_index = ?")->execute([$deviceEpoch, $configId, $stageIndex]);
+    }
+    return ['config_id' => $configId];
+}
+
+function saveHeartbeatRecord($pdo, $input) {
+    $configId = $input['config_id'] ?? $input['cid'] ?? null; $uptime = $input['uptime'] ?? $input['uptime_seconds'] ?? null;
+    $freeHeap = $input['free_heap'] ?? null; $controlStatus = $input['control_status'] ?? null;
+    $tempFermenter = $input['temp_fermenter'] ?? null; $tempFridge = $input['temp_fridge'] ?? null;
+    if (!$configId) throw new InvalidArgumentException('config_id é obrigatório');
+    if ($controlStatus && is_array($controlStatus)) decompressStateData($controlStatus);
+    $pdo->prepare("INSERT INTO esp_heartbeat (config_id, uptime_seconds, free_heap, temp_fermenter, temp_fridge, control_status) VALUES (?, ?, ?, ?, ?, ?)")->execute([$configId, $uptime, $freeHeap, $tempFermenter, $tempFridge, $controlStatus ? json_encode($controlStatus) : null]);
+    return ['config_id' => $configId];
+}
+
 // ==================== ROTEAMENTO ====================
 
 $method = $_SERVER['REQUEST_METHOD'];
 $path   = isset($_GET['path']) ? $_GET['path'] : '';
-$input  = json_decode(file_get_contents('php://input'), true);
+$rawInput = file_get_contents('php://input');
+if (stripos($_SERVER['CONTENT_TYPE'] ?? '', 'application/msgpack') === 0) {
+    try { $input = msgpackDecode($rawInput); }
+    catch (InvalidArgumentException $e) { sendResponse(['error' => 'MessagePack inválido: ' . $e->getMessage()], 400); }
+} else {
+    $input = json_decode($rawInput, true);
+}
 
 // ==================== AUTENTICAÇÃO ====================
 
@@ -361,9 +546,15 @@ if ($path === 'configurations/delete' && $method === 'DELETE') {
 if ($path === 'esp/active' && $method === 'GET') {
 
     // ✅ v2.7: paused_at incluído no SELECT
+    // v3.2: etapa atual no mesmo SELECT (LEFT JOIN), uma consulta por poll
     $stmt = $pdo->prepare("
-        SELECT c.id, c.name, c.status, c.current_stage_index, c.paused_at
+        SELECT c.id, c.name, c.status, c.current_stage_index, c.paused_at,
+               s.id                                  AS stage_id,
+               UNIX_TIMESTAMP(s.start_time)          AS stage_start_epoch,
+               s.target_reached_time IS NOT NULL     AS target_reached
         FROM configurations c
+        LEFT JOIN stages s
+               ON s.config_id = c.id AND s.stage_index = c.current_stage_index
         WHERE c.status IN ('active', 'paused')
         ORDER BY c.started_at DESC
         LIMIT 1
@@ -372,18 +563,9 @@ if ($path === 'esp/active' && $method === 'GET') {
     $config = $stmt->fetch();
 
     if ($config) {
-        $stmt = $pdo->prepare("
-            SELECT
-                UNIX_TIMESTAMP(start_time)           AS stage_start_epoch,
-                target_reached_time IS NOT NULL       AS target_reached
-            FROM stages
-            WHERE config_id = ? AND stage_index = ?
-            LIMIT 1
-        ");
-        $stmt->execute([$config['id'], $config['current_stage_index']]);
-        $stageRow = $stmt->fetch();
+        $hasStage = $config['stage_id'] !== null;
 
-        echo json_encode([
+        sendCachedResponse([
             'active'            => true,
             'paused'            => $config['status'] === 'paused',
             // ✅ v2.7: $config (antes era $row — variável inexistente)
@@ -391,17 +573,16 @@ if ($path === 'esp/active' && $method === 'GET') {
             'id'                => (string)$config['id'],
             'name'              => $config['name'],
             'currentStageIndex' => (int)$config['current_stage_index'],
-            'stageStartEpoch'   => $stageRow ? (int)$stageRow['stage_start_epoch'] : 0,
-            'targetReached'     => $stageRow ? (bool)$stageRow['target_reached']   : false,
+            'stageStartEpoch'   => $hasStage ? (int)$config['stage_start_epoch'] : 0,
+            'targetReached'     => $hasStage ? (bool)$config['target_reached']   : false,
         ]);
     } else {
-        echo json_encode([
+        sendCachedResponse([
             'active' => false,
             'paused' => false,
             'id'     => '',
         ]);
     }
-    exit;
 }
 
 // ==================== FERMENTAÇÃO ATIVA (frontend — requer autenticação) ====================
@@ -505,101 +686,119 @@ if ($path === 'state/complete' && $method === 'GET') {
 // ==================== LEITURAS ====================
 
 if ($path === 'readings' && $method === 'POST') {
-    $configId      = $input['config_id']      ?? $input['cid'] ?? null;
-    $tempFridge    = $input['temp_fridge']    ?? $input['tf']  ?? null;
-    $tempFermenter = $input['temp_fermenter'] ?? $input['tb']  ?? null;
-    $tempTarget    = $input['temp_target']    ?? $input['tt']  ?? null;
-    if ($tempFridge === null || $tempFermenter === null || $tempTarget === null) sendResponse(['error' => 'Dados incompletos: temperaturas obrigatórias'], 400);
     try {
-        if (!$configId) {
-            $stmt = $pdo->prepare("SELECT id FROM configurations WHERE status = 'active' ORDER BY started_at DESC LIMIT 1"); $stmt->execute(); $ac = $stmt->fetch();
-            $configId = $ac ? $ac['id'] : null;
-            if (!$configId) error_log("[API] Salvando leitura sem fermentação ativa");
-        }
-        $stmt = $pdo->prepare("INSERT INTO readings (config_id, temp_fridge, temp_fermenter, temp_target) VALUES (?, ?, ?, ?)"); $stmt->execute([$configId, $tempFridge, $tempFermenter, $tempTarget]); $readingId = $pdo->lastInsertId();
-        if ($configId) DatabaseCleanup::cleanupTable($pdo, 'readings', $configId);
-        error_log(sprintf("[API] ✅ Leitura salva: ID=%d, Config=%s, Ferm=%.1f, Fridge=%.1f, Target=%.1f", $readingId, $configId ?? 'null', $tempFermenter, $tempFridge, $tempTarget));
-        sendResponse(['success' => true, 'reading_id' => $readingId, 'config_id' => $configId], 201);
-    } catch (Exception $e) { error_log("[API] ❌ Erro ao salvar leitura: " . $e->getMessage()); sendResponse(['error' => 'Erro ao salvar leitura: ' . $e->getMessage()], 500); }
+        $r = saveReadingRecord($pdo, $input ?? []);
+        if ($r['config_id']) DatabaseCleanup::cleanupTable($pdo, 'readings', $r['config_id']);
+        sendResponse(['success' => true, 'reading_id' => $r['reading_id'], 'config_id' => $r['config_id']], 201);
+    } catch (InvalidArgumentException $e) { sendResponse(['error' => $e->getMessage()], 400); }
+    catch (Exception $e) { error_log("[API] ❌ Erro ao salvar leitura: " . $e->getMessage()); sendResponse(['error' => 'Erro ao salvar leitura: ' . $e->getMessage()], 500); }
 }
 
 // ==================== ISPINDEL ====================
 
 if ($path === 'ispindel/data' && $method === 'POST') {
-    $name = $input['name'] ?? 'iSpindel'; $temperature = $input['temperature'] ?? null; $gravity = $input['gravity'] ?? null; $battery = $input['battery'] ?? null; $configIdFromEsp = $input['config_id'] ?? null;
-    if ($temperature === null || $gravity === null) sendResponse(['error' => 'temperature and gravity are required'], 400);
     try {
-        $configId = null;
-        if ($configIdFromEsp) { $stmt = $pdo->prepare("SELECT id FROM configurations WHERE id = ? AND status = 'active'"); $stmt->execute([$configIdFromEsp]); if ($stmt->fetch()) $configId = $configIdFromEsp; }
-        if (!$configId) { $stmt = $pdo->prepare("SELECT c.id FROM configurations c WHERE c.status = 'active' LIMIT 1"); $stmt->execute(); $ac = $stmt->fetch(); $configId = $ac ? $ac['id'] : null; }
-        $stmt = $pdo->prepare("INSERT INTO ispindel_readings (config_id, name, temperature, gravity, battery) VALUES (?, ?, ?, ?, ?)"); $stmt->execute([$configId, $name, $temperature, $gravity, $battery]);
-        if ($configId) DatabaseCleanup::cleanupTable($pdo, 'ispindel_readings', $configId);
-        sendResponse(['success' => true, 'message' => 'iSpindel data saved', 'config_id' => $configId], 201);
-    } catch (Exception $e) { sendResponse(['error' => 'Error saving iSpindel data: ' . $e->getMessage()], 500); }
+        $r = saveIspindelRecord($pdo, $input ?? []);
+        if ($r['config_id']) DatabaseCleanup::cleanupTable($pdo, 'ispindel_readings', $r['config_id']);
+        sendResponse(['success' => true, 'message' => 'iSpindel data saved', 'config_id' => $r['config_id']], 201);
+    } catch (InvalidArgumentException $e) { sendResponse(['error' => $e->getMessage()], 400); }
+    catch (Exception $e) { sendResponse(['error' => 'Error saving iSpindel data: ' . $e->getMessage()], 500); }
 }
 
 // ==================== CONTROLE ====================
 
 if ($path === 'control' && $method === 'POST') {
-    $configId = $input['config_id'] ?? null; $setpoint = $input['setpoint'] ?? null; $cooling = $input['cooling'] ?? false; $heating = $input['heating'] ?? false;
-    if (!$configId || $setpoint === null) sendResponse(['error' => 'Dados incompletos'], 400);
-    $pdo->prepare("INSERT INTO controller_states (config_id, setpoint, cooling, heating) VALUES (?, ?, ?, ?)")->execute([$configId, $setpoint, $cooling, $heating]);
-    DatabaseCleanup::cleanupTable($pdo, 'controller_states', $configId);
+    try { $r = saveControlRecord($pdo, $input ?? []); }
+    catch (InvalidArgumentException $e) { sendResponse(['error' => $e->getMessage()], 400); }
+    DatabaseCleanup::cleanupTable($pdo, 'controller_states', $r['config_id']);
     sendResponse(['success' => true], 201);
 }
 
 // ==================== ESTADO FERMENTAÇÃO ====================
 
 if ($path === 'fermentation-state' && $method === 'POST') {
-    $configId = $input['config_id'] ?? $input['cid'] ?? null;
-    if (!$configId) sendResponse(['error' => 'config_id é obrigatório'], 400);
-    decompressStateData($input);
-    $stageStartEpoch = null;
-    if      (isset($input['stageStartEpoch'])) $stageStartEpoch = (int)$input['stageStartEpoch'];
-    elseif  (isset($input['stageStart']))      $stageStartEpoch = (int)$input['stageStart'];
-    elseif  (isset($input['sst']))             $stageStartEpoch = (int)$input['sst'];
-    $targetReached = null;
-    if (isset($input['targetReached'])) { $targetReached = $input['targetReached'] ? 1 : 0; }
-    elseif (isset($input['tr'])) { if (is_bool($input['tr'])) $targetReached = $input['tr'] ? 1 : 0; elseif (is_array($input['tr'])) $targetReached = 1; }
-    error_log("[API] fermentation-state: configId={$configId}, stageStartEpoch=" . ($stageStartEpoch ?? 'NULL') . ", targetReached=" . ($targetReached ?? 'NULL'));
-    $pdo->prepare("INSERT INTO fermentation_states (config_id, state_data, stage_started_epoch, target_reached) VALUES (?, ?, ?, ?)")->execute([$configId, json_encode($input), $stageStartEpoch, $targetReached]);
-    $stageIndex    = $input['currentStageIndex'] ?? $input['csi'] ?? null;
-    $MIN_VALID_EPOCH = 1577836800; // 2020-01-01
-
-    if ($stageIndex !== null && $stageStartEpoch && $stageStartEpoch > $MIN_VALID_EPOCH) {
-        $stmt = $pdo->prepare("
-            UPDATE stages
-            SET start_time = FROM_UNIXTIME(?)
-            WHERE config_id = ? AND stage_index = ?
-        ");
-        error_log("[API] fermentation-state: atualizando start_time (epoch={$stageStartEpoch}, targetReached=" . ($targetReached ? 'true' : 'false') . ")");
-        $stmt->execute([$stageStartEpoch, $configId, $stageIndex]);
-    } elseif ($stageStartEpoch !== null && $stageStartEpoch <= $MIN_VALID_EPOCH) {
-        error_log("[API] fermentation-state: ⚠️ epoch inválido ({$stageStartEpoch}) — start_time NÃO atualizado");
-    }
-
-    if ($targetReached && $stageIndex !== null) {
-        $pdo->prepare("UPDATE stages SET target_reached_time = COALESCE(target_reached_time, NOW()) WHERE config_id = ? AND stage_index = ?")->execute([$configId, $stageIndex]);
-    }
-    DatabaseCleanup::cleanupTable($pdo, 'fermentation_states', $configId);
+    try { $r = saveFermentationStateRecord($pdo, $input ?? []); }
+    catch (InvalidArgumentException $e) { sendResponse(['error' => $e->getMessage()], 400); }
+    DatabaseCleanup::cleanupTable($pdo, 'fermentation_states', $r['config_id']);
     sendResponse(['success' => true], 201);
 }
 
 // ==================== HEARTBEAT ====================
 
 if ($path === 'heartbeat' && $method === 'POST') {
-    $configId = $input['config_id'] ?? $input['cid'] ?? null; $uptime = $input['uptime'] ?? $input['uptime_seconds'] ?? null;
-    $freeHeap = $input['free_heap'] ?? null; $controlStatus = $input['control_status'] ?? null;
-    $tempFermenter = $input['temp_fermenter'] ?? null; $tempFridge = $input['temp_fridge'] ?? null;
-    if (!$configId) sendResponse(['error' => 'config_id é obrigatório'], 400);
     try {
-        if ($controlStatus && is_array($controlStatus)) decompressStateData($controlStatus);
-        $pdo->prepare("INSERT INTO esp_heartbeat (config_id, uptime_seconds, free_heap, temp_fermenter, temp_fridge, control_status) VALUES (?, ?, ?, ?, ?, ?)")->execute([$configId, $uptime, $freeHeap, $tempFermenter, $tempFridge, $controlStatus ? json_encode($controlStatus) : null]);
-        DatabaseCleanup::cleanupTable($pdo, 'esp_heartbeat', $configId);
+        $r = saveHeartbeatRecord($pdo, $input ?? []);
+        DatabaseCleanup::cleanupTable($pdo, 'esp_heartbeat', $r['config_id']);
         if (rand(1, 20) === 1) DatabaseCleanup::cleanupOrphans($pdo);
-        checkAlertsIfEnabled($pdo, $configId);
+        checkAlertsIfEnabled($pdo, $r['config_id']);
         sendResponse(['success' => true], 201);
-    } catch (Exception $e) { sendResponse(['error' => 'Error saving heartbeat: ' . $e->getMessage()], 500); }
+    } catch (InvalidArgumentException $e) { sendResponse(['error' => $e->getMessage()], 400); }
+    catch (Exception $e) { sendResponse(['error' => 'Error saving heartbeat: ' . $e->getMessage()], 500); }
+}
+
+// ==================== LOTE DO ESP ====================
+// Um POST por ciclo com as seções devidas, cada uma com um registro ou
+// uma lista: {"state":{...}, "control":{...}, "heartbeat":{...},
+// "readings":[{...}], "ispindel":[{...}]}. Gravação numa transação só;
+// registro inválido é pulado e volta em "errors". Cleanup uma vez por
+// tabela e fermentação, depois do commit. Com "seq" (a época), leituras e
+// iSpindel trazem 'seq' por registro; época + 'seq' repetidos (reenvio da
+// fila offline após queda ou reboot) contam em "duplicates" e não gravam de
+// novo.
+// "acked" lista, por seção, os 'seq' gravados neste lote: o lote sai 201
+// mesmo com registro em "errors", e o ESP só toma o estado como base de
+// delta se o 'seq' dele estiver em acked.state.
+
+if ($path === 'esp/batch' && $method === 'POST') {
+    if (!is_array($input)) sendResponse(['error' => 'JSON inválido'], 400);
+    $sections = [
+        'state'     => ['saveFermentationStateRecord', 'fermentation_states'],
+        'control'   => ['saveControlRecord',           'controller_states'],
+        'heartbeat' => ['saveHeartbeatRecord',         'esp_heartbeat'],
+        'readings'  => ['saveReadingRecord',           'readings'],
+        'ispindel'  => ['saveIspindelRecord',          'ispindel_readings'],
+    ];
+    $saved = []; $acked = []; $errors = []; $duplicates = []; $cleanup = []; $heartbeatConfigId = null;
+    $seqEpoch = sequenceEpoch($input);
+    try {
+        if (!empty($input['seq'])) ensureSequenceTable($pdo); // DDL fora da transação
+        $pdo->beginTransaction();
+        foreach ($sections as $section => [$saveFn, $table]) {
+            if (!isset($input[$section])) continue;
+            $records = $input[$section];
+            if (!is_array($records)) { $errors[$section] = 'Formato inválido'; continue; }
+            if (empty($records)) continue;
+            if (array_keys($records) !== range(0, count($records) - 1)) $records = [$records]; // registro único
+            foreach ($records as $record) {
+                if (!is_array($record)) $record = [];
+                $pdo->exec("SAVEPOINT batch_record"); // registro inválido desfaz o seq reservado e o que já gravou
+                try {
+                    if (!claimSequence($pdo, $record, $seqEpoch)) { $duplicates[$section] = ($duplicates[$section] ?? 0) + 1; continue; }
+                    $r = $saveFn($pdo, $record);
+                    $saved[$section] = ($saved[$section] ?? 0) + 1;
+                    if (isset($record['seq'])) $acked[$section][] = (int)$record['seq'];
+                    if ($r['config_id']) $cleanup[$table][$r['config_id']] = true;
+                    if ($section === 'heartbeat') $heartbeatConfigId = $r['config_id'];
+                } catch (InvalidArgumentException $e) { $pdo->exec("ROLLBACK TO SAVEPOINT batch_record"); $errors[$section] = $e->getMessage(); }
+            }
+        }
+        $pdo->commit();
+    } catch (Exception $e) {
+        if ($pdo->inTransaction()) $pdo->rollBack();
+        error_log("[API] ❌ Erro ao salvar lote: " . $e->getMessage());
+        sendResponse(['error' => 'Erro ao salvar lote: ' . $e->getMessage()], 500);
+    }
+    foreach ($cleanup as $table => $configIds) foreach (array_keys($configIds) as $cid) DatabaseCleanup::cleanupTable($pdo, $table, $cid);
+    if ($heartbeatConfigId) {
+        if (rand(1, 20) === 1) DatabaseCleanup::cleanupOrphans($pdo);
+        checkAlertsIfEnabled($pdo, $heartbeatConfigId);
+    }
+    if (!empty($input['seq']) && rand(1, 20) === 1) {
+        try { $pdo->exec("DELETE FROM esp_uplink_ids WHERE received_at < DATE_SUB(NOW(), INTERVAL 30 DAY)"); }
+        catch (PDOException $e) { error_log("[API] Erro ao limpar esp_uplink_ids: " . $e->getMessage()); }
+    }
+    if (empty($saved) && empty($duplicates) && !empty($errors)) sendResponse(['error' => 'Nenhum registro válido', 'errors' => $errors], 400);
+    sendResponse(['success' => true, 'saved' => (object)$saved, 'duplicates' => (object)$duplicates, 'errors' => (object)$errors, 'acked' => (object)$acked], 201);
 }
 
 // ==================== COMANDOS ESP ====================
@@ -75,6 +75,54 @@ try {
         'stages' => []
     ];
     
+    // Perfis de sintonia do controle por etapa (tabela control_profiles).
+    // Bancos sem a migração continuam recebendo a config sem perfis.
+    $stageProfiles = [];
+    try {
+        $stmt = $pdo->prepare("
+            SELECT stage_index, tuning_profile_id
+            FROM stages
+            WHERE config_id = ? AND tuning_profile_id IS NOT NULL
+        ");
+        $stmt->execute([$configId]);
+        foreach ($stmt->fetchAll(PDO::FETCH_ASSOC) as $row) {
+            $stageProfiles[(int)$row['stage_index']] = (int)$row['tuning_profile_id'];
+        }
+
+        if (!empty($stageProfiles)) {
+            $ids = array_values(array_unique($stageProfiles));
+            $placeholders = implode(',', array_fill(0, count($ids), '?'));
+            $stmt = $pdo->prepare("
+                SELECT id, kp, ki, kd, idle_range_high, idle_range_low, pid_max,
+                       temp_setting_min, min_cool_time, min_cool_idle_time,
+                       min_heat_time, min_heat_idle_time
+                FROM control_profiles
+                WHERE id IN ($placeholders)
+            ");
+            $stmt->execute($ids);
+
+            // Só campos preenchidos: NULL = ESP mantém o padrão do firmware
+            $fields = [
+                'kp' => 'Kp', 'ki' => 'Ki', 'kd' => 'Kd',
+                'idle_range_high' => 'idleRangeHigh', 'idle_range_low' => 'idleRangeLow',
+                'pid_max' => 'pidMax', 'temp_setting_min' => 'tempSettingMin',
+                'min_cool_time' => 'minCoolTime', 'min_cool_idle_time' => 'minCoolIdleTime',
+                'min_heat_time' => 'minHeatTime', 'min_heat_idle_time' => 'minHeatIdleTime'
+            ];
+            foreach ($stmt->fetchAll(PDO::FETCH_ASSOC) as $profile) {
+                $entry = ['id' => (int)$profile['id']];
+                foreach ($fields as $column => $key) {
+                    if ($profile[$column] !== null) {
+                        $entry[$key] = (float)$profile[$column];
+                    }
+                }
+                $response['tuningProfiles'][] = $entry;
+            }
+        }
+    } catch (PDOException $e) {
+        $stageProfiles = [];
+    }
+
     foreach ($stages as $stage) {
         $response['stages'][] = [
             'type' => $stage['type'],
@@ -84,11 +132,24 @@ try {
             'rampTime' => (int)$stage['ramp_time'],
             'targetGravity' => (float)$stage['target_gravity'],
             'timeoutDays' => (float)$stage['timeout_days'],
+            'tuningProfile' => $stageProfiles[(int)$stage['stage_index']] ?? 0,
             'status' => $stage['status']
         ];
     }
     
-    echo json_encode($response);
+    // ETag: hash do ID com o corpo. Se o ESP mandar o mesmo ETag em
+    // If-None-Match, a configuração não mudou: 304 sem corpo
+    $body = json_encode($response);
+    $etag = '"' . substr(md5($configId . '|' . $body), 0, 16) . '"';
+    header('ETag: ' . $etag);
+    header('Cache-Control: no-cache');
+
+    if (($_SERVER['HTTP_IF_NONE_MATCH'] ?? '') === $etag) {
+        http_response_code(304);
+        exit;
+    }
+
+    echo $body;
     
 } catch (PDOException $e) {
     http_response_code(500);
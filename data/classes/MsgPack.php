@@ -0,0 +1,70 @@
+<?php
+// classes/MsgPack.php
+//
+// Também usado por tools/uplink_check, fora do servidor
+
+// Decodificador MessagePack (corpo "application/msgpack" do ESP). Usa a
+// extensão msgpack se instalada; senão, decodifica aqui. Mapas viram arrays
+// associativos, como no json_decode(..., true).
+function msgpackDecode($bytes) {
+    if (function_exists('msgpack_unpack')) return msgpack_unpack($bytes);
+    return msgpackDecodePhp($bytes);
+}
+
+// Só o decodificador em PHP (sem a extensão); exige consumir todos os bytes
+function msgpackDecodePhp($bytes) {
+    $pos = 0;
+    $value = msgpackRead($bytes, $pos);
+    if ($pos !== strlen($bytes)) throw new InvalidArgumentException('MessagePack com bytes sobrando');
+    return $value;
+}
+
+function msgpackTake($bytes, &$pos, $len) {
+    if ($pos + $len > strlen($bytes)) throw new InvalidArgumentException('MessagePack truncado');
+    $chunk = substr($bytes, $pos, $len); $pos += $len;
+    return $chunk;
+}
+
+function msgpackRead($bytes, &$pos) {
+    $b = ord(msgpackTake($bytes, $pos, 1));
+    if ($b <= 0x7f) return $b;                                           // positive fixint
+    if ($b >= 0xe0) return $b - 0x100;                                   // negative fixint
+    if (($b & 0xf0) === 0x80) return msgpackMap($bytes, $pos, $b & 0x0f);
+    if (($b & 0xf0) === 0x90) return msgpackArray($bytes, $pos, $b & 0x0f);
+    if (($b & 0xe0) === 0xa0) return msgpackTake($bytes, $pos, $b & 0x1f);
+    switch ($b) {
+        case 0xc0: return null;
+        case 0xc2: return false;
+        case 0xc3: return true;
+        case 0xc4: case 0xd9: return msgpackTake($bytes, $pos, ord(msgpackTake($bytes, $pos, 1)));
+        case 0xc5: case 0xda: return msgpackTake($bytes, $pos, unpack('n', msgpackTake($bytes, $pos, 2))[1]);
+        case 0xc6: case 0xdb: return msgpackTake($bytes, $pos, unpack('N', msgpackTake($bytes, $pos, 4))[1]);
+        case 0xca: return (float)sprintf('%.7g', unpack('G', msgpackTake($bytes, $pos, 4))[1]); // float32 sem ruído
+        case 0xcb: return unpack('E', msgpackTake($bytes, $pos, 8))[1];
+        case 0xcc: return ord(msgpackTake($bytes, $pos, 1));
+        case 0xcd: return unpack('n', msgpackTake($bytes, $pos, 2))[1];
+        case 0xce: return unpack('N', msgpackTake($bytes, $pos, 4))[1];
+        case 0xcf: return unpack('J', msgpackTake($bytes, $pos, 8))[1];
+        case 0xd0: return unpack('c', msgpackTake($bytes, $pos, 1))[1];
+        case 0xd1: $v = unpack('n', msgpackTake($bytes, $pos, 2))[1]; return $v >= 0x8000 ? $v - 0x10000 : $v;
+        case 0xd2: $v = unpack('N', msgpackTake($bytes, $pos, 4))[1]; return $v >= 0x80000000 ? $v - 0x100000000 : $v;
+        case 0xd3: return unpack('J', msgpackTake($bytes, $pos, 8))[1]; // PHP 64 bits: já com sinal
+        case 0xdc: return msgpackArray($bytes, $pos, unpack('n', msgpackTake($bytes, $pos, 2))[1]);
+        case 0xdd: return msgpackArray($bytes, $pos, unpack('N', msgpackTake($bytes, $pos, 4))[1]);
+        case 0xde: return msgpackMap($bytes, $pos, unpack('n', msgpackTake($bytes, $pos, 2))[1]);
+        case 0xdf: return msgpackMap($bytes, $pos, unpack('N', msgpackTake($bytes, $pos, 4))[1]);
+    }
+    throw new InvalidArgumentException(sprintf('MessagePack: tipo 0x%02x não suportado', $b));
+}
+
+function msgpackArray($bytes, &$pos, $n) {
+    $out = [];
+    for ($i = 0; $i < $n; $i++) $out[] = msgpackRead($bytes, $pos);
+    return $out;
+}
+
+function msgpackMap($bytes, &$pos, $n) {
+    $out = [];
+    for ($i = 0; $i < $n; $i++) { $k = msgpackRead($bytes, $pos); $out[$k] = msgpackRead($bytes, $pos); }
+    return $out;
+}
@@ -1,5 +1,6 @@
 // BrewPiTempControl.cpp
 #include "BrewPiTempControl.h"
+#include "BrewPiTrace.h"
 #include "globais.h"
 #include "debug_config.h"
 
@@ -23,6 +24,12 @@ BrewPiTempControl::BrewPiTempControl()
     , lastCoolTime(0)
     , waitTime(0)
     , storedBeerSetting(INVALID_TEMP)
+    , beerLoopPrimed(false)
+    , beerLoopRan(false)
+    , lastBeerLoop(0)
+    , lastIntegralUpdate(0)
+    , heaterDuty(0)
+    , gravityDropRate(0)
 {
     loadDefaultConstants();
     loadDefaultSettings();
@@ -37,7 +44,7 @@ void BrewPiTempControl::init() {
     lastCoolTime = 0;
     
     updateTemperatures();
-    reset();
+    resetPeakDetect();
     
     #if DEBUG_BREWPI
     Serial.println(F("[BrewPi] ✅ Sistema inicializado"));
@@ -45,6 +52,16 @@ void BrewPiTempControl::init() {
 }
 
 void BrewPiTempControl::reset() {
+    // Apenas resets externos vão para o trace; os internos (setBeerTemp,
+    // setFridgeTemp) são reproduzidos pela própria chamada do setter
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordReset(ticks.millis());
+    }
+    
+    resetPeakDetect();
+}
+
+void BrewPiTempControl::resetPeakDetect() {
     doPosPeakDetect = false;
     doNegPeakDetect = false;
     
@@ -65,6 +82,11 @@ void BrewPiTempControl::setSensors(DallasTemperature* sensors, uint8_t beerIdx,
     
     initFilters();
     
+    // Sensores recriados: o trace precisa de um novo ponto de partida
+    if (brewPiTrace.isRecording()) {
+        traceSnapshot();
+    }
+    
     #if DEBUG_BREWPI
     Serial.println(F("[BrewPi] 📡 Sensores configurados"));
     #endif
@@ -102,10 +124,12 @@ void BrewPiTempControl::initFilters() {
     fridgeSensor->setFastFilterCoefficients(cc.fridgeFastFilter);
     fridgeSensor->setSlowFilterCoefficients(cc.fridgeSlowFilter);
     fridgeSensor->setSlopeFilterCoefficients(cc.fridgeSlopeFilter);
+    fridgeSensor->setSlopeWindow(cc.fridgeSlopeWindow);
     
     beerSensor->setFastFilterCoefficients(cc.beerFastFilter);
     beerSensor->setSlowFilterCoefficients(cc.beerSlowFilter);
     beerSensor->setSlopeFilterCoefficients(cc.beerSlopeFilter);
+    beerSensor->setSlopeWindow(cc.beerSlopeWindow);
     
     #if DEBUG_BREWPI
     Serial.println(F("[BrewPi] 🔧 Filtros inicializados"));
@@ -136,8 +160,6 @@ void BrewPiTempControl::updateTemperatures() {
 // ========================================
 
 void BrewPiTempControl::updatePID() {
-    static uint8_t integralUpdateCounter = 0;
-    
     if (modeIsBeer()) {
         if (cs.beerSetting == INVALID_TEMP) {
             cs.fridgeSetting = INVALID_TEMP;
@@ -149,9 +171,11 @@ void BrewPiTempControl::updatePID() {
         cv.beerSlope = beerSensor->readSlope();
         temperature fridgeFastFiltered = fridgeSensor->readFastFiltered();
         
-        // Atualiza integral a cada 60 ciclos
-        if (integralUpdateCounter++ == 60) {
-            integralUpdateCounter = 0;
+        // Atualiza integral por tempo de relógio: o ganho Ki vale por
+        // cc.integralPeriod, não por número de chamadas
+        ticks_millis_t now = ticks.millis();
+        if (now - lastIntegralUpdate >= (ticks_millis_t)cc.integralPeriod * 1000UL) {
+            lastIntegralUpdate = now;
             
             temperature integratorUpdate = cv.beerDiff;
             
@@ -206,6 +230,17 @@ void BrewPiTempControl::updatePID() {
         newFridgeSetting += cv.i;
         newFridgeSetting += cv.d;
         
+        // Feed-forward: pré-resfria proporcional à atividade da levedura,
+        // antes que o calor gerado apareça como erro na cerveja. Não atua
+        // com a cerveja já abaixo do setpoint para não ampliar o undershoot.
+        cv.ff = 0;
+        if (gravityDropRate > 0 && cv.beerDiff < intToTempDiff(1)/2) {
+            long_temperature ff = ((long_temperature)cc.exothermGain * gravityDropRate) / 10;
+            if (ff > cc.exothermMax) ff = cc.exothermMax;
+            cv.ff = -(temperature)ff;
+        }
+        newFridgeSetting += cv.ff;
+        
         // Limites dinâmicos
         temperature lowerBound = (cs.beerSetting <= cc.tempSettingMin + cc.pidMax) ? 
                                   cc.tempSettingMin : cs.beerSetting - cc.pidMax;
@@ -227,6 +262,8 @@ void BrewPiTempControl::updatePID() {
             Serial.printf("P: %.3f, I: %.3f, D: %.3f\n", 
                          tempToFloat(cv.p), tempToFloat(cv.i), tempToFloat(cv.d));
             Serial.printf("Integral: %.3f\n", tempToFloat((temperature)cv.diffIntegral));
+            Serial.printf("FF: %.3f (queda %.1f pts/dia)\n",
+                         tempDiffToFloat(cv.ff), gravityDropRate / 10.0f);
             Serial.printf("Fridge Setting: %.2f°C\n", tempToFloat(cs.fridgeSetting));
             Serial.println(F("━━━━━━━━━━━━━━━━━━━━━━━━━━━\n"));
         }
@@ -308,6 +345,13 @@ void BrewPiTempControl::updateState() {
                     }
                 }
                 
+                // Aquecedor proporcional não passa pela máquina de estados:
+                // o duty é calculado em updateHeaterDuty()
+                if (heater && heaterIsPwm()) {
+                    state = IDLE;
+                    break;
+                }
+                
                 if (heater) {
                     state = (waitTime > 0) ? WAITING_TO_HEAT : HEATING;
                 }
@@ -501,6 +545,39 @@ void BrewPiTempControl::detectPeaks() {
     }
 }
 
+// ========================================
+// AQUECEDOR PROPORCIONAL NO TEMPO
+// ========================================
+// Converte o erro da geladeira (fridgeSetting calculado pelo PID da cerveja
+// menos a temperatura rápida da geladeira) em duty de 0-100% ao longo de
+// heaterPwmBand. Sem minHeatTime/minHeatIdleTime: o SSR resistivo não
+// precisa dessa proteção. O mutex com o compressor continua valendo.
+
+void BrewPiTempControl::updateHeaterDuty() {
+    heaterDuty = 0;
+    
+    if (!heater || !heaterIsPwm()) return;
+    if (cs.mode == MODE_OFF || cs.fridgeSetting == INVALID_TEMP) return;
+    if (!fridgeSensor->isConnected()) return;
+    if (modeIsBeer() && !beerSensor->isConnected()) return;
+    
+    // Nunca junto com o compressor (nem logo após ele)
+    if (stateIsCooling() || state == WAITING_TO_COOL) return;
+    if (timeSinceCooling() < cc.mutexDeadTime) return;
+    
+    // Cerveja já acima do alvo: não aquece
+    if (modeIsBeer() && beerSensor->readFastFiltered() > (cs.beerSetting + 16)) return;
+    
+    long_temperature error = (long_temperature)cs.fridgeSetting - fridgeSensor->readFastFiltered();
+    if (error <= 0 || cc.heaterPwmBand <= 0) return;
+    
+    long_temperature duty = (error * HEATER_PWM_DUTY_MAX) / cc.heaterPwmBand;
+    heaterDuty = (duty > HEATER_PWM_DUTY_MAX) ? HEATER_PWM_DUTY_MAX : (uint16_t)duty;
+    
+    // Mantém o mutex do compressor contando a partir do último pulso
+    lastHeatTime = ticks.seconds();
+}
+
 // ========================================
 // ATUALIZAÇÃO DE SAÍDAS
 // ========================================
@@ -517,7 +594,27 @@ void BrewPiTempControl::updateOutputs() {
     }
     
     if (heater) {
-        heater->estado = heating;
+        if (heaterIsPwm()) {
+            // Ticker do HeaterPwm comanda o relé entre os ticks do controle
+            heaterPwm.setDuty(heaterDuty, cc.heaterPwmPeriod);
+        } else {
+            heaterPwm.stop();
+            heater->estado = heating;
+            heater->atualizar();
+        }
+    }
+}
+
+void BrewPiTempControl::shutdownOutputs() {
+    heaterPwm.stop();
+    
+    if (cooler) {
+        cooler->estado = false;
+        cooler->atualizar();
+    }
+    
+    if (heater) {
+        heater->estado = false;
         heater->atualizar();
     }
 }
@@ -526,12 +623,45 @@ void BrewPiTempControl::updateOutputs() {
 // FUNÇÃO PRINCIPAL DE ATUALIZAÇÃO
 // ========================================
 
+bool BrewPiTempControl::beerLoopDue(ticks_millis_t now) const {
+    if (!beerLoopPrimed) return true;
+    return (now - lastBeerLoop) >= (ticks_millis_t)cc.beerLoopPeriod * 1000UL;
+}
+
 void BrewPiTempControl::update() {
+    ticks_millis_t now = ticks.millis();
+    
+    if (brewPiTrace.isRecording()) {
+        if (brewPiTrace.needsRotation() && brewPiTrace.rotate()) {
+            traceSnapshot();
+        }
+    }
+    
+    beerLoopRan = beerLoopDue(now);
+    
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordTick(now, beerLoopRan ? TRACE_TICK_BEER_LOOP : 0);
+    }
+    
+    // Amostras compartilhadas: as duas malhas leem os mesmos filtros
     updateTemperatures();
-    updatePID();
+    
+    // Malha lenta: PID da cerveja → fridgeSetting
+    if (beerLoopRan) {
+        beerLoopPrimed = true;
+        lastBeerLoop = now;
+        updatePID();
+    }
+    
+    // Malha rápida: geladeira segue o fridgeSetting vigente
     updateState();
+    updateHeaterDuty();
     detectPeaks();
     updateOutputs();
+    
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordOutput(state, stateIsCooling(), stateIsHeating(), heaterDuty);
+    }
 }
 
 // ========================================
@@ -561,12 +691,16 @@ temperature BrewPiTempControl::getFridgeSetting() const {
 // ========================================
 
 void BrewPiTempControl::setBeerTemp(temperature newTemp) {
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordBeerSetting(ticks.millis(), newTemp);
+    }
+    
     temperature oldBeerSetting = cs.beerSetting;
     cs.beerSetting = newTemp;
     
     // Reset se mudança significativa (>0.5°C)
     if (abs(oldBeerSetting - newTemp) > intToTempDiff(1)/2) {
-        reset();
+        resetPeakDetect();
     }
     
     updatePID();
@@ -579,8 +713,12 @@ void BrewPiTempControl::setBeerTemp(temperature newTemp) {
 }
 
 void BrewPiTempControl::setFridgeTemp(temperature newTemp) {
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordFridgeSetting(ticks.millis(), newTemp);
+    }
+    
     cs.fridgeSetting = newTemp;
-    reset();
+    resetPeakDetect();
     updatePID();
     updateState();
     
@@ -589,7 +727,31 @@ void BrewPiTempControl::setFridgeTemp(temperature newTemp) {
     #endif
 }
 
+void BrewPiTempControl::setConstants(const ControlConstants& newConstants) {
+    cc = newConstants;
+    
+    // Constantes não têm registro próprio: o replay as recebe num snapshot
+    if (brewPiTrace.isRecording()) {
+        traceSnapshot();
+    }
+}
+
+void BrewPiTempControl::setGravityDropRate(int16_t rate) {
+    if (rate < 0) rate = 0;
+    if (rate == gravityDropRate) return;
+    
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordFeedForward(ticks.millis(), rate);
+    }
+    
+    gravityDropRate = rate;
+}
+
 void BrewPiTempControl::setMode(char newMode, bool force) {
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordMode(ticks.millis(), newMode, force);
+    }
+    
     if (newMode != cs.mode || 
         state == WAITING_TO_HEAT || 
         state == WAITING_TO_COOL || 
@@ -612,6 +774,71 @@ void BrewPiTempControl::setMode(char newMode, bool force) {
     }
 }
 
+// ========================================
+// SNAPSHOT E TRACE
+// ========================================
+
+void BrewPiTempControl::saveSnapshot(ControlSnapshot& out) const {
+    memset(&out, 0, sizeof(out));
+    out.cc = cc;
+    out.cs = cs;
+    out.cv = cv;
+    out.state = state;
+    out.doPosPeakDetect = doPosPeakDetect ? 1 : 0;
+    out.doNegPeakDetect = doNegPeakDetect ? 1 : 0;
+    out.beerLoopPrimed = beerLoopPrimed ? 1 : 0;
+    out.lastBeerLoop = lastBeerLoop;
+    out.lastIntegralUpdate = lastIntegralUpdate;
+    out.lastIdleTime = lastIdleTime;
+    out.lastHeatTime = lastHeatTime;
+    out.lastCoolTime = lastCoolTime;
+    out.waitTime = waitTime;
+    out.storedBeerSetting = storedBeerSetting;
+    out.heaterDuty = heaterDuty;
+    out.gravityDropRate = gravityDropRate;
+    if (beerSensor) beerSensor->saveState(out.beer);
+    if (fridgeSensor) fridgeSensor->saveState(out.fridge);
+}
+
+void BrewPiTempControl::restoreSnapshot(const ControlSnapshot& in) {
+    cc = in.cc;
+    cs = in.cs;
+    cv = in.cv;
+    state = in.state;
+    doPosPeakDetect = in.doPosPeakDetect != 0;
+    doNegPeakDetect = in.doNegPeakDetect != 0;
+    beerLoopPrimed = in.beerLoopPrimed != 0;
+    lastBeerLoop = in.lastBeerLoop;
+    lastIntegralUpdate = in.lastIntegralUpdate;
+    lastIdleTime = in.lastIdleTime;
+    lastHeatTime = in.lastHeatTime;
+    lastCoolTime = in.lastCoolTime;
+    waitTime = in.waitTime;
+    storedBeerSetting = in.storedBeerSetting;
+    heaterDuty = in.heaterDuty;
+    gravityDropRate = in.gravityDropRate;
+    if (beerSensor) beerSensor->restoreState(in.beer);
+    if (fridgeSensor) fridgeSensor->restoreState(in.fridge);
+}
+
+void BrewPiTempControl::traceSnapshot() {
+    ControlSnapshot snap;
+    saveSnapshot(snap);
+    brewPiTrace.recordSnapshot(&snap, sizeof(snap));
+}
+
+bool BrewPiTempControl::startTrace() {
+    if (brewPiTrace.isRecording()) return true;
+    if (!brewPiTrace.begin()) return false;
+    
+    traceSnapshot();
+    return brewPiTrace.isRecording();
+}
+
+void BrewPiTempControl::stopTrace() {
+    brewPiTrace.end();
+}
+
 // ========================================
 // STATUS DETALHADO
 // ========================================
@@ -621,10 +848,12 @@ DetailedControlStatus BrewPiTempControl::getDetailedStatus() {
     
     // Estado dos atuadores
     status.coolerActive = stateIsCooling();
-    status.heaterActive = stateIsHeating();
+    status.heaterActive = stateIsHeating() || heaterDuty > 0;
+    status.heaterDuty = heaterDuty;
     
     // Pico estimado
     status.estimatedPeak = tempToFloat(cv.estimatedPeak);
+    status.feedForward = tempDiffToFloat(cv.ff);
     status.peakDetection = (doPosPeakDetect || doNegPeakDetect);
     
     // Estado da máquina
@@ -637,7 +866,7 @@ DetailedControlStatus BrewPiTempControl::getDetailedStatus() {
             status.stateName = "DESLIGADO";
             break;
         case IDLE:
-            status.stateName = "IDLE";
+            status.stateName = (heaterDuty > 0) ? "AQUECENDO" : "IDLE";
             break;
         case COOLING:
             status.stateName = "RESFRIANDO";
@@ -6,9 +6,37 @@
 #include "BrewPiStructs.h"
 #include "BrewPiTicks.h"
 #include "TempSensor.h"
+#include "HeaterPwm.h"
 #include "estruturas.h"  // Para Rele
 #include "controle_temperatura.h"  // Para DetailedControlStatus
 
+// ========================================
+// SNAPSHOT DO CONTROLE (TRACE / REPLAY)
+// ========================================
+// Estado completo necessário para reproduzir o controle a partir de um
+// ponto qualquer. Gravado no início de cada trecho do BrewPiTrace.
+
+struct ControlSnapshot {
+    ControlConstants cc;
+    ControlSettings cs;
+    ControlVariables cv;
+    uint8_t state;
+    uint8_t doPosPeakDetect;
+    uint8_t doNegPeakDetect;
+    uint8_t beerLoopPrimed;
+    ticks_millis_t lastBeerLoop;
+    ticks_millis_t lastIntegralUpdate;
+    ticks_seconds_t lastIdleTime;
+    ticks_seconds_t lastHeatTime;
+    ticks_seconds_t lastCoolTime;
+    uint16_t waitTime;
+    temperature storedBeerSetting;
+    uint16_t heaterDuty;
+    int16_t gravityDropRate;
+    TempSensorState beer;
+    TempSensorState fridge;
+};
+
 // ========================================
 // CLASSE DE CONTROLE DE TEMPERATURA
 // ========================================
@@ -24,8 +52,12 @@ public:
     // Reset do controle
     void reset();
     
-    // Ciclo principal de controle
+    // Ciclo principal de controle: chamar a cada getFridgeLoopMs(). A malha
+    // rápida (geladeira) roda em toda chamada; a malha lenta (PID da cerveja)
+    // só quando cc.beerLoopPeriod venceu.
     void update();
+    uint16_t getFridgeLoopMs() const { return cc.fridgeLoopMs; }
+    bool lastTickRanBeerLoop() const { return beerLoopRan; }
     
     // Configuração de sensores
     void setSensors(DallasTemperature* sensors, uint8_t beerIdx, uint8_t fridgeIdx);
@@ -33,6 +65,10 @@ public:
     // Configuração de atuadores
     void setActuators(Rele* cool, Rele* heat);
     
+    // Desliga cooler e aquecedor (antes de reiniciar); o próximo update()
+    // volta a comandar os relés pelo estado atual
+    void shutdownOutputs();
+    
     // Getters de temperatura
     temperature getBeerTemp() const;
     temperature getBeerSetting() const;
@@ -52,6 +88,12 @@ public:
     bool stateIsCooling() const { return (state == COOLING || state == COOLING_MIN_TIME); }
     bool stateIsHeating() const { return (state == HEATING || state == HEATING_MIN_TIME); }
     bool modeIsBeer() const { return (cs.mode == MODE_BEER_CONSTANT || cs.mode == MODE_BEER_PROFILE); }
+    bool heaterIsPwm() const { return cc.heaterPwm != 0; }
+    uint16_t getHeaterDuty() const { return heaterDuty; }
+    
+    // Feed-forward da exotermia: queda de gravidade em décimos de ponto/dia
+    void setGravityDropRate(int16_t rate);
+    int16_t getGravityDropRate() const { return gravityDropRate; }
     
     // Tempo de espera
     uint16_t getWaitTime() const { return waitTime; }
@@ -66,17 +108,30 @@ public:
     
     // Carrega constantes padrão
     void loadDefaultConstants();
+    
+    // Troca de constantes em operação (perfil de sintonia da etapa)
+    void setConstants(const ControlConstants& newConstants);
     void loadDefaultSettings();
     
+    // Snapshot e gravação de trace
+    void saveSnapshot(ControlSnapshot& out) const;
+    void restoreSnapshot(const ControlSnapshot& in);
+    bool startTrace();
+    void stopTrace();
+    
 private:
     // Funções internas
     void updateTemperatures();
     void updatePID();
+    bool beerLoopDue(ticks_millis_t now) const;
     void updateState();
+    void updateHeaterDuty();
     void updateOutputs();
     void detectPeaks();
     void updateEstimatedPeak(uint16_t timeLimit, temperature estimator, uint16_t sinceIdle);
     void initFilters();
+    void resetPeakDetect();
+    void traceSnapshot();
     
     // Funções auxiliares
     void increaseEstimator(temperature* estimator, temperature error);
@@ -108,6 +163,18 @@ private:
     
     // Temperatura armazenada
     temperature storedBeerSetting;
+    
+    // Agendamento das malhas por tempo de relógio (millis)
+    bool beerLoopPrimed;            // false até a primeira execução da malha lenta
+    bool beerLoopRan;               // malha lenta rodou no último update()
+    ticks_millis_t lastBeerLoop;
+    ticks_millis_t lastIntegralUpdate;
+    
+    // Duty do aquecedor proporcional (permil)
+    uint16_t heaterDuty;
+    
+    // Queda de gravidade recebida do estimador (décimos de ponto/dia)
+    int16_t gravityDropRate;
 };
 
 // Instância global
@@ -0,0 +1,206 @@
+// BrewPiTrace.cpp - Implementação da gravação de trace do controle
+#include "BrewPiTrace.h"
+#include "debug_config.h"
+
+// Definição da instância global
+BrewPiTrace brewPiTrace;
+
+BrewPiTrace::BrewPiTrace()
+    : recording(false)
+    , bytesWritten(0)
+    , ticksSinceFlush(0)
+{
+}
+
+// ========================================
+// ABERTURA / ROTAÇÃO
+// ========================================
+
+// Arquivo existente com cabeçalho de outra versão (gravado antes de um
+// OTA): anexar o formato novo sob ele faria o replay recusar o arquivo
+// inteiro. Ausente ou vazio conta como válido (ganha cabeçalho novo).
+static bool traceHeaderMatches() {
+    File f = LittleFS.open(BREWPI_TRACE_PATH, "r");
+    if (!f) return true;
+
+    bool match = true;
+    if (f.size() > 0) {
+        uint8_t header[5];
+        match = f.read(header, sizeof(header)) == sizeof(header) &&
+                memcmp(header, BREWPI_TRACE_MAGIC, 4) == 0 &&
+                header[4] == BREWPI_TRACE_VERSION;
+    }
+    f.close();
+    return match;
+}
+
+bool BrewPiTrace::openFile() {
+    // Formato antigo vai para o .old (o replay da versão dele ainda lê)
+    if (!traceHeaderMatches()) {
+        LittleFS.remove(BREWPI_TRACE_OLD_PATH);
+        LittleFS.rename(BREWPI_TRACE_PATH, BREWPI_TRACE_OLD_PATH);
+
+        #if DEBUG_BREWPI
+        Serial.println(F("[Trace] 🔁 Trace de outra versão movido para .old"));
+        #endif
+    }
+
+    file = LittleFS.open(BREWPI_TRACE_PATH, "a");
+    if (!file) {
+        #if DEBUG_BREWPI
+        Serial.println(F("[Trace] ❌ Falha ao abrir arquivo de trace"));
+        #endif
+        return false;
+    }
+
+    bytesWritten = file.size();
+
+    // Arquivo novo: grava cabeçalho
+    if (bytesWritten == 0) {
+        uint8_t header[5];
+        memcpy(header, BREWPI_TRACE_MAGIC, 4);
+        header[4] = BREWPI_TRACE_VERSION;
+        file.write(header, sizeof(header));
+        bytesWritten = sizeof(header);
+    }
+
+    ticksSinceFlush = 0;
+    return true;
+}
+
+bool BrewPiTrace::begin() {
+    if (recording) return true;
+
+    recording = openFile();
+
+    #if DEBUG_BREWPI
+    if (recording) {
+        Serial.printf("[Trace] 🔴 Gravação iniciada (%lu bytes existentes)\n",
+                      (unsigned long)bytesWritten);
+    }
+    #endif
+
+    return recording;
+}
+
+void BrewPiTrace::end() {
+    if (!recording) return;
+
+    file.flush();
+    file.close();
+    recording = false;
+
+    #if DEBUG_BREWPI
+    Serial.printf("[Trace] ⏹️  Gravação encerrada (%lu bytes)\n",
+                  (unsigned long)bytesWritten);
+    #endif
+}
+
+void BrewPiTrace::flush() {
+    if (recording) file.flush();
+}
+
+bool BrewPiTrace::rotate() {
+    if (!recording) return false;
+
+    file.close();
+    LittleFS.remove(BREWPI_TRACE_OLD_PATH);
+    LittleFS.rename(BREWPI_TRACE_PATH, BREWPI_TRACE_OLD_PATH);
+
+    recording = openFile();
+
+    #if DEBUG_BREWPI
+    Serial.println(F("[Trace] 🔁 Arquivo rotacionado"));
+    #endif
+
+    return recording;
+}
+
+// ========================================
+// ESCRITA DE REGISTROS
+// ========================================
+
+void BrewPiTrace::write(const void* data, size_t len) {
+    if (!recording) return;
+
+    size_t written = file.write((const uint8_t*)data, len);
+    bytesWritten += written;
+
+    // Falha de escrita (flash cheia) encerra a gravação para não gerar
+    // registros truncados que quebrariam o replay
+    if (written != len) {
+        #if DEBUG_BREWPI
+        Serial.println(F("[Trace] ❌ Falha de escrita, gravação interrompida"));
+        #endif
+        file.close();
+        recording = false;
+    }
+}
+
+void BrewPiTrace::writeTimed(uint8_t type, uint32_t ms, const void* payload, size_t len) {
+    uint8_t buf[16];
+    buf[0] = type;
+    memcpy(buf + 1, &ms, sizeof(ms));
+    if (len > 0) memcpy(buf + 5, payload, len);
+    write(buf, 5 + len);
+}
+
+void BrewPiTrace::recordSnapshot(const void* data, uint16_t len) {
+    uint8_t head[3];
+    head[0] = TRACE_REC_SNAPSHOT;
+    memcpy(head + 1, &len, sizeof(len));
+    write(head, sizeof(head));
+    write(data, len);
+    if (recording) file.flush();
+}
+
+void BrewPiTrace::recordTick(uint32_t ms, uint8_t loops) {
+    uint8_t buf[6];
+    buf[0] = TRACE_REC_TICK;
+    memcpy(buf + 1, &ms, sizeof(ms));
+    buf[5] = loops;
+    write(buf, sizeof(buf));
+
+    if (recording && ++ticksSinceFlush >= BREWPI_TRACE_FLUSH_TICKS) {
+        ticksSinceFlush = 0;
+        file.flush();
+    }
+}
+
+void BrewPiTrace::recordProbe(uint8_t index, float tempC) {
+    uint8_t buf[6];
+    buf[0] = TRACE_REC_PROBE;
+    buf[1] = index;
+    memcpy(buf + 2, &tempC, sizeof(tempC));
+    write(buf, sizeof(buf));
+}
+
+void BrewPiTrace::recordBeerSetting(uint32_t ms, int16_t value) {
+    writeTimed(TRACE_REC_BEER_SETTING, ms, &value, sizeof(value));
+}
+
+void BrewPiTrace::recordFridgeSetting(uint32_t ms, int16_t value) {
+    writeTimed(TRACE_REC_FRIDGE_SETTING, ms, &value, sizeof(value));
+}
+
+void BrewPiTrace::recordMode(uint32_t ms, char mode, bool force) {
+    uint8_t payload[2] = { (uint8_t)mode, (uint8_t)(force ? 1 : 0) };
+    writeTimed(TRACE_REC_MODE, ms, payload, sizeof(payload));
+}
+
+void BrewPiTrace::recordReset(uint32_t ms) {
+    writeTimed(TRACE_REC_RESET, ms, nullptr, 0);
+}
+
+void BrewPiTrace::recordFeedForward(uint32_t ms, int16_t gravityDropRate) {
+    writeTimed(TRACE_REC_FEEDFORWARD, ms, &gravityDropRate, sizeof(gravityDropRate));
+}
+
+void BrewPiTrace::recordOutput(uint8_t state, bool cooling, bool heating, uint16_t heaterDuty) {
+    uint8_t buf[5];
+    buf[0] = TRACE_REC_OUTPUT;
+    buf[1] = state;
+    buf[2] = (cooling ? TRACE_OUT_COOLER : 0) | (heating ? TRACE_OUT_HEATER : 0);
+    memcpy(buf + 3, &heaterDuty, sizeof(heaterDuty));
+    write(buf, sizeof(buf));
+}
@@ -0,0 +1,89 @@
+// BrewPiTrace.h - Gravação determinística das entradas do controle BrewPi
+#pragma once
+
+#include <Arduino.h>
+#include <LittleFS.h>
+
+// ========================================
+// FORMATO DO ARQUIVO DE TRACE
+// ========================================
+// Arquivo binário little-endian, sem padding:
+//
+//   [cabeçalho]  "BPTR" + versão (u8)
+//   [registros]  tipo (u8) + payload fixo por tipo
+//
+// Todo trecho de gravação começa com um TRACE_REC_SNAPSHOT, que contém o
+// estado completo do controle (ControlSnapshot). A partir dele o replay
+// (tools/brewpi_replay) alimenta o MESMO BrewPiTempControl com as leituras
+// brutas e compara as decisões de relé registro a registro.
+
+#define BREWPI_TRACE_PATH       "/brewpi_trace.bin"
+#define BREWPI_TRACE_OLD_PATH   "/brewpi_trace.old"
+#define BREWPI_TRACE_MAX_BYTES  262144UL   // 256KB por arquivo (~3,5 dias a 5s)
+#define BREWPI_TRACE_FLUSH_TICKS 12        // flush a cada 12 ticks (~1 min)
+
+#define BREWPI_TRACE_MAGIC      "BPTR"
+#define BREWPI_TRACE_VERSION    4
+
+enum BrewPiTraceRecord : uint8_t {
+    TRACE_REC_SNAPSHOT      = 0x01,  // u16 len + ControlSnapshot
+    TRACE_REC_TICK          = 0x02,  // u32 millis (início de update()) + u8 malhas executadas
+    TRACE_REC_PROBE         = 0x03,  // u8 índice Dallas + float °C bruto
+    TRACE_REC_BEER_SETTING  = 0x04,  // u32 millis + temperature
+    TRACE_REC_FRIDGE_SETTING= 0x05,  // u32 millis + temperature
+    TRACE_REC_MODE          = 0x06,  // u32 millis + char modo + u8 force
+    TRACE_REC_RESET         = 0x07,  // u32 millis
+    TRACE_REC_OUTPUT        = 0x08,  // u8 estado + u8 flags (bit0 cooler, bit1 heater) + u16 duty aquecedor
+    TRACE_REC_FEEDFORWARD   = 0x09   // u32 millis + i16 queda de gravidade (décimos de ponto/dia)
+};
+
+#define TRACE_OUT_COOLER 0x01
+#define TRACE_OUT_HEATER 0x02
+
+// Malhas executadas no tick (a rápida roda sempre)
+#define TRACE_TICK_BEER_LOOP 0x01
+
+// ========================================
+// CLASSE DE GRAVAÇÃO
+// ========================================
+
+class BrewPiTrace {
+public:
+    BrewPiTrace();
+
+    // Abre (ou continua) o arquivo de trace
+    bool begin();
+    void end();
+    void flush();
+
+    bool isRecording() const { return recording; }
+    uint32_t getBytesWritten() const { return bytesWritten; }
+
+    // Rotação: arquivo atual vira BREWPI_TRACE_OLD_PATH
+    bool needsRotation() const { return recording && bytesWritten >= BREWPI_TRACE_MAX_BYTES; }
+    bool rotate();
+
+    // Registros
+    void recordSnapshot(const void* data, uint16_t len);
+    void recordTick(uint32_t ms, uint8_t loops);
+    void recordProbe(uint8_t index, float tempC);
+    void recordBeerSetting(uint32_t ms, int16_t value);
+    void recordFridgeSetting(uint32_t ms, int16_t value);
+    void recordMode(uint32_t ms, char mode, bool force);
+    void recordReset(uint32_t ms);
+    void recordFeedForward(uint32_t ms, int16_t gravityDropRate);
+    void recordOutput(uint8_t state, bool cooling, bool heating, uint16_t heaterDuty);
+
+private:
+    bool openFile();
+    void write(const void* data, size_t len);
+    void writeTimed(uint8_t type, uint32_t ms, const void* payload, size_t len);
+
+    File file;
+    bool recording;
+    uint32_t bytesWritten;
+    uint8_t ticksSinceFlush;
+};
+
+// Instância global
+extern BrewPiTrace brewPiTrace;
@@ -41,6 +41,16 @@ inline temperature intToTemp(int tempInt) {
     return ((temperature)tempInt << TEMP_FIXED_POINT_BITS) + C_OFFSET;
 }
 
+// Converte diferença fixed-point para float (sem offset)
+inline float tempDiffToFloat(temperature diff) {
+    return ((float)diff) / TEMP_FIXED_POINT_SCALE;
+}
+
+// Converte float para diferença fixed-point (sem offset)
+inline temperature floatToTempDiff(float diff) {
+    return (temperature)(diff * TEMP_FIXED_POINT_SCALE);
+}
+
 // Converte inteiro para diferença de temperatura
 inline temperature intToTempDiff(int diff) {
     return ((temperature)diff << TEMP_FIXED_POINT_BITS);
@@ -138,6 +148,10 @@ struct ControlConstants {
     uint8_t beerSlowFilter;      // 4
     uint8_t beerSlopeFilter;     // 4
     
+    // Janela da regressão de slope em amostras (0 = filtro exponencial acima)
+    uint8_t fridgeSlopeWindow;   // 0
+    uint8_t beerSlopeWindow;     // 0
+    
     // Flags
     uint8_t lightAsHeater;       // 0 = não usa luz como aquecedor
     uint8_t rotaryHalfSteps;     // 0 = passos completos
@@ -151,6 +165,20 @@ struct ControlConstants {
     uint16_t minHeatTime;        // 300s (5min)
     uint16_t minHeatIdleTime;    // 600s (10min)
     uint16_t mutexDeadTime;      // 900s (15min)
+    
+    // Aquecedor proporcional no tempo (SSR resistivo)
+    uint8_t heaterPwm;           // 1 = duty proporcional, 0 = liga/desliga com tempos mínimos
+    uint16_t heaterPwmPeriod;    // 30s (janela, 10-60s)
+    temperature heaterPwmBand;   // 2.0°C de erro da geladeira = 100% de duty
+    
+    // Feed-forward da exotermia (queda de gravidade do iSpindel)
+    temperature exothermGain;    // 0.15°C de pré-resfriamento por ponto/dia (0 = desativado)
+    temperature exothermMax;     // 2.0°C de pré-resfriamento máximo
+    
+    // Períodos das malhas (tempo de relógio, independentes da cadência do loop)
+    uint16_t fridgeLoopMs;       // 5000ms: leitura, máquina de estados, picos e saídas
+    uint16_t beerLoopPeriod;     // 30s: PID da cerveja (recalcula fridgeSetting)
+    uint16_t integralPeriod;     // 300s: atualização do integrador
 };
 
 // ========================================
@@ -169,6 +197,7 @@ struct ControlVariables {
     temperature posPeakEstimate;    // Última estimativa de pico positivo
     temperature negPeak;            // Último pico negativo detectado
     temperature posPeak;            // Último pico positivo detectado
+    temperature ff;                 // Feed-forward da exotermia (≤ 0)
 };
 
 // ========================================
@@ -215,6 +244,9 @@ const ControlConstants DEFAULT_CONTROL_CONSTANTS = {
     /* beerSlowFilter */ 4,
     /* beerSlopeFilter */ 4,
     
+    /* fridgeSlopeWindow */ 0,
+    /* beerSlopeWindow */ 0,
+    
     /* lightAsHeater */ 0,
     /* rotaryHalfSteps */ 0,
     
@@ -224,7 +256,18 @@ const ControlConstants DEFAULT_CONTROL_CONSTANTS = {
     /* minCoolIdleTime */ 900,    // 15min
     /* minHeatTime */ 300,        // 5min
     /* minHeatIdleTime */ 600,    // 10min
-    /* mutexDeadTime */ 900       // 15min
+    /* mutexDeadTime */ 900,      // 15min
+    
+    /* heaterPwm */ 1,
+    /* heaterPwmPeriod */ 30,     // 30s
+    /* heaterPwmBand */ intToTempDiff(2),  // 2.0°C
+    
+    /* exothermGain */ (temperature)(intToTempDiff(15)/100),  // 0.15°C por ponto/dia
+    /* exothermMax */ intToTempDiff(2),                        // 2.0°C
+    
+    /* fridgeLoopMs */ 5000,      // 5s
+    /* beerLoopPeriod */ 30,      // 30s
+    /* integralPeriod */ 300      // 5min (antes: 60 ciclos de 5s)
 };
 
 // ========================================
@@ -0,0 +1,102 @@
+// HeaterPwm.cpp - Implementação da saída proporcional no tempo
+#include "HeaterPwm.h"
+#include "debug_config.h"
+
+// Definição da instância global
+HeaterPwm heaterPwm;
+
+HeaterPwm::HeaterPwm()
+    : heater(nullptr)
+    , running(false)
+    , outputOn(false)
+    , requestedDuty(0)
+    , requestedPeriodMs(30000)
+    , lastRequest(0)
+    , windowStart(0)
+    , windowPeriodMs(30000)
+    , windowOnMs(0)
+{
+}
+
+void HeaterPwm::begin(Rele* h) {
+    heater = h;
+}
+
+void HeaterPwm::setDuty(uint16_t duty, uint16_t periodSeconds) {
+    if (!heater) return;
+
+    if (duty > HEATER_PWM_DUTY_MAX) duty = HEATER_PWM_DUTY_MAX;
+    periodSeconds = constrain(periodSeconds, HEATER_PWM_PERIOD_MIN, HEATER_PWM_PERIOD_MAX);
+
+    requestedDuty = duty;
+    requestedPeriodMs = (uint32_t)periodSeconds * 1000UL;
+    lastRequest = millis();
+
+    if (!running) {
+        running = true;
+        windowStart = millis() - requestedPeriodMs;  // força nova janela já no 1º tick
+        ticker.attach_ms(HEATER_PWM_TICK_MS, HeaterPwm::onTick, this);
+        tick();
+
+        #if DEBUG_BREWPI
+        Serial.printf("[PWM] 🔥 Aquecedor em modo proporcional (janela %us)\n", periodSeconds);
+        #endif
+    }
+}
+
+void HeaterPwm::stop() {
+    if (!running) return;
+
+    ticker.detach();
+    running = false;
+    requestedDuty = 0;
+    writeOutput(false);
+
+    #if DEBUG_BREWPI
+    Serial.println(F("[PWM] ⏹️  Modo proporcional desligado"));
+    #endif
+}
+
+void HeaterPwm::onTick(HeaterPwm* self) {
+    self->tick();
+}
+
+void HeaterPwm::tick() {
+    uint32_t now = millis();
+    uint32_t elapsed = now - windowStart;
+
+    // Controle parou de atualizar (fermentação encerrada, loop travado):
+    // o aquecedor não pode ficar pulsando com o último duty
+    if (now - lastRequest > HEATER_PWM_STALE_MS) {
+        requestedDuty = 0;
+    }
+
+    // Nova janela: trava duty e período atuais
+    if (elapsed >= windowPeriodMs) {
+        windowStart = now;
+        elapsed = 0;
+        windowPeriodMs = requestedPeriodMs;
+        windowOnMs = (windowPeriodMs * requestedDuty) / HEATER_PWM_DUTY_MAX;
+
+        // Pulsos curtos demais (ou quase janela cheia) viram 0% / 100%
+        if (windowOnMs < HEATER_PWM_MIN_PULSE_MS) {
+            windowOnMs = 0;
+        } else if (windowPeriodMs - windowOnMs < HEATER_PWM_MIN_PULSE_MS) {
+            windowOnMs = windowPeriodMs;
+        }
+    }
+
+    // Duty pode cair no meio da janela (ex.: controle pediu 0%): corta já
+    bool on = (elapsed < windowOnMs) && (requestedDuty > 0);
+    if (on != outputOn) {
+        writeOutput(on);
+    }
+}
+
+void HeaterPwm::writeOutput(bool on) {
+    outputOn = on;
+    if (heater) {
+        heater->estado = on;
+        heater->atualizar();
+    }
+}
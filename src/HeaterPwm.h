@@ -0,0 +1,58 @@
+// HeaterPwm.h - Saída proporcional no tempo para o aquecedor (SSR)
+#pragma once
+
+#include <Arduino.h>
+#include <Ticker.h>
+#include "estruturas.h"  // Para Rele
+
+// ========================================
+// PARÂMETROS
+// ========================================
+
+#define HEATER_PWM_TICK_MS      100   // Resolução da janela
+#define HEATER_PWM_PERIOD_MIN   10    // Janela mínima (s)
+#define HEATER_PWM_PERIOD_MAX   60    // Janela máxima (s)
+#define HEATER_PWM_DUTY_MAX     1000  // Duty em permil
+#define HEATER_PWM_MIN_PULSE_MS 200   // Pulsos menores são ignorados
+#define HEATER_PWM_STALE_MS     60000 // Sem setDuty() nesse tempo = desliga
+
+// ========================================
+// CLASSE DE PWM LENTO
+// ========================================
+// Aciona o relé do aquecedor por um Ticker (os_timer), independente da
+// cadência do loop(). O duty é travado no início de cada janela, então
+// mudanças no meio da janela não geram pulsos quebrados.
+
+class HeaterPwm {
+public:
+    HeaterPwm();
+
+    void begin(Rele* heater);
+
+    // duty em permil (0..1000), período em segundos (10..60)
+    void setDuty(uint16_t duty, uint16_t periodSeconds);
+    void stop();
+
+    bool isRunning() const { return running; }
+    bool isOutputOn() const { return outputOn; }
+    uint16_t getDuty() const { return requestedDuty; }
+
+private:
+    static void onTick(HeaterPwm* self);
+    void tick();
+    void writeOutput(bool on);
+
+    Ticker ticker;
+    Rele* heater;
+    bool running;
+    volatile bool outputOn;
+    volatile uint16_t requestedDuty;
+    volatile uint32_t requestedPeriodMs;
+    volatile uint32_t lastRequest;
+    uint32_t windowStart;
+    uint32_t windowPeriodMs;
+    uint32_t windowOnMs;
+};
+
+// Instância global
+extern HeaterPwm heaterPwm;
@@ -1,5 +1,6 @@
 // TempSensor.cpp - Implementação do sensor com filtros
 #include "TempSensor.h"
+#include "BrewPiTrace.h"
 
 TempSensor::TempSensor(DallasTemperature* sens, uint8_t idx)
     : sensors(sens)
@@ -20,6 +21,8 @@ TempSensor::TempSensor(DallasTemperature* sens, uint8_t idx)
     , negPeak(INVALID_TEMP)
     , prevTemp(INVALID_TEMP)
 {
+    regression.size = 0;
+    resetRegression();
 }
 
 void TempSensor::init() {
@@ -39,10 +42,22 @@ void TempSensor::update() {
     // Lê temperatura do sensor Dallas
     float tempC = sensors->getTempCByIndex(sensorIndex);
     
+    // Leitura bruta vai para o trace antes de qualquer validação
+    if (brewPiTrace.isRecording()) {
+        brewPiTrace.recordProbe(sensorIndex, tempC);
+    }
+    
+    processReading(tempC);
+}
+
+void TempSensor::processReading(float tempC) {
     // Verifica se leitura é válida
     if (tempC == DEVICE_DISCONNECTED_C || tempC < -20.0f || tempC > 50.0f) {
         connected = false;
         currentTemp = INVALID_TEMP;
+        
+        // Lacuna na série: a regressão assume amostras contíguas
+        resetRegression();
         return;
     }
     
@@ -62,9 +77,15 @@ void TempSensor::update() {
         slowFiltered = applyFilter(currentTemp, slowFiltered, slowFilterCoeff);
     }
     
-    // Atualiza slope a cada 10 segundos
+    // Slope por regressão sobre a janela de leituras brutas
+    if (regression.size > 0) {
+        addRegressionSample(currentTemp, ticks.millis());
+        slope = regressionSlope();
+    }
+    
+    // Atualiza slope a cada 10 segundos (filtro original)
     ticks_seconds_t now = ticks.seconds();
-    if (now - lastSlopeUpdate >= 10) {
+    if (regression.size == 0 && now - lastSlopeUpdate >= 10) {
         temperature diff = slowFiltered - prevSlowFiltered;
         uint16_t timeDiff = now - lastSlopeUpdate;
         
@@ -126,6 +147,75 @@ void TempSensor::setSlopeFilterCoefficients(uint8_t coeff) {
     slopeFilterCoeff = coeff;
 }
 
+// ========================================
+// REGRESSÃO LINEAR INCREMENTAL
+// ========================================
+
+void TempSensor::setSlopeWindow(uint8_t samples) {
+    if (samples > SLOPE_WINDOW_MAX) samples = SLOPE_WINDOW_MAX;
+    if (samples > 0 && samples < SLOPE_WINDOW_MIN) samples = SLOPE_WINDOW_MIN;
+    
+    if (samples != regression.size) {
+        regression.size = samples;
+        resetRegression();
+    }
+}
+
+void TempSensor::resetRegression() {
+    regression.count = 0;
+    regression.head = 0;
+    regression.sumY = 0;
+    regression.sumXY = 0;
+}
+
+void TempSensor::addRegressionSample(temperature y, ticks_millis_t t) {
+    SlopeWindow& w = regression;
+    uint8_t n = w.count;
+    
+    if (n < w.size) {
+        // Janela enchendo: nova amostra recebe índice x = n
+        uint8_t idx = (w.head + n) % w.size;
+        w.y[idx] = y;
+        w.t[idx] = t;
+        w.sumXY += (int32_t)n * y;
+        w.sumY += y;
+        w.count++;
+        return;
+    }
+    
+    // Janela cheia: sai a mais antiga e todos os índices descem 1
+    //   Σ i·y' = Σ i·y - (Σ y - y_antiga) + (N-1)·y_nova
+    temperature oldest = w.y[w.head];
+    w.sumXY = w.sumXY - (w.sumY - oldest) + (int32_t)(n - 1) * y;
+    w.sumY = w.sumY - oldest + y;
+    w.y[w.head] = y;
+    w.t[w.head] = t;
+    w.head = (w.head + 1) % w.size;
+}
+
+temperature TempSensor::regressionSlope() const {
+    const SlopeWindow& w = regression;
+    int64_t n = w.count;
+    if (n < SLOPE_WINDOW_MIN) return 0;
+    
+    ticks_millis_t oldest = w.t[w.head];
+    ticks_millis_t newest = w.t[(w.head + w.count - 1) % w.size];
+    ticks_millis_t span = newest - oldest;
+    if (span == 0) return 0;
+    
+    // slope/amostra = (n·Σxy - Σx·Σy) / (n·Σx² - (Σx)²)
+    int64_t sumX = n * (n - 1) / 2;
+    int64_t den = n * n * (n * n - 1) / 12;
+    int64_t num = n * (int64_t)w.sumXY - sumX * (int64_t)w.sumY;
+    
+    // Converte para °C/h usando o intervalo real entre amostras
+    int64_t perHour = (num * (n - 1) * 3600000LL) / (den * (int64_t)span);
+    
+    if (perHour > 32767) return 32767;
+    if (perHour < -32768) return -32768;
+    return (temperature)perHour;
+}
+
 temperature TempSensor::detectPosPeak() {
     if (posPeakDetected) {
         posPeakDetected = false;  // Reset flag
@@ -140,4 +230,42 @@ temperature TempSensor::detectNegPeak() {
         return negPeak;
     }
     return INVALID_TEMP;
+}
+
+void TempSensor::saveState(TempSensorState& out) const {
+    out.connected = connected ? 1 : 0;
+    out.currentTemp = currentTemp;
+    out.fastFiltered = fastFiltered;
+    out.slowFiltered = slowFiltered;
+    out.slope = slope;
+    out.fastFilterCoeff = fastFilterCoeff;
+    out.slowFilterCoeff = slowFilterCoeff;
+    out.slopeFilterCoeff = slopeFilterCoeff;
+    out.prevSlowFiltered = prevSlowFiltered;
+    out.lastSlopeUpdate = lastSlopeUpdate;
+    out.posPeakDetected = posPeakDetected ? 1 : 0;
+    out.negPeakDetected = negPeakDetected ? 1 : 0;
+    out.posPeak = posPeak;
+    out.negPeak = negPeak;
+    out.prevTemp = prevTemp;
+    out.regression = regression;
+}
+
+void TempSensor::restoreState(const TempSensorState& in) {
+    connected = in.connected != 0;
+    currentTemp = in.currentTemp;
+    fastFiltered = in.fastFiltered;
+    slowFiltered = in.slowFiltered;
+    slope = in.slope;
+    fastFilterCoeff = in.fastFilterCoeff;
+    slowFilterCoeff = in.slowFilterCoeff;
+    slopeFilterCoeff = in.slopeFilterCoeff;
+    prevSlowFiltered = in.prevSlowFiltered;
+    lastSlopeUpdate = in.lastSlopeUpdate;
+    posPeakDetected = in.posPeakDetected != 0;
+    negPeakDetected = in.negPeakDetected != 0;
+    posPeak = in.posPeak;
+    negPeak = in.negPeak;
+    prevTemp = in.prevTemp;
+    regression = in.regression;
 }
\ No newline at end of file
@@ -7,6 +7,51 @@
 #include "BrewPiStructs.h"
 #include "BrewPiTicks.h"
 
+// ========================================
+// ESTIMADOR DE SLOPE POR MÍNIMOS QUADRADOS
+// ========================================
+// Regressão linear sobre as últimas N leituras brutas (x = índice da amostra),
+// com somas acumuladas inteiras: cada amostra nova custa O(1). O tempo real
+// da janela (millis da mais antiga à mais nova) converte para °C/h.
+
+#define SLOPE_WINDOW_MAX 64   // amostras (64 x 5s = 5min20s)
+#define SLOPE_WINDOW_MIN 3
+
+struct SlopeWindow {
+    uint8_t size;                         // janela configurada (0 = filtro legado)
+    uint8_t count;                        // amostras válidas
+    uint8_t head;                         // índice da amostra mais antiga
+    int32_t sumY;                         // Σ y
+    int32_t sumXY;                        // Σ i·y, i = 0..count-1
+    temperature y[SLOPE_WINDOW_MAX];
+    ticks_millis_t t[SLOPE_WINDOW_MAX];
+};
+
+// ========================================
+// ESTADO SERIALIZÁVEL (SNAPSHOT DO TRACE)
+// ========================================
+// Apenas tipos de largura fixa: o layout precisa ser idêntico no ESP8266
+// e no host que executa o replay.
+
+struct TempSensorState {
+    uint8_t connected;
+    temperature currentTemp;
+    temperature fastFiltered;
+    temperature slowFiltered;
+    temperature slope;
+    uint8_t fastFilterCoeff;
+    uint8_t slowFilterCoeff;
+    uint8_t slopeFilterCoeff;
+    temperature prevSlowFiltered;
+    ticks_seconds_t lastSlopeUpdate;
+    uint8_t posPeakDetected;
+    uint8_t negPeakDetected;
+    temperature posPeak;
+    temperature negPeak;
+    temperature prevTemp;
+    SlopeWindow regression;
+};
+
 // ========================================
 // CLASSE DE SENSOR DE TEMPERATURA
 // ========================================
@@ -21,6 +66,9 @@ public:
     // Atualização de leitura
     void update();
     
+    // Processa uma leitura bruta (°C) já obtida do barramento
+    void processReading(float tempC);
+    
     // Verifica se está conectado
     bool isConnected() const {
         return connected;
@@ -44,10 +92,18 @@ public:
     void setSlowFilterCoefficients(uint8_t coeff);
     void setSlopeFilterCoefficients(uint8_t coeff);
     
+    // Janela da regressão de slope (0 = filtro exponencial original)
+    void setSlopeWindow(uint8_t samples);
+    uint8_t getSlopeWindow() const { return regression.size; }
+    
     // Detecção de picos
     temperature detectPosPeak();
     temperature detectNegPeak();
     
+    // Snapshot para gravação/replay
+    void saveState(TempSensorState& out) const;
+    void restoreState(const TempSensorState& in);
+    
 private:
     // Hardware
     DallasTemperature* sensors;
@@ -76,6 +132,14 @@ private:
     temperature negPeak;
     temperature prevTemp;
     
+    // Regressão de slope
+    SlopeWindow regression;
+    
     // Função auxiliar de filtro
     temperature applyFilter(temperature input, temperature prevOutput, uint8_t coeff);
+    
+    // Funções da regressão
+    void resetRegression();
+    void addRegressionSample(temperature y, ticks_millis_t t);
+    temperature regressionSlope() const;
 };
\ No newline at end of file
@@ -0,0 +1,697 @@
+// async_http.cpp - Implementação do cliente HTTP assíncrono
+#include "async_http.h"
+#include <ESP8266WiFi.h>
+#include <ESPAsyncTCP.h>
+#include "debug_config.h"
+
+// Definição da instância global
+AsyncHttp asyncHttp;
+
+AsyncHttp::AsyncHttp()
+    : head(0)
+    , count(0)
+    , answered(0)
+    , inflight(0)
+    , port(80)
+    , client(nullptr)
+    , conn(CONN_NONE)
+    , connLost(false)
+    , connCloseAfter(false)
+    , pipelineOk(false)
+    , connServed(0)
+    , lastActivityMs(0)
+    , idleTimeoutMs(ASYNC_HTTP_IDLE_TIMEOUT_MS)
+    , protoError(0)
+    , txOffset(0)
+    , txSlot(0)
+    , txPending(0)
+    , txInBody(false)
+    , inHeaders(true)
+    , respStarted(false)
+    , respClose(false)
+    , status(0)
+    , contentLength(-1)
+    , chunked(false)
+    , chunkState(CHUNK_SIZE)
+    , chunkRemaining(0)
+    , completed(0)
+    , failed(0)
+    , timeouts(0)
+    , dropped(0)
+    , lastLatencyMs(0)
+    , maxLatencyMs(0)
+    , latencySumMs(0)
+    , connects(0)
+    , requestsSent(0)
+    , reusedSent(0)
+    , pipelined(0)
+    , retries(0)
+{
+}
+
+void AsyncHttp::begin(const char* baseUrl) {
+    String url = baseUrl;
+    if (url.startsWith("http://")) url.remove(0, 7);
+
+    int slash = url.indexOf('/');
+    basePath = (slash >= 0) ? url.substring(slash) : String("/");
+    if (slash >= 0) url.remove(slash);
+
+    int colon = url.indexOf(':');
+    if (colon >= 0) {
+        port = url.substring(colon + 1).toInt();
+        url.remove(colon);
+    } else {
+        port = 80;
+    }
+    host = url;
+
+    #if DEBUG_HTTP
+    Serial.printf("[HTTP] Servidor %s:%u%s\n", host.c_str(), port, basePath.c_str());
+    #endif
+}
+
+// ========================================
+// FILA
+// ========================================
+
+bool AsyncHttp::request(AsyncHttpMethod method, const String& path, String reqBody,
+                        AsyncHttpCallback callback, uint32_t deadlineMs,
+                        const char* contentType, const String& ifNoneMatch) {
+    if (count >= ASYNC_HTTP_QUEUE_SIZE) {
+        dropped++;
+        #if DEBUG_HTTP
+        Serial.printf("[HTTP] ⚠️ Fila cheia, descartado: %s\n", path.c_str());
+        #endif
+        return false;
+    }
+
+    Request& r = at(count);
+    r.method = method;
+    r.state = REQ_QUEUED;
+    r.attempts = 0;
+    r.reused = false;
+    r.result = 0;
+    r.path = path;
+    r.body = std::move(reqBody);
+    r.etag = ifNoneMatch;
+    r.contentType = contentType;
+    r.callback = callback;
+    r.enqueuedMs = millis();
+    r.deadlineMs = deadlineMs;
+    count++;
+    return true;
+}
+
+// Resultado para a primeira requisição ainda sem resultado
+void AsyncHttp::markDone(int result) {
+    Request& r = at(answered);
+    if (r.state == REQ_SENT) inflight--;
+    r.state = REQ_DONE;
+    r.result = result;
+    if (result <= 0) {
+        r.body = String();
+        r.etag = String();
+    }
+    answered++;
+}
+
+// ========================================
+// LOOP (contexto do loop(), nunca do lwIP)
+// ========================================
+
+void AsyncHttp::loop() {
+    // 1. Conexão caiu ou a resposta veio quebrada
+    if (connLost) {
+        if (protoError != 0) {
+            dropConnection(protoError, false);
+        } else {
+            dropConnection(ASYNC_HTTP_ERR_DISCONNECTED, true);
+        }
+    }
+
+    // 2. Prazos e entrega, na ordem da fila
+    checkDeadlines();
+    deliver();
+
+    // 3. Sem nada a fazer: fecha antes que o servidor feche
+    if (client && inflight == 0 && count == 0) {
+        uint32_t limit = (conn == CONN_READY) ? idleTimeoutMs : ASYNC_HTTP_DEADLINE_MS;
+        if (millis() - lastActivityMs >= limit) {
+            #if DEBUG_HTTP
+            Serial.printf("[HTTP] Conexão ociosa fechada (%u respostas)\n", connServed);
+            #endif
+            closeClient();
+        }
+    }
+
+    // 4. Próximas da fila
+    sendQueued();
+}
+
+void AsyncHttp::checkDeadlines() {
+    while (answered < count) {
+        const Request& r = at(answered);
+        if (millis() - r.enqueuedMs < r.deadlineMs) break;
+
+        if (r.state == REQ_SENT) {
+            dropConnection(ASYNC_HTTP_ERR_TIMEOUT, false);
+        } else {
+            markDone(ASYNC_HTTP_ERR_TIMEOUT);
+        }
+    }
+}
+
+void AsyncHttp::deliver() {
+    while (count > 0 && at(0).state == REQ_DONE) {
+        // Tira da fila ANTES do callback: ele pode enfileirar outra requisição
+        Request& r = at(0);
+        AsyncHttpCallback callback = std::move(r.callback);
+
+        AsyncHttpResponse resp;
+        resp.status = r.result;
+        resp.elapsedMs = millis() - r.enqueuedMs;
+        if (r.result > 0) {
+            resp.body = std::move(r.body);
+            resp.etag = std::move(r.etag);
+        }
+
+        r.callback = nullptr;
+        r.path = String();
+        r.body = String();
+        r.etag = String();
+        head = (head + 1) % ASYNC_HTTP_QUEUE_SIZE;
+        count--;
+        answered--;
+
+        // 304 é resposta completa (GET condicional), não falha
+        if (resp.ok() || resp.notModified()) {
+            completed++;
+            lastLatencyMs = resp.elapsedMs;
+            latencySumMs += resp.elapsedMs;
+            if (resp.elapsedMs > maxLatencyMs) maxLatencyMs = resp.elapsedMs;
+        } else {
+            failed++;
+            if (resp.status == ASYNC_HTTP_ERR_TIMEOUT) timeouts++;
+            #if DEBUG_HTTP
+            Serial.printf("[HTTP] ❌ Requisição falhou (%d) em %lums\n",
+                          resp.status, (unsigned long)resp.elapsedMs);
+            #endif
+        }
+
+        if (callback) callback(resp);
+    }
+}
+
+void AsyncHttp::sendQueued() {
+    if (answered + inflight >= count) return;
+
+    if (WiFi.status() != WL_CONNECTED) {
+        if (client) dropConnection(ASYNC_HTTP_ERR_NO_WIFI, false);
+        while (answered < count) markDone(ASYNC_HTTP_ERR_NO_WIFI);
+        return;
+    }
+
+    // Servidor pediu para fechar: termina as pendentes e reabre
+    if (client && connCloseAfter && inflight == 0) closeClient();
+
+    if (!client) {
+        openConnection();
+        return;   // envia quando conectar
+    }
+    if (conn != CONN_READY || connCloseAfter) return;
+
+    // Até o servidor confirmar keep-alive, uma por vez
+    uint8_t depth = pipelineOk ? ASYNC_HTTP_PIPELINE_DEPTH : 1;
+    bool added = false;
+
+    while (answered + inflight < count && inflight < depth) {
+        uint8_t slot = (head + answered + inflight) % ASYNC_HTTP_QUEUE_SIZE;
+        if (txPending == 0) txSlot = slot;
+        appendRequest(queue[slot]);
+        txPending++;
+        inflight++;
+        added = true;
+    }
+
+    if (added) pump();
+}
+
+// ========================================
+// CONEXÃO
+// ========================================
+
+void AsyncHttp::openConnection() {
+    client = new AsyncClient();
+    if (!client) {
+        markDone(ASYNC_HTTP_ERR_CONNECT);
+        return;
+    }
+
+    conn = CONN_CONNECTING;
+    connLost = false;
+    protoError = 0;
+    connCloseAfter = false;
+    pipelineOk = false;
+    connServed = 0;
+    idleTimeoutMs = ASYNC_HTTP_IDLE_TIMEOUT_MS;
+    lastActivityMs = millis();
+    connects++;
+    resetParser();
+
+    // Os callbacks chegam no contexto do lwIP: só movem dados e marcam
+    // estado. Conferir o ponteiro descarta eventos de um cliente já
+    // abandonado (close() dispara onDisconnect na hora).
+    client->onConnect([](void* arg, AsyncClient* c) {
+        AsyncHttp* self = (AsyncHttp*)arg;
+        if (c != self->client) return;
+        self->conn = CONN_READY;
+        self->lastActivityMs = millis();
+    }, this);
+
+    client->onAck([](void* arg, AsyncClient* c, size_t, uint32_t) {
+        AsyncHttp* self = (AsyncHttp*)arg;
+        if (c != self->client) return;
+        self->pump();
+    }, this);
+
+    client->onData([](void* arg, AsyncClient* c, void* data, size_t len) {
+        AsyncHttp* self = (AsyncHttp*)arg;
+        if (c != self->client) return;
+        self->onData((const char*)data, len);
+    }, this);
+
+    client->onDisconnect([](void* arg, AsyncClient* c) {
+        AsyncHttp* self = (AsyncHttp*)arg;
+        if (c != self->client) return;
+        // Sem Content-Length nem chunked, o fim do corpo é o fechamento
+        if (self->inflight > 0 && self->respStarted && !self->inHeaders &&
+            self->contentLength < 0 && !self->chunked) {
+            self->finishResponse();
+        }
+        self->connLost = true;
+    }, this);
+
+    client->onError([](void* arg, AsyncClient* c, int8_t) {
+        AsyncHttp* self = (AsyncHttp*)arg;
+        if (c != self->client) return;
+        self->connLost = true;
+    }, this);
+
+    client->setNoDelay(true);
+
+    if (!client->connect(host.c_str(), port)) {
+        dropConnection(ASYNC_HTTP_ERR_CONNECT, false);
+    }
+}
+
+void AsyncHttp::closeClient() {
+    if (client) {
+        AsyncClient* c = client;
+        client = nullptr;      // antes do close(): ignora o onDisconnect síncrono
+        c->close(true);
+        delete c;
+    }
+
+    conn = CONN_NONE;
+    connLost = false;
+    protoError = 0;
+    connCloseAfter = false;
+    pipelineOk = false;
+    connServed = 0;
+    tx = String();
+    txOffset = 0;
+    txPending = 0;
+    txInBody = false;
+    resetParser();
+}
+
+// A requisição cuja resposta estava chegando recebe o erro; as enviadas
+// atrás dela (pipelining) voltam para a fila. Se a conexão reaproveitada
+// caiu antes de qualquer byte da resposta (o servidor fechou por
+// ociosidade), a primeira também volta, até ASYNC_HTTP_MAX_ATTEMPTS.
+void AsyncHttp::dropConnection(int error, bool allowRetry) {
+    bool wasConnecting = (conn == CONN_CONNECTING);
+    bool started = respStarted;
+
+    closeClient();
+
+    if (inflight == 0) {
+        if (wasConnecting && answered < count) markDone(ASYNC_HTTP_ERR_CONNECT);
+        return;
+    }
+
+    Request& first = at(answered);
+    if (allowRetry && !started && first.reused && first.attempts < ASYNC_HTTP_MAX_ATTEMPTS) {
+        first.state = REQ_QUEUED;
+        retries++;
+    } else {
+        markDone(error);
+    }
+
+    for (uint8_t i = answered; i < count; i++) {
+        Request& r = at(i);
+        if (r.state == REQ_SENT) r.state = REQ_QUEUED;
+    }
+    inflight = 0;
+
+    #if DEBUG_HTTP
+    Serial.printf("[HTTP] ⚠️ Conexão perdida (%d)\n", error);
+    #endif
+}
+
+// ========================================
+// ENVIO
+// ========================================
+
+void AsyncHttp::appendRequest(Request& r) {
+    r.reused = (connServed > 0) || (inflight > 0);
+    r.attempts++;
+    r.state = REQ_SENT;
+
+    requestsSent++;
+    if (r.reused) reusedSent++;
+    if (inflight > 0) pipelined++;
+}
+
+void AsyncHttp::buildHeader(const Request& r) {
+    bool post = (r.method == ASYNC_HTTP_POST);
+
+    tx.reserve(160 + host.length() + basePath.length() + r.path.length() + r.etag.length());
+    tx += post ? F("POST ") : F("GET ");
+    tx += basePath;
+    tx += r.path;
+    tx += F(" HTTP/1.1\r\nHost: ");
+    tx += host;
+    tx += F("\r\nUser-Agent: ESP8266-Fermentador\r\nConnection: keep-alive\r\n");
+    if (r.etag.length() > 0) {
+        tx += F("If-None-Match: ");
+        tx += r.etag;
+        tx += F("\r\n");
+    }
+    if (post) {
+        tx += F("Content-Type: ");
+        tx += r.contentType;
+        tx += F("\r\nContent-Length: ");
+        tx += r.body.length();
+        tx += F("\r\n");
+    }
+    tx += F("\r\n");
+}
+
+// Escreve o restante de data a partir de txOffset; false = buffer TCP cheio
+bool AsyncHttp::writeSegment(const String& data, bool& added) {
+    while (txOffset < data.length()) {
+        size_t space = client->space();
+        if (space == 0) return false;
+
+        size_t chunk = data.length() - txOffset;
+        if (chunk > space) chunk = space;
+
+        // add() copia para o pbuf do lwIP: data pode mudar depois
+        size_t sent = client->add(data.c_str() + txOffset, chunk);
+        if (sent == 0) return false;
+        txOffset += sent;
+        added = true;
+    }
+    return true;
+}
+
+// Escreve o quanto couber no buffer TCP; o restante vai no próximo onAck.
+// Cabeçalho e corpo saem em trechos separados: o corpo é lido direto de
+// r.body (que fica até a resposta, para um reenvio), sem cópia
+void AsyncHttp::pump() {
+    if (!client || conn != CONN_READY || connLost) return;
+
+    bool added = false;
+    while (txPending > 0) {
+        Request& r = queue[txSlot];
+
+        if (!txInBody) {
+            if (tx.length() == 0) buildHeader(r);
+            if (!writeSegment(tx, added)) break;
+
+            tx = String();
+            txOffset = 0;
+            txInBody = (r.method == ASYNC_HTTP_POST);
+        }
+
+        if (txInBody) {
+            if (!writeSegment(r.body, added)) break;
+            txOffset = 0;
+            txInBody = false;
+        }
+
+        txSlot = (txSlot + 1) % ASYNC_HTTP_QUEUE_SIZE;
+        txPending--;
+    }
+
+    if (added) {
+        client->send();
+        lastActivityMs = millis();
+    }
+}
+
+// ========================================
+// RESPOSTA (contexto do lwIP)
+// ========================================
+
+void AsyncHttp::resetParser() {
+    inHeaders = true;
+    respStarted = false;
+    respClose = false;
+    headerBuf = String();
+    respEtag = String();
+    status = 0;
+    contentLength = -1;
+    chunked = false;
+    chunkState = CHUNK_SIZE;
+    chunkRemaining = 0;
+    chunkLine = String();
+    respBody = String();
+}
+
+void AsyncHttp::protocolError(int error) {
+    protoError = error;
+    connLost = true;
+}
+
+void AsyncHttp::finishResponse() {
+    Request& r = at(answered);
+
+    // Resposta antes do fim do envio (ex.: 413): r.body ainda estava
+    // saindo e o resto não pode seguir nesta conexão
+    bool stillSending = txPending > 0 && &r == &queue[txSlot];
+
+    r.body = std::move(respBody);
+    r.etag = std::move(respEtag);
+    markDone(status);
+
+    connServed++;
+    lastActivityMs = millis();
+    if (respClose) {
+        connCloseAfter = true;
+    } else {
+        pipelineOk = true;
+    }
+
+    resetParser();
+    if (stillSending) connLost = true;
+}
+
+void AsyncHttp::onData(const char* data, size_t len) {
+    lastActivityMs = millis();
+
+    while (len > 0) {
+        if (protoError != 0) return;   // descarta até o loop() derrubar
+
+        // Bytes sem requisição esperando resposta
+        if (inflight == 0) {
+            protocolError(ASYNC_HTTP_ERR_PARSE);
+            return;
+        }
+
+        respStarted = true;
+
+        size_t used;
+        if (inHeaders) used = feedHeaders(data, len);
+        else if (chunked) used = feedChunked(data, len);
+        else used = feedBody(data, len);
+
+        data += used;
+        len -= used;
+    }
+}
+
+size_t AsyncHttp::feedHeaders(const char* data, size_t len) {
+    size_t before = headerBuf.length();
+    headerBuf.concat(data, len);
+
+    int end = headerBuf.indexOf("\r\n\r\n");
+    if (end < 0) {
+        if (headerBuf.length() > ASYNC_HTTP_MAX_HEADER) protocolError(ASYNC_HTTP_ERR_TOO_LARGE);
+        return len;
+    }
+
+    // Bytes deste pacote que vão até o fim do cabeçalho
+    size_t used = (size_t)end + 4 - before;
+    headerBuf.remove(end + 2);   // mantém o último "\r\n" para o parser
+
+    if (!parseHeaders()) {
+        protocolError(ASYNC_HTTP_ERR_PARSE);
+        return len;
+    }
+    headerBuf = String();
+
+    // 1xx informativo: a resposta de verdade vem em seguida
+    if (status < 200) {
+        resetParser();
+        respStarted = true;
+        return used;
+    }
+
+    inHeaders = false;
+    if (contentLength == 0) finishResponse();
+    return used;
+}
+
+bool AsyncHttp::parseHeaders() {
+    // "HTTP/1.1 200 OK"
+    if (!headerBuf.startsWith("HTTP/1.")) return false;
+    bool http10 = headerBuf.startsWith("HTTP/1.0");
+    int sp = headerBuf.indexOf(' ');
+    if (sp < 0) return false;
+    status = headerBuf.substring(sp + 1, sp + 4).toInt();
+    if (status < 100) return false;
+
+    bool keepAliveHeader = false;
+
+    int pos = headerBuf.indexOf("\r\n") + 2;
+    while (pos < (int)headerBuf.length()) {
+        int eol = headerBuf.indexOf("\r\n", pos);
+        if (eol < 0) break;
+
+        int colon = headerBuf.indexOf(':', pos);
+        if (colon > pos && colon < eol) {
+            String name = headerBuf.substring(pos, colon);
+            String value = headerBuf.substring(colon + 1, eol);
+            name.toLowerCase();
+            value.trim();
+            if (name == "etag") respEtag = value;   // comparado como veio
+            value.toLowerCase();
+
+            if (name == "content-length") {
+                contentLength = value.toInt();
+            } else if (name == "transfer-encoding") {
+                chunked = (value.indexOf("chunked") >= 0);
+            } else if (name == "connection") {
+                if (value.indexOf("close") >= 0) respClose = true;
+                if (value.indexOf("keep-alive") >= 0) keepAliveHeader = true;
+            } else if (name == "keep-alive") {
+                // "timeout=5, max=100": fecha 1s antes do servidor
+                int t = value.indexOf("timeout=");
+                if (t >= 0) {
+                    uint32_t serverMs = value.substring(t + 8).toInt() * 1000UL;
+                    uint32_t limit = (serverMs > 1500) ? serverMs - 1000 : 500;
+                    if (limit < idleTimeoutMs) idleTimeoutMs = limit;
+                }
+            }
+        }
+        pos = eol + 2;
+    }
+
+    if (http10 && !keepAliveHeader) respClose = true;
+
+    // Sem corpo por definição
+    if (status == 204 || status == 304) {
+        contentLength = 0;
+        chunked = false;
+    }
+
+    // Chunked prevalece sobre Content-Length (RFC 7230 §3.3.3)
+    if (chunked) contentLength = -1;
+    if (contentLength > ASYNC_HTTP_MAX_BODY) return false;
+
+    // Corpo até o fechamento: não dá para reaproveitar a conexão
+    if (status >= 200 && contentLength < 0 && !chunked) respClose = true;
+
+    if (contentLength > 0) respBody.reserve(contentLength);
+    return true;
+}
+
+size_t AsyncHttp::feedBody(const char* data, size_t len) {
+    size_t n = len;
+    if (contentLength >= 0) {
+        size_t missing = (size_t)contentLength - respBody.length();
+        if (n > missing) n = missing;
+    }
+
+    if (respBody.length() + n > ASYNC_HTTP_MAX_BODY) {
+        protocolError(ASYNC_HTTP_ERR_TOO_LARGE);
+        return len;
+    }
+    respBody.concat(data, n);
+
+    if (contentLength >= 0 && respBody.length() >= (size_t)contentLength) {
+        finishResponse();
+    }
+    return n;
+}
+
+size_t AsyncHttp::feedChunked(const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        switch (chunkState) {
+            case CHUNK_SIZE:
+            case CHUNK_TRAILER: {
+                char ch = data[i++];
+                if (ch == '\r') break;
+                if (ch != '\n') {
+                    if (chunkLine.length() >= 16 && chunkState == CHUNK_SIZE) {
+                        protocolError(ASYNC_HTTP_ERR_PARSE);
+                        return len;
+                    }
+                    if (chunkLine.length() < 64) chunkLine += ch;
+                    break;
+                }
+
+                if (chunkState == CHUNK_TRAILER) {
+                    // Linha vazia encerra os trailers e a resposta; o resto
+                    // do pacote é da próxima (pipelining)
+                    if (chunkLine.length() == 0) {
+                        finishResponse();
+                        return i;
+                    }
+                    chunkLine = "";
+                    break;
+                }
+
+                // Tamanho em hexa; extensões após ';' são ignoradas
+                chunkRemaining = strtoul(chunkLine.c_str(), nullptr, 16);
+                chunkLine = "";
+                chunkState = (chunkRemaining == 0) ? CHUNK_TRAILER : CHUNK_DATA;
+                break;
+            }
+
+            case CHUNK_DATA: {
+                size_t n = len - i;
+                if (n > chunkRemaining) n = chunkRemaining;
+                if (respBody.length() + n > ASYNC_HTTP_MAX_BODY) {
+                    protocolError(ASYNC_HTTP_ERR_TOO_LARGE);
+                    return len;
+                }
+                respBody.concat(data + i, n);
+                i += n;
+                chunkRemaining -= n;
+                if (chunkRemaining == 0) chunkState = CHUNK_DATA_END;
+                break;
+            }
+
+            case CHUNK_DATA_END:
+                // "\r\n" após os dados do bloco
+                if (data[i++] == '\n') chunkState = CHUNK_SIZE;
+                break;
+        }
+    }
+    return i;
+}
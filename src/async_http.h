@@ -0,0 +1,232 @@
+// async_http.h - Cliente HTTP assíncrono (ESPAsyncTCP) com fila limitada
+#pragma once
+
+#include <Arduino.h>
+#include <functional>
+
+class AsyncClient;
+
+// ========================================
+// PARÂMETROS
+// ========================================
+// As chamadas só enfileiram: conexão, envio e leitura acontecem nos
+// callbacks do ESPAsyncTCP (contexto do lwIP), e o resultado é entregue
+// em asyncHttp.loop(), no contexto do loop(), na ordem da fila.
+//
+// Uma conexão HTTP/1.1 persistente com o servidor: a primeira resposta
+// sem "Connection: close" libera o pipelining (até PIPELINE_DEPTH
+// requisições enviadas sem esperar resposta). A conexão ociosa é fechada
+// antes do KeepAliveTimeout do servidor; se ele fechar uma conexão
+// reaproveitada antes de responder, a requisição é reenviada numa nova.
+//
+// O prazo conta do enfileiramento: uma requisição que passa o prazo na
+// fila nem é enviada (o dado já está velho), e uma que passa o prazo em
+// andamento derruba a conexão (as que estavam atrás voltam para a fila).
+
+#define ASYNC_HTTP_QUEUE_SIZE       8
+#define ASYNC_HTTP_DEADLINE_MS      10000UL
+#define ASYNC_HTTP_IDLE_TIMEOUT_MS  4000UL    // Apache: KeepAliveTimeout 5s
+#define ASYNC_HTTP_PIPELINE_DEPTH   4
+#define ASYNC_HTTP_MAX_ATTEMPTS     2         // envio original + 1 reenvio
+#define ASYNC_HTTP_MAX_HEADER       1024      // cabeçalho da resposta
+#define ASYNC_HTTP_MAX_BODY         8192      // corpo da resposta
+
+#define ASYNC_HTTP_CT_JSON          "application/json"
+#define ASYNC_HTTP_CT_MSGPACK       "application/msgpack"
+
+enum AsyncHttpMethod : uint8_t {
+    ASYNC_HTTP_GET = 0,
+    ASYNC_HTTP_POST
+};
+
+// Códigos negativos em AsyncHttpResponse::status
+enum AsyncHttpError : int8_t {
+    ASYNC_HTTP_ERR_CONNECT      = -1,   // DNS ou TCP falhou
+    ASYNC_HTTP_ERR_TIMEOUT      = -2,   // prazo vencido
+    ASYNC_HTTP_ERR_DISCONNECTED = -3,   // conexão caiu no meio da resposta
+    ASYNC_HTTP_ERR_TOO_LARGE    = -4,   // resposta maior que os limites
+    ASYNC_HTTP_ERR_PARSE        = -5,   // resposta HTTP malformada
+    ASYNC_HTTP_ERR_NO_WIFI      = -6
+};
+
+struct AsyncHttpResponse {
+    int status;           // código HTTP (> 0) ou AsyncHttpError (< 0)
+    String body;
+    String etag;          // cabeçalho ETag (vazio se não veio)
+    uint32_t elapsedMs;   // do enfileiramento à resposta
+
+    bool ok() const { return status >= 200 && status < 300; }
+    bool notModified() const { return status == 304; }
+};
+
+typedef std::function<void(AsyncHttpResponse& resp)> AsyncHttpCallback;
+
+// ========================================
+// CLASSE
+// ========================================
+
+class AsyncHttp {
+public:
+    AsyncHttp();
+
+    // URL base "http://host[:porta]/prefixo/"
+    void begin(const char* baseUrl);
+
+    // Enfileira; false = fila cheia (o callback não é chamado). O corpo
+    // pode ser binário (MessagePack); contentType deve ser um literal.
+    // Passe o corpo com std::move: ele é enviado direto do buffer da fila,
+    // sem cópia. ifNoneMatch (ETag de uma resposta anterior) torna o GET
+    // condicional: sem mudança, o servidor responde 304 sem corpo
+    bool request(AsyncHttpMethod method, const String& path, String body,
+                 AsyncHttpCallback callback = nullptr,
+                 uint32_t deadlineMs = ASYNC_HTTP_DEADLINE_MS,
+                 const char* contentType = ASYNC_HTTP_CT_JSON,
+                 const String& ifNoneMatch = String());
+
+    // Chamar a cada passe do loop(): prazos, envio e entrega dos resultados
+    void loop();
+
+    uint8_t pending() const { return count; }
+    bool isConnected() const { return client != nullptr && conn == CONN_READY; }
+
+    // Métricas desde o boot
+    uint32_t getCompleted() const { return completed; }
+    uint32_t getFailed() const { return failed; }
+    uint32_t getTimeouts() const { return timeouts; }
+    uint32_t getDropped() const { return dropped; }
+    uint32_t getLastLatencyMs() const { return lastLatencyMs; }
+    uint32_t getMaxLatencyMs() const { return maxLatencyMs; }
+    uint32_t getAvgLatencyMs() const { return completed ? latencySumMs / completed : 0; }
+    uint32_t getConnects() const { return connects; }
+    uint32_t getRequestsSent() const { return requestsSent; }
+    uint32_t getReusedSent() const { return reusedSent; }
+    uint32_t getPipelined() const { return pipelined; }
+    uint32_t getRetries() const { return retries; }
+
+    // % das requisições enviadas numa conexão já usada
+    uint8_t getReusePercent() const {
+        return requestsSent ? (uint8_t)((uint64_t)reusedSent * 100 / requestsSent) : 0;
+    }
+
+private:
+    enum ReqState : uint8_t {
+        REQ_QUEUED = 0,   // esperando envio
+        REQ_SENT,         // enviada, esperando resposta
+        REQ_DONE          // resultado pronto para entrega
+    };
+
+    // Fila: [DONE ... | SENT ... | QUEUED ...] a partir de head
+    struct Request {
+        AsyncHttpMethod method;
+        ReqState state;
+        uint8_t attempts;
+        bool reused;          // enviada numa conexão que já tinha respondido
+        int result;
+        String path;
+        String body;          // corpo da requisição; depois, o da resposta
+        String etag;          // If-None-Match; depois, o ETag da resposta
+        const char* contentType;
+        AsyncHttpCallback callback;
+        uint32_t enqueuedMs;
+        uint32_t deadlineMs;
+    };
+
+    enum ConnState : uint8_t {
+        CONN_NONE = 0,
+        CONN_CONNECTING,
+        CONN_READY
+    };
+
+    enum ChunkState : uint8_t {
+        CHUNK_SIZE = 0,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        CHUNK_TRAILER
+    };
+
+    Request& at(uint8_t offset) { return queue[(head + offset) % ASYNC_HTTP_QUEUE_SIZE]; }
+
+    // Contexto do loop()
+    void deliver();
+    void checkDeadlines();
+    void sendQueued();
+    void openConnection();
+    void closeClient();
+    void dropConnection(int error, bool allowRetry);
+    void markDone(int result);
+    void appendRequest(Request& r);
+
+    // Contexto do lwIP
+    void pump();
+    void buildHeader(const Request& r);
+    bool writeSegment(const String& data, bool& added);
+    void onData(const char* data, size_t len);
+    size_t feedHeaders(const char* data, size_t len);
+    bool parseHeaders();
+    size_t feedBody(const char* data, size_t len);
+    size_t feedChunked(const char* data, size_t len);
+    void finishResponse();
+    void resetParser();
+    void protocolError(int error);
+
+    Request queue[ASYNC_HTTP_QUEUE_SIZE];
+    uint8_t head;
+    uint8_t count;
+    uint8_t answered;         // DONE no início da fila
+    uint8_t inflight;         // SENT logo depois delas
+
+    // Servidor
+    String host;
+    String basePath;
+    uint16_t port;
+
+    // Conexão
+    AsyncClient* client;
+    volatile ConnState conn;
+    volatile bool connLost;
+    bool connCloseAfter;      // servidor pediu Connection: close
+    bool pipelineOk;          // keep-alive confirmado nesta conexão
+    uint16_t connServed;      // respostas recebidas nesta conexão
+    uint32_t lastActivityMs;
+    uint32_t idleTimeoutMs;
+    int protoError;           // erro de protocolo a atribuir à atual
+
+    // Envio: o cabeçalho é montado quando a requisição chega à vez e o
+    // corpo sai direto de r.body, sem ser copiado para um buffer de envio
+    String tx;                // cabeçalho da requisição em queue[txSlot]
+    size_t txOffset;          // bytes já escritos do trecho atual
+    uint8_t txSlot;           // índice absoluto em queue[]
+    uint8_t txPending;        // SENT ainda não escritas por inteiro
+    bool txInBody;            // escrevendo o corpo (cabeçalho já foi)
+
+    // Resposta em andamento (da requisição em at(answered))
+    bool inHeaders;
+    bool respStarted;
+    bool respClose;
+    String headerBuf;
+    int status;
+    int32_t contentLength;    // -1 = até fechar a conexão
+    bool chunked;
+    ChunkState chunkState;
+    uint32_t chunkRemaining;
+    String chunkLine;
+    String respBody;
+    String respEtag;
+
+    // Métricas
+    uint32_t completed;
+    uint32_t failed;
+    uint32_t timeouts;
+    uint32_t dropped;
+    uint32_t lastLatencyMs;
+    uint32_t maxLatencyMs;
+    uint32_t latencySumMs;
+    uint32_t connects;
+    uint32_t requestsSent;
+    uint32_t reusedSent;
+    uint32_t pipelined;
+    uint32_t retries;
+};
+
+// Instância global
+extern AsyncHttp asyncHttp;
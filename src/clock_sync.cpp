@@ -0,0 +1,279 @@
+// clock_sync.cpp - Relógio disciplinado (SNTP assíncrono + correção de deriva)
+#include "clock_sync.h"
+#include <coredecls.h>
+#include <sys/time.h>
+#include <Preferences.h>
+#include "preferences_layout.h"
+#include "debug_config.h"
+
+// ========================================
+// ESTADO
+// ========================================
+
+// Âncora: epoch (ms) conhecido no instante monotônico anchorMono (ms)
+static int64_t anchorEpochMs = 0;
+static uint64_t anchorMono = 0;
+static bool anchorValid = false;
+static bool synced = false;
+
+// Base da medida de deriva (última sync usada como referência)
+static int64_t driftBaseEpochMs = 0;
+static uint64_t driftBaseMono = 0;
+static float driftPpm = 0.0f;
+static bool driftCalibrated = false;
+
+static int64_t lastReturnedMs = 0;
+static int32_t lastOffsetMs = 0;
+static uint32_t syncCount = 0;
+static uint64_t lastBackupMono = 0;
+static bool backupPending = false;
+
+// Preenchidos no callback do SNTP, processados no clockLoop()
+static const char* ntpServers[3] = { nullptr, nullptr, nullptr };
+
+static volatile bool syncPending = false;
+static int64_t pendingEpochMs = 0;
+static uint64_t pendingMono = 0;
+
+static inline uint64_t monoMs() {
+    return micros64() / 1000ULL;
+}
+
+// Extrapola a âncora até 'mono' corrigindo pela deriva
+static int64_t predictEpochMs(uint64_t mono) {
+    int64_t elapsed = (int64_t)(mono - anchorMono);
+    return anchorEpochMs + elapsed + (int64_t)((double)elapsed * driftPpm * 1e-6);
+}
+
+// ========================================
+// CALLBACK DO SNTP
+// ========================================
+// Roda no contexto da pilha de rede: só copia a amostra
+
+static void onTimeSet(bool fromSntp) {
+    (void)fromSntp;
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    if (tv.tv_sec < CLOCK_VALID_EPOCH) return;
+
+    pendingEpochMs = (int64_t)tv.tv_sec * 1000LL + tv.tv_usec / 1000;
+    pendingMono = monoMs();
+    syncPending = true;
+}
+
+// ========================================
+// PROCESSAMENTO DA SYNC
+// ========================================
+
+static void applySync(int64_t epochMs, uint64_t mono) {
+    if (anchorValid && synced) {
+        lastOffsetMs = (int32_t)(epochMs - predictEpochMs(mono));
+    } else {
+        lastOffsetMs = 0;
+    }
+
+    // Deriva: compara o tempo real decorrido com o do cristal desde a base
+    if (driftBaseMono != 0 && mono - driftBaseMono >= CLOCK_DRIFT_MIN_SPAN_MS) {
+        double local = (double)(mono - driftBaseMono);
+        double real = (double)(epochMs - driftBaseEpochMs);
+        float measured = (float)((real - local) / local * 1e6);
+
+        if (fabsf(measured) <= CLOCK_DRIFT_MAX_PPM) {
+            driftPpm = driftCalibrated
+                ? driftPpm + CLOCK_DRIFT_ALPHA * (measured - driftPpm)
+                : measured;
+            driftCalibrated = true;
+        }
+        #if DEBUG_MAIN
+        else {
+            Serial.printf("[NTP] ⚠️ Deriva medida descartada: %.1f ppm\n", measured);
+        }
+        #endif
+
+        driftBaseEpochMs = epochMs;
+        driftBaseMono = mono;
+    } else if (driftBaseMono == 0 || !synced) {
+        driftBaseEpochMs = epochMs;
+        driftBaseMono = mono;
+    }
+
+    anchorEpochMs = epochMs;
+    anchorMono = mono;
+    anchorValid = true;
+    synced = true;
+    syncCount++;
+    backupPending = true;
+
+    #if DEBUG_MAIN
+    Serial.printf("[NTP] ✅ Sync #%lu: correção %ld ms, deriva %.1f ppm%s\n",
+                  (unsigned long)syncCount, (long)lastOffsetMs, driftPpm,
+                  driftCalibrated ? "" : " (não calibrada)");
+    #endif
+}
+
+static void saveBackup() {
+    if (!synced) return;
+
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    prefs.putULong64(KEY_LAST_EPOCH, (uint64_t)clockNow());
+    if (driftCalibrated) {
+        prefs.putFloat(KEY_CLOCK_DRIFT, driftPpm);
+    }
+    prefs.end();
+
+    lastBackupMono = monoMs();
+    backupPending = false;
+}
+
+// Versões anteriores guardavam o epoch em "ferment" (que o fim de uma
+// fermentação apaga), como u32 no setupNTP() e como u64 em
+// getCurrentEpoch(): lê qualquer das duas e passa para "system"
+static time_t migrateLegacyEpoch() {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_FERMENT, false);
+    if (!prefs.isKey(KEY_LAST_EPOCH)) {
+        prefs.end();
+        return 0;
+    }
+
+    uint64_t epoch = prefs.getULong64(KEY_LAST_EPOCH, 0);
+    if (epoch == 0) epoch = prefs.getULong(KEY_LAST_EPOCH, 0);
+    prefs.remove(KEY_LAST_EPOCH);
+    prefs.remove("lastMillis");   // millis() de outro boot, sem uso
+    prefs.end();
+
+    if (epoch < CLOCK_VALID_EPOCH) return 0;
+
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    prefs.putULong64(KEY_LAST_EPOCH, epoch);
+    prefs.end();
+    return (time_t)epoch;
+}
+
+// Sem SNTP ainda: parte do último epoch salvo. O tempo desligado é
+// desconhecido, então é só um limite inferior.
+static void restoreBackup() {
+    static bool restored = false;
+    if (restored) return;
+    restored = true;
+
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, true);
+    time_t backupEpoch = (time_t)prefs.getULong64(KEY_LAST_EPOCH, 0);
+    float backupDrift = prefs.getFloat(KEY_CLOCK_DRIFT, NAN);
+    prefs.end();
+
+    if (backupEpoch == 0) backupEpoch = migrateLegacyEpoch();
+
+    if (!isnan(backupDrift) && fabsf(backupDrift) <= CLOCK_DRIFT_MAX_PPM) {
+        driftPpm = backupDrift;
+        driftCalibrated = true;
+    }
+
+    if (backupEpoch >= CLOCK_VALID_EPOCH) {
+        anchorEpochMs = (int64_t)backupEpoch * 1000LL;
+        anchorMono = monoMs();
+        anchorValid = true;
+
+        #if DEBUG_MAIN
+        Serial.printf("[NTP] ⚠️ Usando backup do Preferences: epoch %lu\n",
+                      (unsigned long)backupEpoch);
+        #endif
+    }
+}
+
+// ========================================
+// API
+// ========================================
+
+void clockBegin(const char* server1, const char* server2, const char* server3) {
+    static bool callbackSet = false;
+    if (!callbackSet) {
+        settimeofday_cb(onTimeSet);
+        restoreBackup();
+        callbackSet = true;
+    }
+
+    // O SNTP guarda só o ponteiro: os nomes precisam ser persistentes
+    ntpServers[0] = server1;
+    ntpServers[1] = server2;
+    ntpServers[2] = server3;
+    configTime(0, 0, server1, server2, server3);
+
+    #if DEBUG_MAIN
+    Serial.println(F("[NTP] SNTP iniciado em segundo plano"));
+    #endif
+}
+
+void clockForceSync() {
+    // Reconfigurar reinicia o cliente SNTP, que consulta na hora
+    if (!ntpServers[0]) return;
+    configTime(0, 0, ntpServers[0], ntpServers[1], ntpServers[2]);
+}
+
+void clockLoop() {
+    if (syncPending) {
+        noInterrupts();
+        int64_t epochMs = pendingEpochMs;
+        uint64_t mono = pendingMono;
+        syncPending = false;
+        interrupts();
+
+        applySync(epochMs, mono);
+    }
+
+    if (synced && (backupPending || monoMs() - lastBackupMono >= CLOCK_BACKUP_INTERVAL)) {
+        saveBackup();
+    }
+}
+
+time_t clockNow() {
+    // Pode ser chamado antes do clockBegin() (restauração do estado no boot)
+    if (!anchorValid) restoreBackup();
+    if (!anchorValid) return 0;
+
+    int64_t nowMs = predictEpochMs(monoMs());
+
+    // Monotônico: uma sync que atrasa o relógio segura o valor até a hora
+    // real alcançá-lo, em vez de fazer as etapas "voltarem no tempo"
+    if (nowMs < lastReturnedMs && lastReturnedMs - nowMs <= (int64_t)CLOCK_MAX_HOLD_MS) {
+        nowMs = lastReturnedMs;
+    }
+    lastReturnedMs = nowMs;
+
+    return (time_t)(nowMs / 1000);
+}
+
+bool clockIsSynced() {
+    return synced;
+}
+
+uint32_t clockErrorMs() {
+    if (!synced) return CLOCK_ERROR_UNKNOWN;
+
+    float ppm = driftCalibrated ? CLOCK_DRIFT_RESIDUAL_PPM : CLOCK_DRIFT_UNKNOWN_PPM;
+    uint64_t elapsed = monoMs() - anchorMono;
+    return CLOCK_SYNC_ERROR_MS + (uint32_t)((double)elapsed * ppm * 1e-6);
+}
+
+float clockDriftPpm() {
+    return driftPpm;
+}
+
+bool clockDriftCalibrated() {
+    return driftCalibrated;
+}
+
+uint32_t clockSyncCount() {
+    return syncCount;
+}
+
+uint32_t clockSecondsSinceSync() {
+    if (!synced) return 0;
+    return (uint32_t)((monoMs() - anchorMono) / 1000ULL);
+}
+
+int32_t clockLastOffsetMs() {
+    return lastOffsetMs;
+}
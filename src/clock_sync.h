@@ -0,0 +1,54 @@
+// clock_sync.h - Relógio disciplinado (SNTP assíncrono + correção de deriva)
+#pragma once
+
+#include <Arduino.h>
+#include <time.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+
+#define CLOCK_VALID_EPOCH          1577836800L   // 01/01/2020: abaixo disso não há hora
+#define CLOCK_SYNC_ERROR_MS        100UL         // incerteza de uma amostra SNTP
+#define CLOCK_DRIFT_MIN_SPAN_MS    3600000UL     // mede deriva só entre syncs >= 1h
+#define CLOCK_DRIFT_MAX_PPM        500.0f        // medida acima disso é descartada
+#define CLOCK_DRIFT_UNKNOWN_PPM    100.0f        // cristal sem calibração (pior caso)
+#define CLOCK_DRIFT_RESIDUAL_PPM   10.0f         // resíduo após calibração (temperatura)
+#define CLOCK_DRIFT_ALPHA          0.3f          // média móvel da deriva
+#define CLOCK_MAX_HOLD_MS          60000UL       // sync atrasando até 60s: segura; acima, salta
+#define CLOCK_BACKUP_INTERVAL      3600000UL     // backup no Preferences a cada 1h
+#define CLOCK_ERROR_UNKNOWN        0xFFFFFFFFUL
+
+// ========================================
+// API
+// ========================================
+// O SNTP do core roda em segundo plano e avisa cada sincronização por
+// settimeofday_cb. Entre syncs o epoch é extrapolado pelo micros64() com a
+// deriva medida do cristal, e nunca anda para trás. Sem nenhuma sync desde
+// o boot, parte do último backup (limite inferior, erro desconhecido).
+
+// Configura os servidores e o callback (não bloqueia)
+void clockBegin(const char* server1, const char* server2, const char* server3);
+
+// Força nova consulta SNTP
+void clockForceSync();
+
+// Processa syncs pendentes e faz o backup periódico (tarefa do escalonador)
+void clockLoop();
+
+// Epoch disciplinado e monotônico (0 se nunca houve hora válida)
+time_t clockNow();
+
+// true após ao menos uma sync SNTP neste boot
+bool clockIsSynced();
+
+// Erro máximo estimado do clockNow() em ms (CLOCK_ERROR_UNKNOWN sem sync)
+uint32_t clockErrorMs();
+
+// Deriva do cristal em ppm (> 0: millis() atrasa em relação à hora real)
+float clockDriftPpm();
+bool clockDriftCalibrated();
+
+uint32_t clockSyncCount();
+uint32_t clockSecondsSinceSync();
+int32_t clockLastOffsetMs();    // correção aplicada na última sync
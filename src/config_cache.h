@@ -7,6 +7,7 @@
 #include "estruturas.h"
 #include "globais.h"
 #include "debug_config.h"
+#include "control_profiles.h"
 
 // Forward declaration — definida em controle_fermentacao.cpp
 void updateTargetTemperature(float newTemp);
@@ -76,7 +77,7 @@ inline bool loadConfigCache(const char* expectedId) {
         return false;
     }
 
-    // --- Aplica a configuração (mesma lógica do loadConfigParameters) ---
+    // --- Aplica a configuração (mesma lógica do applyConfiguration) ---
 
     const char* name = doc["name"] | "Sem nome";
     fermentacaoState.setConfigName(name);
@@ -105,6 +106,7 @@ inline bool loadConfigCache(const char* expectedId) {
         s.durationDays  = stage["duration"]      | 0.0f;
         s.targetGravity = stage["targetGravity"] | 0.0f;
         s.timeoutDays   = stage["timeoutDays"]   | 0.0f;
+        s.tuningProfile = stage["tuningProfile"] | 0;
 
         s.holdTimeHours = s.durationDays * 24.0f;
         s.maxTimeHours  = s.timeoutDays  * 24.0f;
@@ -116,6 +118,7 @@ inline bool loadConfigCache(const char* expectedId) {
     }
 
     fermentacaoState.totalStages = count;
+    loadTuningProfiles(doc["tuningProfiles"]);
 
     // Aplica temperatura da etapa atual
     if (count > 0 && fermentacaoState.currentStageIndex < count) {
@@ -0,0 +1,141 @@
+// console.cpp - Leitura não bloqueante e tabela de comandos
+#include "console.h"
+#include "telnet.h"
+#include "debug_config.h"
+
+struct ConsoleCommand {
+    const char* name;
+    const char* help;
+    ConsoleHandler handler;
+};
+
+struct ConsoleLine {
+    char buf[CONSOLE_LINE_MAX];
+    uint8_t len;
+    bool overflow;       // linha maior que o buffer: descartada inteira
+    uint8_t iacSkip;     // bytes restantes de negociação telnet (IAC)
+};
+
+static void cmdHelp(const char* args);
+
+static ConsoleCommand commands[CONSOLE_MAX_COMMANDS] = {
+    { "help", "lista os comandos", cmdHelp }
+};
+static uint8_t commandCount = 1;
+
+static ConsoleLine serialLine;
+static ConsoleLine telnetLine;
+
+// ========================================
+// TABELA
+// ========================================
+
+static void cmdHelp(const char* args) {
+    (void)args;
+    char buffer[80];
+
+    consolePrint("\n━━━━━━━━━━━━━━━━ COMANDOS ━━━━━━━━━━━━━━━━");
+    for (uint8_t i = 0; i < commandCount; i++) {
+        if (commands[i].help == nullptr) continue;
+        snprintf(buffer, sizeof(buffer), "%-10s %s", commands[i].name, commands[i].help);
+        consolePrint(buffer);
+    }
+    consolePrint("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
+
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler) {
+    if (commandCount >= CONSOLE_MAX_COMMANDS) {
+        #if DEBUG_MAIN
+        Serial.printf("[Console] ⚠️ Tabela cheia, '%s' ignorado\n", name);
+        #endif
+        return false;
+    }
+
+    commands[commandCount++] = { name, help, handler };
+    return true;
+}
+
+// ========================================
+// EXECUÇÃO
+// ========================================
+
+static void dispatch(char* line) {
+    // Separa "<comando> <args>"
+    while (*line == ' ') line++;
+    if (*line == '\0') return;
+
+    char* args = line;
+    while (*args && *args != ' ') args++;
+    if (*args) {
+        *args++ = '\0';
+        while (*args == ' ') args++;
+    }
+
+    // Remove espaços finais dos argumentos
+    size_t len = strlen(args);
+    while (len > 0 && args[len - 1] == ' ') args[--len] = '\0';
+
+    for (uint8_t i = 0; i < commandCount; i++) {
+        if (strcasecmp(line, commands[i].name) == 0) {
+            commands[i].handler(args);
+            return;
+        }
+    }
+
+    consolePrint(String("[Console] ❓ Comando desconhecido: ") + line + " (digite help)");
+}
+
+static void feed(ConsoleLine& in, int c) {
+    // Telnet: IAC (255) + comando + opção. Negociação é ignorada.
+    if (in.iacSkip > 0) {
+        in.iacSkip--;
+        return;
+    }
+    if (c == 255) {
+        in.iacSkip = 2;
+        return;
+    }
+
+    if (c == '\n' || c == '\r') {
+        if (in.overflow) {
+            consolePrint("[Console] ⚠️ Linha longa demais, ignorada");
+        } else if (in.len > 0) {
+            in.buf[in.len] = '\0';
+            dispatch(in.buf);
+        }
+        in.len = 0;
+        in.overflow = false;
+        return;
+    }
+
+    // Backspace / DEL
+    if (c == 8 || c == 127) {
+        if (in.len > 0) in.len--;
+        return;
+    }
+
+    if (c < 32 || c > 126) return;
+
+    if (in.len >= CONSOLE_LINE_MAX - 1) {
+        in.overflow = true;
+        return;
+    }
+    in.buf[in.len++] = (char)c;
+}
+
+void consoleLoop() {
+    for (uint8_t n = 0; n < CONSOLE_MAX_BYTES && Serial.available() > 0; n++) {
+        feed(serialLine, Serial.read());
+    }
+
+    for (uint8_t n = 0; n < CONSOLE_MAX_BYTES; n++) {
+        int c = telnetRead();
+        if (c < 0) break;
+        feed(telnetLine, c);
+    }
+}
+
+void consolePrint(const String& msg) {
+    Serial.println(msg);
+    telnetLog(msg);
+}
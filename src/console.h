@@ -0,0 +1,29 @@
+// console.h - Console de comandos no Serial e no telnet
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+// Leitura byte a byte do que já chegou, sem esperar fim de linha: um
+// comando pela metade nunca prende o loop(). Cada origem (Serial e
+// telnet) tem seu buffer de linha; a linha é executada no '\n' ou '\r'.
+//
+// Linha: "<comando> [argumentos]". O nome é comparado sem diferenciar
+// maiúsculas; os argumentos chegam ao handler como digitados.
+
+#define CONSOLE_LINE_MAX       64
+#define CONSOLE_MAX_COMMANDS   16
+#define CONSOLE_MAX_BYTES      64    // bytes lidos por origem a cada passe
+
+typedef void (*ConsoleHandler)(const char* args);
+
+// help = nullptr esconde o comando da lista (apelidos)
+bool consoleRegister(const char* name, const char* help, ConsoleHandler handler);
+
+// Chamar a cada passe do loop()
+void consoleLoop();
+
+// Saída dos comandos e diagnósticos: Serial e telnet
+void consolePrint(const String& msg);
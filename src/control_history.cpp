@@ -0,0 +1,38 @@
+// control_history.cpp - Anel de amostras do controle
+#include "control_history.h"
+#include "BrewPiTempControl.h"
+
+static ControlSample samples[HISTORY_MAX_SAMPLES];
+static uint8_t head = 0;      // próxima posição a gravar
+static uint8_t count = 0;
+static unsigned long lastSampleMs = 0;
+
+void historyRecord(unsigned long nowMs) {
+    if (count > 0 && nowMs - lastSampleMs < HISTORY_INTERVAL_MS) return;
+    lastSampleMs = nowMs;
+
+    ControlSample& s = samples[head];
+    s.ms            = nowMs;
+    s.beer          = brewPiControl.getBeerTemp();
+    s.beerSetting   = brewPiControl.getBeerSetting();
+    s.fridge        = brewPiControl.getFridgeTemp();
+    s.fridgeSetting = brewPiControl.getFridgeSetting();
+    s.heaterDuty    = brewPiControl.getHeaterDuty();
+    s.state         = brewPiControl.getState();
+    s.mode          = (uint8_t)brewPiControl.getMode();
+
+    head = (head + 1) % HISTORY_MAX_SAMPLES;
+    if (count < HISTORY_MAX_SAMPLES) count++;
+}
+
+uint8_t historyCount() {
+    return count;
+}
+
+bool historyGet(uint8_t age, ControlSample& out) {
+    if (age >= count) return false;
+
+    uint8_t idx = (head + HISTORY_MAX_SAMPLES - 1 - age) % HISTORY_MAX_SAMPLES;
+    out = samples[idx];
+    return true;
+}
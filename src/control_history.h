@@ -0,0 +1,36 @@
+// control_history.h - Histórico curto das amostras do controle (console)
+#pragma once
+
+#include <Arduino.h>
+#include "BrewPiStructs.h"
+
+// ========================================
+// PARÂMETROS
+// ========================================
+
+#define HISTORY_MAX_SAMPLES   60       // 1h com uma amostra por minuto
+#define HISTORY_INTERVAL_MS   60000UL
+
+// Temperaturas em fixed-point, como no BrewPiTempControl (16 bytes)
+struct ControlSample {
+    uint32_t ms;
+    temperature beer;
+    temperature beerSetting;
+    temperature fridge;
+    temperature fridgeSetting;
+    uint16_t heaterDuty;     // permil
+    uint8_t state;
+    uint8_t mode;
+};
+
+// ========================================
+// API
+// ========================================
+
+// Chamar a cada tick do controle; grava uma amostra por HISTORY_INTERVAL_MS
+void historyRecord(unsigned long nowMs);
+
+uint8_t historyCount();
+
+// age 0 = amostra mais recente
+bool historyGet(uint8_t age, ControlSample& out);
@@ -0,0 +1,240 @@
+// control_profiles.cpp - Aplicação dos perfis de sintonia ao BrewPi
+#include "control_profiles.h"
+#include "BrewPiStructs.h"
+#include "BrewPiTempControl.h"
+#include "debug_config.h"
+#include "console.h"
+#include <stddef.h>
+
+// ========================================
+// PERFIS EMBUTIDOS
+// ========================================
+
+static const TuningProfile BUILTIN_PROFILES[] = {
+    // Suave: geladeira perto da cerveja, banda estreita, sem chutes do P
+    { TUNING_PROFILE_GENTLE, 3.0f, NAN, NAN, 0.5f, -0.5f, 5.0f, NAN, -1, -1, -1, -1 },
+    // Crash: P forte, geladeira pode descer abaixo de 1°C para puxar a cerveja
+    { TUNING_PROFILE_CRASH,  8.0f, NAN, NAN, 1.5f, -1.5f, 15.0f, -2.0f, -1, 600, -1, -1 }
+};
+
+static TuningProfile serverProfiles[MAX_TUNING_PROFILES];
+static uint8_t serverProfileCount = 0;
+static uint8_t activeProfile = TUNING_PROFILE_DEFAULT;
+
+// ========================================
+// CARGA DO JSON
+// ========================================
+
+static float jsonFloatOrNan(JsonVariantConst v) {
+    if (v.isNull()) return NAN;
+    // O PHP pode mandar DECIMAL como string
+    if (v.is<const char*>()) return atof(v.as<const char*>());
+    return v.as<float>();
+}
+
+static int32_t jsonSecondsOrUnset(JsonVariantConst v) {
+    if (v.isNull()) return -1;
+    if (v.is<const char*>()) return atol(v.as<const char*>());
+    return v.as<int32_t>();
+}
+
+void loadTuningProfiles(JsonVariantConst profiles) {
+    serverProfileCount = 0;
+
+    for (JsonVariantConst profileVar : profiles.as<JsonArrayConst>()) {
+        if (serverProfileCount >= MAX_TUNING_PROFILES) break;
+
+        JsonObjectConst p = profileVar.as<JsonObjectConst>();
+        uint8_t id = p["id"] | 0;
+        if (id == TUNING_PROFILE_DEFAULT) continue;
+
+        TuningProfile& t = serverProfiles[serverProfileCount++];
+        t.id              = id;
+        t.Kp              = jsonFloatOrNan(p["Kp"]);
+        t.Ki              = jsonFloatOrNan(p["Ki"]);
+        t.Kd              = jsonFloatOrNan(p["Kd"]);
+        t.idleRangeHigh   = jsonFloatOrNan(p["idleRangeHigh"]);
+        t.idleRangeLow    = jsonFloatOrNan(p["idleRangeLow"]);
+        t.pidMax          = jsonFloatOrNan(p["pidMax"]);
+        t.tempSettingMin  = jsonFloatOrNan(p["tempSettingMin"]);
+        t.minCoolTime     = jsonSecondsOrUnset(p["minCoolTime"]);
+        t.minCoolIdleTime = jsonSecondsOrUnset(p["minCoolIdleTime"]);
+        t.minHeatTime     = jsonSecondsOrUnset(p["minHeatTime"]);
+        t.minHeatIdleTime = jsonSecondsOrUnset(p["minHeatIdleTime"]);
+    }
+
+    #if DEBUG_BREWPI
+    Serial.printf("[Perfis] 📋 %u perfis de sintonia do servidor\n", serverProfileCount);
+    #endif
+}
+
+// ========================================
+// APLICAÇÃO
+// ========================================
+
+static const TuningProfile* findProfile(uint8_t id) {
+    for (uint8_t i = 0; i < serverProfileCount; i++) {
+        if (serverProfiles[i].id == id) return &serverProfiles[i];
+    }
+    for (const TuningProfile& p : BUILTIN_PROFILES) {
+        if (p.id == id) return &p;
+    }
+    return nullptr;
+}
+
+static void overrideTemp(temperature& field, float value) {
+    if (!isnan(value)) field = floatToTempDiff(value);
+}
+
+static void overrideSeconds(uint16_t& field, int32_t value) {
+    if (value >= 0) field = (uint16_t)constrain(value, 0L, 65535L);
+}
+
+void applyTuningProfile(uint8_t id) {
+    const TuningProfile* p = (id == TUNING_PROFILE_DEFAULT) ? nullptr : findProfile(id);
+
+    if (id != TUNING_PROFILE_DEFAULT && !p) {
+        #if DEBUG_BREWPI
+        Serial.printf("[Perfis] ⚠️  Perfil %u desconhecido, usando padrão\n", id);
+        #endif
+        id = TUNING_PROFILE_DEFAULT;
+    }
+
+    // Parte do cc atual: só os campos de sintonia voltam ao padrão
+    ControlConstants c = brewPiControl.cc;
+    const ControlConstants& d = DEFAULT_CONTROL_CONSTANTS;
+    c.Kp              = d.Kp;
+    c.Ki              = d.Ki;
+    c.Kd              = d.Kd;
+    c.idleRangeHigh   = d.idleRangeHigh;
+    c.idleRangeLow    = d.idleRangeLow;
+    c.pidMax          = d.pidMax;
+    c.tempSettingMin  = d.tempSettingMin;
+    c.minCoolTime     = d.minCoolTime;
+    c.minCoolIdleTime = d.minCoolIdleTime;
+    c.minHeatTime     = d.minHeatTime;
+    c.minHeatIdleTime = d.minHeatIdleTime;
+
+    if (p) {
+        overrideTemp(c.Kp, p->Kp);
+        overrideTemp(c.Ki, p->Ki);
+        overrideTemp(c.Kd, p->Kd);
+        overrideTemp(c.idleRangeHigh, p->idleRangeHigh);
+        overrideTemp(c.idleRangeLow, p->idleRangeLow);
+        overrideTemp(c.pidMax, p->pidMax);
+        if (!isnan(p->tempSettingMin)) c.tempSettingMin = floatToTemp(p->tempSettingMin);
+        overrideSeconds(c.minCoolTime, p->minCoolTime);
+        overrideSeconds(c.minCoolIdleTime, p->minCoolIdleTime);
+        overrideSeconds(c.minHeatTime, p->minHeatTime);
+        overrideSeconds(c.minHeatIdleTime, p->minHeatIdleTime);
+    }
+
+    brewPiControl.setConstants(c);
+    activeProfile = id;
+
+    #if DEBUG_BREWPI
+    Serial.printf("[Perfis] 🎛️  Perfil %u aplicado: Kp=%.2f pidMax=%.1f idle=%.1f/%.1f\n",
+                  id, tempDiffToFloat(c.Kp), tempDiffToFloat(c.pidMax),
+                  tempDiffToFloat(c.idleRangeHigh), tempDiffToFloat(c.idleRangeLow));
+    #endif
+}
+
+uint8_t getActiveTuningProfile() {
+    return activeProfile;
+}
+
+// ========================================
+// AJUSTE MANUAL (CONSOLE)
+// ========================================
+
+enum ConstantKind : uint8_t {
+    CC_TEMP_DIFF,   // temperature sem offset (°C de diferença ou fator)
+    CC_U16,
+    CC_U8
+};
+
+struct ConstantField {
+    const char* name;
+    uint8_t kind;
+    uint16_t offset;
+    float minValue;
+    float maxValue;
+};
+
+#define CC_FIELD(f, kind, lo, hi) { #f, kind, (uint16_t)offsetof(ControlConstants, f), lo, hi }
+
+static const ConstantField CONSTANT_FIELDS[] = {
+    CC_FIELD(Kp,                 CC_TEMP_DIFF, -50.0f, 50.0f),
+    CC_FIELD(Ki,                 CC_TEMP_DIFF, -10.0f, 10.0f),
+    CC_FIELD(Kd,                 CC_TEMP_DIFF, -50.0f, 50.0f),
+    CC_FIELD(iMaxError,          CC_TEMP_DIFF, 0.0f,   10.0f),
+    CC_FIELD(idleRangeHigh,      CC_TEMP_DIFF, 0.0f,   10.0f),
+    CC_FIELD(idleRangeLow,       CC_TEMP_DIFF, -10.0f, 0.0f),
+    CC_FIELD(heatingTargetUpper, CC_TEMP_DIFF, -5.0f,  5.0f),
+    CC_FIELD(heatingTargetLower, CC_TEMP_DIFF, -5.0f,  5.0f),
+    CC_FIELD(coolingTargetUpper, CC_TEMP_DIFF, -5.0f,  5.0f),
+    CC_FIELD(coolingTargetLower, CC_TEMP_DIFF, -5.0f,  5.0f),
+    CC_FIELD(pidMax,             CC_TEMP_DIFF, 0.0f,   30.0f),
+    CC_FIELD(heaterPwmBand,      CC_TEMP_DIFF, 0.1f,   10.0f),
+    CC_FIELD(exothermGain,       CC_TEMP_DIFF, 0.0f,   2.0f),
+    CC_FIELD(exothermMax,        CC_TEMP_DIFF, 0.0f,   10.0f),
+    CC_FIELD(minCoolTime,        CC_U16,       0.0f,   7200.0f),
+    CC_FIELD(minCoolIdleTime,    CC_U16,       0.0f,   7200.0f),
+    CC_FIELD(minHeatTime,        CC_U16,       0.0f,   7200.0f),
+    CC_FIELD(minHeatIdleTime,    CC_U16,       0.0f,   7200.0f),
+    CC_FIELD(mutexDeadTime,      CC_U16,       0.0f,   7200.0f),
+    CC_FIELD(heaterPwm,          CC_U8,        0.0f,   1.0f),
+    CC_FIELD(heaterPwmPeriod,    CC_U16,       10.0f,  60.0f),
+    CC_FIELD(fridgeLoopMs,       CC_U16,       1000.0f, 60000.0f),
+    CC_FIELD(beerLoopPeriod,     CC_U16,       5.0f,   3600.0f),
+    CC_FIELD(integralPeriod,     CC_U16,       30.0f,  7200.0f)
+};
+
+static float readConstant(const ControlConstants& c, const ConstantField& f) {
+    const uint8_t* base = (const uint8_t*)&c + f.offset;
+
+    switch (f.kind) {
+        case CC_TEMP_DIFF: return tempDiffToFloat(*(const temperature*)base);
+        case CC_U16:       return *(const uint16_t*)base;
+        default:           return *base;
+    }
+}
+
+bool setControlConstant(const char* name, float value) {
+    for (const ConstantField& f : CONSTANT_FIELDS) {
+        if (strcasecmp(name, f.name) != 0) continue;
+        if (isnan(value) || value < f.minValue || value > f.maxValue) return false;
+
+        ControlConstants c = brewPiControl.cc;
+        uint8_t* base = (uint8_t*)&c + f.offset;
+
+        switch (f.kind) {
+            case CC_TEMP_DIFF: *(temperature*)base = floatToTempDiff(value); break;
+            case CC_U16:       *(uint16_t*)base = (uint16_t)lroundf(value); break;
+            default:           *base = (uint8_t)lroundf(value); break;
+        }
+
+        // setConstants grava snapshot no trace, se estiver gravando
+        brewPiControl.setConstants(c);
+        return true;
+    }
+    return false;
+}
+
+void printControlConstants() {
+    char buffer[64];
+
+    snprintf(buffer, sizeof(buffer), "\n[cc] Perfil %u (ajustes valem até a próxima troca)",
+             activeProfile);
+    consolePrint(buffer);
+
+    for (const ConstantField& f : CONSTANT_FIELDS) {
+        float v = readConstant(brewPiControl.cc, f);
+        if (f.kind == CC_TEMP_DIFF) {
+            snprintf(buffer, sizeof(buffer), "  %-20s %8.3f", f.name, v);
+        } else {
+            snprintf(buffer, sizeof(buffer), "  %-20s %8.0f", f.name, v);
+        }
+        consolePrint(buffer);
+    }
+}
@@ -0,0 +1,63 @@
+// control_profiles.h - Perfis de sintonia do controle por etapa
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ========================================
+// PERFIS DE SINTONIA
+// ========================================
+// Cada etapa da fermentação pode indicar um perfil (FermentationStage::
+// tuningProfile). O perfil sobrescreve apenas os campos informados de
+// DEFAULT_CONTROL_CONSTANTS; o resto do cc fica no padrão.
+//
+// Os perfis vêm em "tuningProfiles" no JSON de api/esp/config.php. Se o
+// servidor não enviar o id pedido, vale o perfil embutido de mesmo id.
+//
+//   0 = padrão (DEFAULT_CONTROL_CONSTANTS)
+//   1 = suave  (manter fermentação sem overshoot)
+//   2 = crash  (cold crash rápido)
+
+#define TUNING_PROFILE_DEFAULT  0
+#define TUNING_PROFILE_GENTLE   1
+#define TUNING_PROFILE_CRASH    2
+
+#define MAX_TUNING_PROFILES     6
+
+// NAN / -1 = campo não informado (mantém o padrão)
+struct TuningProfile {
+    uint8_t id;
+    float Kp;
+    float Ki;
+    float Kd;
+    float idleRangeHigh;        // °C
+    float idleRangeLow;         // °C
+    float pidMax;               // °C
+    float tempSettingMin;       // °C
+    int32_t minCoolTime;        // s
+    int32_t minCoolIdleTime;    // s
+    int32_t minHeatTime;        // s
+    int32_t minHeatIdleTime;    // s
+};
+
+// Substitui os perfis do servidor pelos de doc["tuningProfiles"]
+void loadTuningProfiles(JsonVariantConst profiles);
+
+// Aplica o perfil ao brewPiControl (id desconhecido = padrão)
+void applyTuningProfile(uint8_t id);
+
+// Perfil aplicado por último
+uint8_t getActiveTuningProfile();
+
+// ========================================
+// AJUSTE MANUAL (CONSOLE)
+// ========================================
+// Muda uma constante do cc em operação, sem gravar. Vale até a próxima
+// troca de perfil (etapa nova ou reboot). Temperaturas em °C de
+// diferença; tempos em segundos (fridgeLoopMs em ms).
+
+// false = nome desconhecido ou valor fora da faixa
+bool setControlConstant(const char* name, float value);
+
+// Lista as constantes ajustáveis e o valor atual
+void printControlConstants();
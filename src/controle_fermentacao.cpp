@@ -19,6 +19,10 @@
 #include "mysql_sender.h"
 #include "http_commands.h"
 #include "config_cache.h"
+#include "exotherm_estimator.h"
+#include "control_profiles.h"
+#include "clock_sync.h"
+#include "coroutine.h"
 
 extern FermentadorHTTPClient httpClient;
 
@@ -28,7 +32,6 @@ Preferences prefsFerment;
 // =====================================================
 // VARIÁVEIS DE CONTROLE
 // =====================================================
-unsigned long lastActiveCheck = 0;
 char lastActiveId[64] = "";
 bool isFirstCheck = true;
 bool stageStarted = false;
@@ -92,57 +95,17 @@ String formatTime(time_t timestamp) {
     return String(buffer);
 }
 
+// Epoch disciplinado (clock_sync): monotônico, com deriva corrigida e
+// backup no Preferences feito fora daqui
 time_t getCurrentEpoch() {
-    static time_t lastValidEpoch = 0;
-    static unsigned long lastValidMillis = 0;
-    static bool epochInitialized = false;
-    
-    time_t now = time(nullptr);
-    
-    if (now < 1577836800L) {
-        if (!epochInitialized) {
-            prefsFerment.begin("ferment", true);  // read-only
-            
-            lastValidEpoch = (time_t)prefsFerment.getULong64("lastEpoch", 0);
-            lastValidMillis = prefsFerment.getULong("lastMillis", 0);
-            
-            prefsFerment.end();
-            epochInitialized = true;
+    time_t now = clockNow();
 
-            #if DEBUG_FERMENTATION
-            if (lastValidEpoch > 1577836800L) {
-                Serial.print(F("[NTP] ⚠️  Usando backup Preferences: "));
-                Serial.println(formatTime(lastValidEpoch));
-            }
-            #endif
-        }
-        
-        if (lastValidEpoch > 1577836800L) {
-            return lastValidEpoch + ((millis() - lastValidMillis) / 1000);
-        }
-        
-        #if DEBUG_FERMENTATION
+    #if DEBUG_FERMENTATION
+    if (now == 0) {
         Serial.println(F("[NTP] ⚠️  Relógio não sincronizado!"));
-        #endif
-
-        return 0;
-    }
-    
-    static unsigned long lastBackup = 0;
-    if (millis() - lastBackup > 60000) {
-        lastValidEpoch = now;
-        lastValidMillis = millis();
-        
-        prefsFerment.begin("ferment", false);  // read-write
-        
-        prefsFerment.putULong64("lastEpoch", (uint64_t)lastValidEpoch);
-        prefsFerment.putULong("lastMillis", lastValidMillis);
-        
-        prefsFerment.end();
-        
-        lastBackup = millis();
     }
-    
+    #endif
+
     return now;
 }
 
@@ -360,8 +323,8 @@ void loadStateFromPreferences() {
     Serial.println(F(" ║"));
 
     if (fermentacaoState.stageStartEpoch > 0) {
-        time_t now = time(nullptr);
-        if (now > 1577836800L) {
+        time_t now = getCurrentEpoch();
+        if (now > CLOCK_VALID_EPOCH) {
             float elapsed = difftime(now, fermentacaoState.stageStartEpoch) / 3600.0f;
 
             Serial.println(F("╠════════════════════════════════════════════╣"));
@@ -470,6 +433,8 @@ void deactivateCurrentFermentation() {
     #endif
 
     brewPiControl.reset();
+    exothermReset();
+    applyTuningProfile(TUNING_PROFILE_DEFAULT);
     
     fermentacaoState.activeId[0] = '\0';
     lastActiveId[0] = '\0';
@@ -544,36 +509,98 @@ void setupActiveListener() {
 // VERIFICAÇÃO DE COMANDOS DO SITE E FERMENTAÇÃO ATIVA
 // =====================================================
 
-void getTargetFermentacao() {
-    unsigned long now = millis();
+static bool activeCheckPending = false;
 
-    if (!isFirstCheck && (now - lastActiveCheck < ACTIVE_CHECK_INTERVAL)) {
-        return;
+// GET condicional do esp/active: ETag da última resposta reconciliada e
+// marca do estado local logo depois dela. Com os dois iguais, um 304 quer
+// dizer que reconciliar de novo daria no mesmo
+static String activeEtag;
+static uint32_t activeLocalMark = 0;
+static bool activeResync = true;   // correção enviada ou carga pendente: consulta completa
+
+static void processActiveFermentation(JsonDocument& doc);
+
+// FNV-1a dos campos que a reconciliação compara com o servidor
+static uint32_t markMix(uint32_t h, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    while (len--) {
+        h ^= *p++;
+        h *= 16777619UL;
     }
+    return h;
+}
 
-    lastActiveCheck = now;
-    
+static uint32_t localSyncMark() {
+    uint32_t h = 2166136261UL;
+    h = markMix(h, fermentacaoState.activeId, strlen(fermentacaoState.activeId));
+    h = markMix(h, lastActiveId, strlen(lastActiveId));
+    h = markMix(h, &fermentacaoState.active, sizeof(fermentacaoState.active));
+    h = markMix(h, &fermentacaoState.paused, sizeof(fermentacaoState.paused));
+    h = markMix(h, &fermentacaoState.concluidaMantendoTemp,
+                sizeof(fermentacaoState.concluidaMantendoTemp));
+    h = markMix(h, &fermentacaoState.currentStageIndex,
+                sizeof(fermentacaoState.currentStageIndex));
+    h = markMix(h, &fermentacaoState.totalStages, sizeof(fermentacaoState.totalStages));
+    h = markMix(h, &fermentacaoState.stageStartEpoch, sizeof(fermentacaoState.stageStartEpoch));
+    h = markMix(h, &fermentacaoState.targetReachedSent,
+                sizeof(fermentacaoState.targetReachedSent));
+    return h;
+}
+
+// Cadência: tarefa "ativa" do escalonador (ACTIVE_CHECK_INTERVAL)
+// Só enfileira a consulta; a resposta é tratada em processActiveFermentation()
+void getTargetFermentacao() {
     if (WiFi.status() != WL_CONNECTED) {
         LOG_FERMENTATION(F("[MySQL] WiFi desconectado"));
         isFirstCheck = false;
         return;
     }
 
+    // A anterior ainda não voltou (fila cheia ou servidor lento)
+    if (activeCheckPending) return;
+
     LOG_FERMENTATION(F("\n========================================"));
     LOG_FERMENTATION(F("[MySQL] INICIANDO BUSCA DE FERMENTAÇÃO"));
     LOG_FERMENTATION(F("========================================"));
 
-    JsonDocument doc;
-    
-    bool requestOk = httpClient.getActiveFermentation(doc);
-    
-    LOG_FERMENTATION("[MySQL] getActiveFermentation() retornou: " + String(requestOk ? "TRUE" : "FALSE"));
-    
-    if (!requestOk) {
-        LOG_FERMENTATION(F("[MySQL] Falha na requisição HTTP"));
-        isFirstCheck = false;
-        return;
-    }
+    // Só condicional se nada mudou localmente e não há proteção em curso
+    bool conditional = !activeResync && justResumedCycles == 0 &&
+                       !justBootedWithState && localSyncMark() == activeLocalMark;
+
+    activeCheckPending = httpClient.getActiveFermentation([](bool ok, JsonDocument& doc) {
+        activeCheckPending = false;
+
+        LOG_FERMENTATION("[MySQL] getActiveFermentation() retornou: " + String(ok ? "TRUE" : "FALSE"));
+
+        if (!ok) {
+            LOG_FERMENTATION(F("[MySQL] Falha na requisição HTTP"));
+            isFirstCheck = false;
+            return;
+        }
+
+        if (doc.isNull()) {
+            LOG_FERMENTATION(F("[MySQL] Sem mudança no servidor (304): reconciliação dispensada"));
+            isFirstCheck = false;
+            checkPendingCommands();
+            return;
+        }
+
+        String etag = httpClient.getLastEtag();
+        activeResync = false;
+        processActiveFermentation(doc);
+
+        activeEtag = etag;
+        activeLocalMark = localSyncMark();
+    }, conditional ? activeEtag : String());
+
+    if (!activeCheckPending) isFirstCheck = false;
+}
+
+bool isActiveCheckPending() {
+    return activeCheckPending;
+}
+
+static void processActiveFermentation(JsonDocument& doc) {
 
     #if DEBUG_FERMENTATION
     Serial.println(F("\n[MySQL] DOCUMENTO JSON RECEBIDO:"));
@@ -663,31 +690,18 @@ void getTargetFermentacao() {
             fermentacaoState.currentStageIndex    = serverStageIndex;
             safe_strcpy(lastActiveId, id, sizeof(lastActiveId));
 
-            LOG_FERMENTATION("[MySQL] Carregando configuração ID: " + String(id));
-            loadConfigParameters(id);
-
             stageStarted                        = false;
             fermentacaoState.targetReachedSent  = false;
             fermentacaoState.stageStartEpoch    = 0;
+            fermentacaoState.totalStages        = 0;   // etapas antigas não valem mais
             justResumedCycles                   = 0;
 
             saveStateToPreferences();
 
-            if (httpClient.isConnected()) {
-                temperature beerTemp   = brewPiControl.getBeerTemp();
-                temperature fridgeTemp = brewPiControl.getFridgeTemp();
-                httpClient.sendHeartbeat(
-                    atoi(fermentacaoState.activeId),
-                    brewPiControl.getDetailedStatus(),
-                    beerTemp,
-                    fridgeTemp
-                );
-            }
-            
-            LOG_FERMENTATION(F("[MySQL] CONFIGURAÇÃO CONCLUÍDA"));
-            LOG_FERMENTATION("  activeId: '" + String(fermentacaoState.activeId) + "'");
-            LOG_FERMENTATION("  tempTarget: " + String(fermentacaoState.tempTarget, 1) + "°C");
-            LOG_FERMENTATION("  totalStages: " + String(fermentacaoState.totalStages));
+            // Configuração, cache e heartbeat seguem em corrotina
+            LOG_FERMENTATION("[MySQL] Carregando configuração ID: " + String(id));
+            startConfigLoad(id, true);
+            activeResync = true;   // confere de novo depois da carga
             
         } else {
             // =====================================================
@@ -752,14 +766,12 @@ void getTargetFermentacao() {
             if (fermentacaoState.totalStages == 0) {
                 LOG_FERMENTATION(F("   totalStages = 0 após reboot"));
                 LOG_FERMENTATION(F("  → Recarregando configuração do servidor"));
-                loadConfigParameters(id);
+                startConfigLoad(id, false);
+                activeResync = true;
                 
-                if (fermentacaoState.totalStages > 0) {
-                    LOG_FERMENTATION("  Configuração recarregada: " + 
-                                    String(fermentacaoState.totalStages) + " etapas");
-                } else {
-                    LOG_FERMENTATION(F(" Falha ao recarregar configuração!"));
-                }
+                // Sync de etapa só com as etapas carregadas (próximo ciclo)
+                isFirstCheck = false;
+                return;
             }
 
 unsigned long serverStageStartEpoch = doc["stageStartEpoch"] | 0;
@@ -771,7 +783,11 @@ bool serverTargetReached            = doc["targetReached"] | false;
 // Posta o estado local para corrigir o servidor e não aceita nada dele.
 if (fermentacaoState.targetReachedSent && fermentacaoState.stageStartEpoch > 0) {
     justResumedCycles = 0;
-    if (httpClient.isConnected()) {
+    // Servidor já igual ao local: não há o que corrigir
+    bool serverDiverges = !serverTargetReached ||
+        serverStageStartEpoch != (unsigned long)fermentacaoState.stageStartEpoch;
+    if (serverDiverges && httpClient.isConnected()) {
+        activeResync = true;
         JsonDocument stateDoc;
         stateDoc["config_id"]         = fermentacaoState.activeId;
         stateDoc["stageStartEpoch"]   = (unsigned long)fermentacaoState.stageStartEpoch;
@@ -788,6 +804,7 @@ else if (serverStageStartEpoch > 0 &&
 
     if (justResumedCycles > 0) {
         justResumedCycles--;
+        activeResync = true;
         if (httpClient.isConnected()) {
             JsonDocument stateDoc;
             stateDoc["config_id"]         = fermentacaoState.activeId;
@@ -831,18 +848,21 @@ else if (serverStageStartEpoch > 0 &&
                     LOG_FERMENTATION(F("  → Local à frente - servidor desatualizado"));
                     LOG_FERMENTATION(F("  → Mantendo estado local e notificando servidor"));
                     
+                    activeResync = true;   // confere se o servidor aceitou
                     if (httpClient.isConnected()) {
-                        bool updated = httpClient.updateStageIndex(
+                        int localIndex = fermentacaoState.currentStageIndex;
+                        httpClient.updateStageIndex(
                             fermentacaoState.activeId,
-                            fermentacaoState.currentStageIndex
+                            localIndex,
+                            [localIndex](bool updated) {
+                                if (updated) {
+                                    LOG_FERMENTATION("  → Servidor sincronizado para etapa " + 
+                                                    String(localIndex));
+                                } else {
+                                    LOG_FERMENTATION(F("  → Falha ao sincronizar servidor (tentará novamente)"));
+                                }
+                            }
                         );
-                        
-                        if (updated) {
-                            LOG_FERMENTATION("  → Servidor sincronizado para etapa " + 
-                                            String(fermentacaoState.currentStageIndex));
-                        } else {
-                            LOG_FERMENTATION(F("  → Falha ao sincronizar servidor (tentará novamente)"));
-                        }
                     }
                 }
             } else {
@@ -898,25 +918,19 @@ else if (serverStageStartEpoch > 0 &&
 // =====================================================
 // CONFIGURAÇÃO DE ETAPAS
 // =====================================================
-void loadConfigParameters(const char* configId) {
-    if (!configId || strlen(configId) == 0) {
-        #if DEBUG_FERMENTATION
-        Serial.println(F("[MySQL] ❌ ID inválido"));
-        #endif
-        return;
-    }
 
-    LOG_FERMENTATION("[MySQL] Buscando config: " + String(configId));
-    
-    JsonDocument doc;
-    
-    if (!httpClient.getConfiguration(configId, doc)) {
-        #if DEBUG_FERMENTATION
-        Serial.println(F("[MySQL] ❌ Falha ao buscar configuração"));
-        #endif
-        return;
-    }
+// Estado do fluxo de carga (sobrevive aos pontos de suspensão)
+static char configLoadId[64] = "";
+static bool configHeartbeatAfter = false;
+static JsonDocument configDoc;
+
+// Resposta da busca; a sequência descarta respostas de buscas anteriores
+static uint8_t configFetchSeq = 0;
+static bool configFetchDone = false;
+static bool configFetchOk = false;
 
+// Preenche etapas e perfis a partir do JSON de configuração
+static int applyConfiguration(JsonDocument& doc) {
     fermentacaoState.currentStageIndex = doc["currentStageIndex"] | 0;
     
     const char* name = doc["name"] | "Sem nome";
@@ -953,6 +967,7 @@ void loadConfigParameters(const char* configId) {
         s.durationDays  = jsonToFloat(stage["duration"], 0.0f);
         s.targetGravity = jsonToFloat(stage["targetGravity"], 0.0f);
         s.timeoutDays   = jsonToFloat(stage["timeoutDays"], 0.0f);
+        s.tuningProfile = stage["tuningProfile"] | 0;
         
         s.holdTimeHours = s.durationDays * 24.0f;
         s.maxTimeHours  = s.timeoutDays * 24.0f;
@@ -969,6 +984,7 @@ void loadConfigParameters(const char* configId) {
     }
 
     fermentacaoState.totalStages = count;
+    loadTuningProfiles(doc["tuningProfiles"]);
 
     if (count > 0 && fermentacaoState.currentStageIndex < count) {
         float targetTemp = fermentacaoState.stages[fermentacaoState.currentStageIndex].targetTemp;
@@ -979,12 +995,99 @@ void loadConfigParameters(const char* configId) {
         #endif
     }
 
-    //Salva cache local para uso offline após reboot
-    saveConfigCache(configId, doc);
+    return count;
+}
 
-    #if DEBUG_FERMENTATION
-    Serial.printf("[MySQL] ✅ Configuração carregada: %d etapas\n", count);
-    #endif
+// Busca → aplica → cache → estado, devolvendo o loop() entre os passos
+static CoStatus configLoadFlow(CoState& co) {
+    CO_BEGIN(co);
+
+    LOG_FERMENTATION("[MySQL] Buscando config: " + String(configLoadId));
+
+    configFetchSeq++;
+    configFetchDone = false;
+    configFetchOk = false;
+
+    // Não enfileirou = termina já, como falha
+    {
+        uint8_t seq = configFetchSeq;
+        configFetchDone = !httpClient.getConfiguration(configLoadId,
+            [seq](bool ok, JsonDocument& doc) {
+                if (seq != configFetchSeq) return;
+                configFetchOk = ok;
+                if (ok) configDoc = std::move(doc);
+                configFetchDone = true;
+            });
+    }
+    CO_WAIT_UNTIL(co, configFetchDone);
+
+    if (!configFetchOk) {
+        #if DEBUG_FERMENTATION
+        Serial.println(F("[MySQL] ❌ Falha ao buscar configuração"));
+        #endif
+        configDoc.clear();
+        CO_EXIT(co);
+    }
+
+    // Fermentação trocou durante a busca: descarta
+    if (strcmp(configLoadId, fermentacaoState.activeId) != 0) {
+        configDoc.clear();
+        CO_EXIT(co);
+    }
+
+    {
+        int count = applyConfiguration(configDoc);
+        #if DEBUG_FERMENTATION
+        Serial.printf("[MySQL] ✅ Configuração carregada: %d etapas\n", count);
+        #else
+        (void)count;
+        #endif
+    }
+    CO_YIELD(co);
+
+    // Salva cache local para uso offline após reboot
+    saveConfigCache(configLoadId, configDoc);
+    configDoc.clear();
+    CO_YIELD(co);
+
+    saveStateToPreferences();
+
+    if (configHeartbeatAfter && httpClient.isConnected()) {
+        CO_YIELD(co);
+        httpClient.sendHeartbeat(
+            atoi(fermentacaoState.activeId),
+            brewPiControl.getDetailedStatus(),
+            brewPiControl.getBeerTemp(),
+            brewPiControl.getFridgeTemp()
+        );
+    }
+
+    LOG_FERMENTATION(F("[MySQL] CONFIGURAÇÃO CONCLUÍDA"));
+    LOG_FERMENTATION("  activeId: '" + String(fermentacaoState.activeId) + "'");
+    LOG_FERMENTATION("  tempTarget: " + String(fermentacaoState.tempTarget, 1) + "°C");
+    LOG_FERMENTATION("  totalStages: " + String(fermentacaoState.totalStages));
+
+    CO_END(co);
+}
+
+bool startConfigLoad(const char* configId, bool heartbeatAfter) {
+    if (!configId || strlen(configId) == 0) {
+        #if DEBUG_FERMENTATION
+        Serial.println(F("[MySQL] ❌ ID inválido"));
+        #endif
+        return false;
+    }
+
+    // Uma carga já em andamento para outro ID descarta o resultado dela
+    // (ver checagem de ID no fluxo); a próxima verificação recarrega
+    safe_strcpy(configLoadId, configId, sizeof(configLoadId));
+    configHeartbeatAfter = heartbeatAfter;
+
+    return coStart("config", configLoadFlow);
+}
+
+bool isConfigLoading() {
+    return coIsRunning(configLoadFlow);
 }
 
 // =====================================================
@@ -1025,6 +1128,9 @@ void verificarTrocaDeFase() {
     #endif
     
     if (fermentacaoState.totalStages == 0) {
+        // Etapas ainda chegando do servidor
+        if (isConfigLoading()) return;
+
         #if DEBUG_FERMENTATION
         Serial.println(F("[Fase] ⚠️  0 etapas, desativando..."));
         #endif
@@ -1076,6 +1182,9 @@ void verificarTrocaDeFase() {
         
         stageStarted = true;
         
+        // Sintonia do controle própria da etapa (nova ou restaurada)
+        applyTuningProfile(stage.tuningProfile);
+        
         if (isRestoration) {
             // =====================================================
             // RESTAURAÇÃO: Mantém tudo que foi salvo
@@ -1397,34 +1506,66 @@ void pauseFermentacao() {
     #endif
 }
 
+static bool targetNotifyPending = false;
+
 void verificarTargetAtingido() {
     if (!fermentacaoState.active || fermentacaoState.targetReachedSent) return;
+    if (targetNotifyPending) return;
 
     float currentTemp = getCurrentBeerTemp();
     float diff = abs(currentTemp - fermentacaoState.tempTarget);
 
     if (diff <= TEMPERATURE_TOLERANCE) {
-        if (httpClient.notifyTargetReached(fermentacaoState.activeId)) {
-            fermentacaoState.targetReachedSent = true;
-            #if DEBUG_FERMENTATION
-            Serial.println(F("[MySQL] 🎯 Temperatura alvo atingida!"));
-            #endif
-        } 
-        #if DEBUG_FERMENTATION
-        else {
-            Serial.println(F("[MySQL] ❌ Falha ao notificar alvo"));
-        }
-        #endif
+        String id = fermentacaoState.activeId;
+        targetNotifyPending = httpClient.notifyTargetReached(fermentacaoState.activeId,
+            [id](bool ok) {
+                targetNotifyPending = false;
+
+                // Fermentação trocou enquanto a notificação estava na fila
+                if (id != fermentacaoState.activeId) return;
+
+                if (ok) {
+                    fermentacaoState.targetReachedSent = true;
+                    #if DEBUG_FERMENTATION
+                    Serial.println(F("[MySQL] 🎯 Temperatura alvo atingida!"));
+                    #endif
+                }
+                #if DEBUG_FERMENTATION
+                else {
+                    Serial.println(F("[MySQL] ❌ Falha ao notificar alvo"));
+                }
+                #endif
+            });
     }
 }
 
+static bool statusCheckPending = false;
+
+static void processRemoteStatus(JsonDocument& doc);
+
+// Status do site (pausa/conclusão); a resposta chega em processRemoteStatus()
 void checkPauseOrComplete() {
     if (!fermentacaoState.active && !fermentacaoState.paused) return;
     if (!httpClient.isConnected()) return;
+    if (statusCheckPending) return;
+
+    // Só o status interessa aqui: com o ETag da última resposta, uma
+    // configuração sem mudança volta 304 e não é nem lida
+    static String statusEtag;
+
+    String id = fermentacaoState.activeId;
+    statusCheckPending = httpClient.getConfiguration(fermentacaoState.activeId,
+        [id](bool ok, JsonDocument& doc) {
+            statusCheckPending = false;
+            if (!ok || id != fermentacaoState.activeId) return;
+            if (doc.isNull()) return;   // 304: status igual ao já tratado
+            if (!fermentacaoState.active && !fermentacaoState.paused) return;
+            statusEtag = httpClient.getLastEtag();
+            processRemoteStatus(doc);
+        }, statusEtag);
+}
 
-    JsonDocument doc;
-    if (!httpClient.getConfiguration(fermentacaoState.activeId, doc)) return;
-
+static void processRemoteStatus(JsonDocument& doc) {
     const char* status = doc["status"] | "active";
 
     if (strcmp(status, "paused") == 0) {
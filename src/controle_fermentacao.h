@@ -6,7 +6,6 @@
 #include "definitions.h"
 
 // Variáveis globais
-extern unsigned long lastActiveCheck;
 extern char lastActiveId[64];
 extern bool isFirstCheck;
 extern unsigned long stageStartTime;
@@ -29,12 +28,14 @@ void updateTargetTemperature(float temp);
 void deactivateCurrentFermentation();
 void setupActiveListener();
 
-// HTTP – Fermentação ativa
+// HTTP – Fermentação ativa (só enfileiram; a resposta é tratada depois)
 void getTargetFermentacao();
+bool isActiveCheckPending();
 void checkPauseOrComplete();
 
-// Configuração de etapas
-void loadConfigParameters(const char* configId);
+// Configuração de etapas (corrotina: busca, aplica, grava cache e estado)
+bool startConfigLoad(const char* configId, bool heartbeatAfter);
+bool isConfigLoading();
 
 // Troca de fase
 void verificarTrocaDeFase();
@@ -4,7 +4,9 @@
 struct DetailedControlStatus {
     bool coolerActive;
     bool heaterActive;
+    uint16_t heaterDuty;      // permil, só no aquecedor proporcional
     float estimatedPeak;
+    float feedForward;        // °C de pré-resfriamento da exotermia (≤ 0)
     bool peakDetection;
     String stateName;
     bool isWaiting;
@@ -0,0 +1,81 @@
+// coroutine.cpp - Execução dos fluxos em corrotina
+#include "coroutine.h"
+#include "console.h"
+#include "debug_config.h"
+
+struct CoFlow {
+    const char* name;
+    CoFunction fn;
+    CoState state;
+    uint32_t steps;
+    uint32_t maxStepMs;
+};
+
+static CoFlow flows[CO_MAX_FLOWS];
+
+bool coStart(const char* name, CoFunction fn) {
+    if (coIsRunning(fn)) return false;
+
+    for (uint8_t i = 0; i < CO_MAX_FLOWS; i++) {
+        if (flows[i].fn == nullptr) {
+            flows[i].name = name;
+            flows[i].fn = fn;
+            flows[i].state.line = 0;
+            flows[i].state.waitStart = 0;
+            flows[i].steps = 0;
+            flows[i].maxStepMs = 0;
+            return true;
+        }
+    }
+
+    #if DEBUG_MAIN
+    Serial.printf("[Fluxo] ⚠️ Sem espaço para '%s'\n", name);
+    #endif
+    return false;
+}
+
+bool coIsRunning(CoFunction fn) {
+    for (uint8_t i = 0; i < CO_MAX_FLOWS; i++) {
+        if (flows[i].fn == fn) return true;
+    }
+    return false;
+}
+
+void coRunAll() {
+    for (uint8_t i = 0; i < CO_MAX_FLOWS; i++) {
+        CoFlow& f = flows[i];
+        if (f.fn == nullptr) continue;
+
+        uint32_t start = millis();
+        CoStatus status = f.fn(f.state);
+        uint32_t elapsed = millis() - start;
+
+        f.steps++;
+        if (elapsed > f.maxStepMs) f.maxStepMs = elapsed;
+
+        if (status == CO_DONE) {
+            #if DEBUG_MAIN
+            Serial.printf("[Fluxo] ✅ '%s' concluído (%lu passos, maior %lu ms)\n",
+                          f.name, (unsigned long)f.steps, (unsigned long)f.maxStepMs);
+            #endif
+            f.fn = nullptr;
+        }
+    }
+}
+
+void coPrintStats() {
+    char buffer[80];
+    bool any = false;
+
+    for (uint8_t i = 0; i < CO_MAX_FLOWS; i++) {
+        const CoFlow& f = flows[i];
+        if (f.fn == nullptr) continue;
+
+        snprintf(buffer, sizeof(buffer), "[Fluxo] %-12s passos=%lu maior=%lums",
+                 f.name, (unsigned long)f.steps, (unsigned long)f.maxStepMs);
+        consolePrint(buffer);
+        any = true;
+    }
+
+    if (!any) consolePrint("[Fluxo] Nenhum fluxo ativo");
+}
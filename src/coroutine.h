@@ -0,0 +1,72 @@
+// coroutine.h - Corrotinas sem pilha (protothreads) para fluxos de rede
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================
+// MACROS
+// ========================================
+// Um fluxo de vários passos é escrito em sequência dentro de uma função
+// CoStatus fluxo(CoState& co), e cada CO_YIELD/CO_WAIT_UNTIL devolve o
+// controle ao loop(). Na próxima chamada a execução continua da linha
+// seguinte (switch sobre __LINE__, como os protothreads do Contiki).
+//
+// Regras: variáveis locais NÃO sobrevivem a um ponto de suspensão (use
+// static no arquivo), não pode haver outro switch em volta de um CO_* e
+// cada linha tem no máximo um CO_* (o ponto de retomada é o __LINE__).
+
+enum CoStatus : uint8_t {
+    CO_RUNNING = 0,
+    CO_DONE
+};
+
+struct CoState {
+    uint16_t line;             // ponto de retomada (0 = início)
+    unsigned long waitStart;   // referência de CO_DELAY / CO_WAIT_TIMEOUT
+};
+
+#define CO_BEGIN(co)        switch ((co).line) { case 0:
+
+#define CO_END(co)          } (co).line = 0; return CO_DONE
+
+// Encerra o fluxo antes do fim
+#define CO_EXIT(co)         do { (co).line = 0; return CO_DONE; } while (0)
+
+// Devolve o controle ao loop(); continua no próximo passe
+#define CO_YIELD(co)        do { (co).line = __LINE__; return CO_RUNNING; \
+                                 case __LINE__:; } while (0)
+
+// Suspende até a condição ser verdadeira (reavaliada a cada passe)
+#define CO_WAIT_UNTIL(co, cond) \
+                            do { (co).line = __LINE__; case __LINE__: \
+                                 if (!(cond)) return CO_RUNNING; } while (0)
+
+#define CO_DELAY(co, ms)    do { (co).waitStart = millis(); \
+                                 CO_WAIT_UNTIL(co, millis() - (co).waitStart >= (ms)); } while (0)
+
+// Como CO_WAIT_UNTIL, mas desiste após ms (use CO_TIMED_OUT(co, ms) depois)
+#define CO_WAIT_TIMEOUT(co, cond, ms) \
+                            do { (co).waitStart = millis(); \
+                                 CO_WAIT_UNTIL(co, (cond) || millis() - (co).waitStart >= (ms)); } while (0)
+#define CO_TIMED_OUT(co, ms) (millis() - (co).waitStart >= (ms))
+
+// ========================================
+// EXECUÇÃO
+// ========================================
+// Os fluxos ativos avançam um passo por chamada de coRunAll() (tarefa
+// "fluxos" do escalonador, a cada tick). O controle, de prioridade maior,
+// roda entre os passos.
+
+#define CO_MAX_FLOWS 4
+
+typedef CoStatus (*CoFunction)(CoState& co);
+
+// Inicia o fluxo; false se já está rodando ou não há espaço
+bool coStart(const char* name, CoFunction fn);
+bool coIsRunning(CoFunction fn);
+
+// Um passo de cada fluxo ativo
+void coRunAll();
+
+// Fluxos ativos e maior duração de um passo
+void coPrintStats();
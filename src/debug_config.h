@@ -23,6 +23,7 @@
 #define DEBUG_ENVIODADOS    0
 #define DEBUG_ESTADO        0 // Envia logs do State: AGUARDANDO, Cooler: OFF, Heater: OFF ou Wait: Proteção: intervalo mínimo resfriamento
 #define DEBUG_ISPINDEL      0
+#define DEBUG_SCHEDULER     0 // Estouro de orçamento das tarefas do escalonador
 #define DEBUG_TELNET        1 //TELNET SÓ FUNCIONA COM ESSE HABILITADO
 
 // ============================================
@@ -22,6 +22,18 @@
 #define PHASE_CHECK_INTERVAL 10000UL          // Verificação de troca de fase (10s)
 #define ACTIVE_CHECK_INTERVAL 30000UL         // Verificação HTTP (30s)
 #define WIFI_CHECK_INTERVAL 60000UL           // Verificação WiFi (60s)
+#define TARGET_CHECK_INTERVAL 5000UL          // Notificação de alvo atingido (5s)
+#define COMMAND_CHECK_INTERVAL 10000UL        // Fila de comandos do site (10s)
+#define STATE_SEND_INTERVAL 30000UL           // Estado completo para o MySQL (30s)
+#define HEARTBEAT_INTERVAL 30000UL            // Heartbeat (30s)
+#define STATE_KEYFRAME_EVERY 20               // Estado completo a cada 20 envios (10min); entre eles, deltas
+#define ISPINDEL_FLUSH_INTERVAL 10000UL       // Reenvio de dados do iSpindel (10s)
+#define SENSOR_CHECK_INTERVAL 30000UL         // Sensores configurados (30s)
+#define NTP_CHECK_INTERVAL 10000UL            // Syncs SNTP pendentes e backup do relógio (10s)
+#define INTEGRITY_CHECK_INTERVAL 300000UL     // Integridade do Preferences (5min)
+#define OTA_HEALTH_INTERVAL 500UL             // Prova pós-OTA e cópia da imagem para rollback (500ms)
+#define TELEMETRY_DRAIN_INTERVAL 5000UL       // Um lote da fila offline por vez (5s)
+#define BOOT_CONVERSION_TIMEOUT_MS 800UL      // Espera máxima da 1ª leitura DS18B20 no boot
 
 // Intervalo de envio para o banco de dados (5 minutos)
 #define READINGS_UPDATE_INTERVAL 300000UL
@@ -39,6 +39,16 @@ struct SystemState {
   }
 };
 
+// === Métricas do Boot === //
+// millis() em que cada etapa do boot terminou (0 = ainda não)
+struct BootMetrics {
+  unsigned long firstTickMs;   // primeiro tick do controle (relés sob controle)
+  unsigned long wifiMs;        // WiFi conectado
+  unsigned long syncMs;        // reconciliação com o servidor concluída
+
+  BootMetrics() : firstTickMs(0), wifiMs(0), syncMs(0) {}
+};
+
 // === Configuração Local === //
 struct LocalConfig {
   float targetTemp;
@@ -75,8 +85,9 @@ struct FermentationStage {
     int rampTimeHours;
     float targetGravity;
     float timeoutDays;
+    uint8_t tuningProfile;  // Perfil de sintonia do controle (0 = padrão)
     
-    // Campos calculados (preenchidos em loadConfigParameters)
+    // Campos calculados (preenchidos em applyConfiguration)
     float holdTimeHours;    // = durationDays * 24
     float maxTimeHours;     // = timeoutDays * 24
     
@@ -92,6 +103,7 @@ struct FermentationStage {
         rampTimeHours(0),
         targetGravity(0.0f),
         timeoutDays(0.0f),
+        tuningProfile(0),
         holdTimeHours(0.0f),
         maxTimeHours(0.0f),
         startTime(0),
@@ -0,0 +1,88 @@
+// exotherm_estimator.cpp - Taxa de queda de gravidade a partir do iSpindel
+#include "exotherm_estimator.h"
+#include "debug_config.h"
+
+// ========================================
+// HISTÓRICO DE GRAVIDADE
+// ========================================
+
+struct GravitySample {
+    unsigned long ms;
+    float points;   // (SG - 1) * 1000
+};
+
+static GravitySample samples[EXOTHERM_MAX_SAMPLES];
+static uint8_t sampleHead = 0;    // próxima posição de escrita
+static uint8_t sampleCount = 0;
+static int16_t cachedRate = 0;    // décimos de ponto/dia
+static unsigned long lastSampleMs = 0;
+
+// Regressão linear (pontos × horas) sobre as amostras dentro da janela
+static int16_t computeDropRate(unsigned long nowMs) {
+    float sumT = 0, sumY = 0, sumTT = 0, sumTY = 0;
+    unsigned long oldest = nowMs;
+    uint8_t n = 0;
+
+    for (uint8_t i = 0; i < sampleCount; i++) {
+        const GravitySample& s = samples[(sampleHead + EXOTHERM_MAX_SAMPLES - 1 - i) % EXOTHERM_MAX_SAMPLES];
+        unsigned long age = nowMs - s.ms;
+        if (age > EXOTHERM_WINDOW_MS) break;
+
+        float t = -(float)age / 3600000.0f;  // horas (negativo = passado)
+        sumT += t;
+        sumY += s.points;
+        sumTT += t * t;
+        sumTY += t * s.points;
+        oldest = s.ms;
+        n++;
+    }
+
+    if (n < EXOTHERM_MIN_SAMPLES || (nowMs - oldest) < EXOTHERM_MIN_SPAN_MS) {
+        return 0;
+    }
+
+    float den = n * sumTT - sumT * sumT;
+    if (den <= 0.0f) return 0;
+
+    float pointsPerHour = (n * sumTY - sumT * sumY) / den;
+
+    // Só queda de gravidade gera calor; subida = ruído ou troca de mosto
+    float dropPerDay = -pointsPerHour * 24.0f;
+    if (dropPerDay <= 0.0f) return 0;
+    if (dropPerDay > 3000.0f) dropPerDay = 3000.0f;
+
+    return (int16_t)(dropPerDay * 10.0f + 0.5f);
+}
+
+void exothermAddGravity(float gravity, unsigned long nowMs) {
+    if (gravity < EXOTHERM_GRAVITY_MIN || gravity > EXOTHERM_GRAVITY_MAX) {
+        return;
+    }
+
+    samples[sampleHead].ms = nowMs;
+    samples[sampleHead].points = (gravity - 1.0f) * 1000.0f;
+    sampleHead = (sampleHead + 1) % EXOTHERM_MAX_SAMPLES;
+    if (sampleCount < EXOTHERM_MAX_SAMPLES) sampleCount++;
+    lastSampleMs = nowMs;
+
+    cachedRate = computeDropRate(nowMs);
+
+    #if DEBUG_BREWPI
+    Serial.printf("[Exotherm] 🌡️  Gravidade %.4f, queda %.1f pts/dia (%u amostras)\n",
+                  gravity, cachedRate / 10.0f, sampleCount);
+    #endif
+}
+
+int16_t exothermDropRate(unsigned long nowMs) {
+    if (sampleCount == 0 || nowMs - lastSampleMs > EXOTHERM_STALE_MS) {
+        return 0;
+    }
+    return cachedRate;
+}
+
+void exothermReset() {
+    sampleHead = 0;
+    sampleCount = 0;
+    cachedRate = 0;
+    lastSampleMs = 0;
+}
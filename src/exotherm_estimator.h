@@ -0,0 +1,34 @@
+// exotherm_estimator.h - Estimativa da carga térmica da fermentação (feed-forward)
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+
+#define EXOTHERM_MAX_SAMPLES   24                // ~6h com iSpindel a cada 15min
+#define EXOTHERM_WINDOW_MS     (4UL * 3600000UL) // Regressão sobre as últimas 4h
+#define EXOTHERM_MIN_SPAN_MS   (3600000UL)       // Mínimo de 1h de histórico
+#define EXOTHERM_MIN_SAMPLES   3
+#define EXOTHERM_STALE_MS      (2UL * 3600000UL) // Sem gravidade há 2h = sem feed-forward
+
+// Faixa plausível de gravidade (descarta leituras de iSpindel fora da cerveja)
+#define EXOTHERM_GRAVITY_MIN   0.980f
+#define EXOTHERM_GRAVITY_MAX   1.200f
+
+// ========================================
+// API
+// ========================================
+// A gravidade do iSpindel (POST /gravity) entra aqui; a taxa de queda
+// (pontos de densidade por dia) vai para o BrewPiTempControl, que converte
+// em pré-resfriamento do fridgeSetting com cc.exothermGain.
+
+// Registra uma leitura de gravidade (SG, ex.: 1.048)
+void exothermAddGravity(float gravity, unsigned long nowMs);
+
+// Taxa de queda em décimos de ponto/dia (ex.: 85 = 8.5 pontos/dia), >= 0
+int16_t exothermDropRate(unsigned long nowMs);
+
+// Descarta o histórico (nova fermentação)
+void exothermReset();
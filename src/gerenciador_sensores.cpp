@@ -294,6 +294,25 @@ bool stringToDeviceAddress(const String& str, DeviceAddress addr) {
 // =================================================
 // Lê temperaturas dos sensores configurados
 // =================================================
+// Dispara a conversão sem esperar: o resultado fica no DS18B20 para o
+// próximo getTempCByIndex() do BrewPi
+void requestTemperaturesAsync() {
+    sensors.setWaitForConversion(false);
+    sensors.requestTemperatures();
+    sensors.setWaitForConversion(true);
+}
+
+// Espera a conversão disparada por requestTemperaturesAsync() terminar,
+// no máximo timeoutMs (boot: primeiro tick do controle com leitura válida)
+bool waitTemperaturesReady(unsigned long timeoutMs) {
+    unsigned long start = millis();
+    while (!sensors.isConversionComplete()) {
+        if (millis() - start >= timeoutMs) return false;
+        delay(10);
+    }
+    return true;
+}
+
 bool readConfiguredTemperatures(float& tempFermenter, float& tempFridge) {
     String addrFermenterStr = getSensorAddress(SENSOR1_NOME);
     String addrFridgeStr = getSensorAddress(SENSOR2_NOME);
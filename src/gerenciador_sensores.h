@@ -33,6 +33,8 @@ String getSensorAddress(const char* sensorKey);
 
 // --- Leitura de Temperaturas ---
 bool readConfiguredTemperatures(float& tempFermenter, float& tempFridge);
+void requestTemperaturesAsync();
+bool waitTemperaturesReady(unsigned long timeoutMs);
 bool stringToDeviceAddress(const String& str, DeviceAddress addr);
 
 // --- Limpeza EEPROM ---
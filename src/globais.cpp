@@ -8,6 +8,7 @@ FermentacaoState fermentacaoState;
 
 // ✅ SystemState - usa construtor padrão que já inicializa lastTempUpdate = 0
 SystemState state;
+BootMetrics bootMetrics;
 
 // Inicialização dos objetos rele
 Rele cooler = {PINO_COOLER, false, false, "COOLER"};
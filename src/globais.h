@@ -9,6 +9,7 @@
 
 // Declaração das variáveis globais (extern)
 extern SystemState state;
+extern BootMetrics bootMetrics;
 extern LocalConfig config;
 extern FermentacaoState fermentacaoState;
 extern Rele cooler;
@@ -3,118 +3,372 @@
 // Isso porque o esp tá configurado para enviar para http e não https
 #include "http_client.h"
 #include "debug_config.h"
+#include "wifi_manager.h"
+#include "clock_sync.h"
+#include "globais.h"
+#include "ota_health.h"
+#include "telemetry_queue.h"
+#include <memory>
+#include <StreamString.h>
 
 // Instância global
 FermentadorHTTPClient httpClient;
 
 FermentadorHTTPClient::FermentadorHTTPClient() {}
 
-FermentadorHTTPClient::~FermentadorHTTPClient() {
-    http.end();
+void FermentadorHTTPClient::begin() {
+    asyncHttp.begin(SERVER_URL);
+}
+
+void FermentadorHTTPClient::loop() {
+    if (batchRecords > 0 && millis() - batchStartMs >= BATCH_WINDOW_MS) {
+        flushBatch();
+    }
+    asyncHttp.loop();
 }
 
 // =====================================================
-// FUNÇÃO CENTRAL DE REQUISIÇÃO (Único local com String payload)
+// ENFILEIRAMENTO (Único local com String payload)
 // =====================================================
-bool FermentadorHTTPClient::makeRequest(const String& endpoint, const String& method, 
-                                        const JsonDocument* payloadDoc, String& response) {
+// O corpo é serializado uma vez, no tamanho exato, e movido para a fila
+// do AsyncHttp, que envia dele mesmo. O documento é liberado quando o
+// chamador retorna: o pico de heap é documento + corpo, medido aqui.
+void FermentadorHTTPClient::noteBodyHeap() {
+    uint32_t heap = ESP.getFreeHeap();
+    uint32_t block = ESP.getMaxFreeBlockSize();
+    uint8_t frag = ESP.getHeapFragmentation();
+
+    if (heap < bodyHeapMin) bodyHeapMin = heap;
+    if (block < bodyBlockMin) bodyBlockMin = block;
+    if (frag > bodyFragMax) bodyFragMax = frag;
+}
+
+// MessagePack é binário (tem bytes 0): vai por StreamString, que grava
+// pelo tamanho, e não pelo String::concat() de C-string do ArduinoJson
+String FermentadorHTTPClient::packBody(const JsonDocument& doc) {
+    uint32_t start = micros();
+
+    StreamString body;
+    body.reserve(measureMsgPack(doc));
+    serializeMsgPack(doc, body);
+
+    uint32_t us = micros() - start;
+    noteBodyHeap();
+
+    packCount++;
+    packUsTotal += us;
+    if (us > packUsMax) packUsMax = us;
+    packedBytes += body.length();
+    packedJsonBytes += measureJson(doc);
+
+    return std::move(body);   // sem copiar o buffer
+}
+
+bool FermentadorHTTPClient::post(const String& endpoint, const JsonDocument& payloadDoc,
+                                 HttpDoneCallback callback, const char* context,
+                                 bool msgpack) {
     if (!isConnected()) {
         return false;
     }
 
-    String url = String(SERVER_URL) + endpoint;
-    
-    http.end();  // Garante que está limpo antes de usar
-    http.begin(wifiClient, url);  // Usa o membro wifiClient
-    http.addHeader("Content-Type", "application/json");
-    http.setTimeout(HTTP_TIMEOUT);
-
-    int httpCode = -1;
-
-    if (method == "GET") {
-        httpCode = http.GET();
-    } else if (method == "POST") {
-        if (payloadDoc != nullptr) {
-            // OTIMIZAÇÃO: Reserva RAM exata antes de serializar para evitar fragmentação
-            String payload;
-            payload.reserve(measureJson(*payloadDoc) + 1);
-            serializeJson(*payloadDoc, payload);
-            httpCode = http.POST(payload);
-        } else {
-            httpCode = http.POST("");
-        }
+    String payload;
+    if (msgpack) {
+        payload = packBody(payloadDoc);
+    } else {
+        // OTIMIZAÇÃO: Reserva RAM exata antes de serializar para evitar fragmentação
+        payload.reserve(measureJson(payloadDoc) + 1);
+        serializeJson(payloadDoc, payload);
+        noteBodyHeap();
     }
 
-    yield();
-        
-    if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_CREATED) {
-        response = http.getString();
-        http.end();
-        return true;
+    bool queued = asyncHttp.request(ASYNC_HTTP_POST, endpoint, std::move(payload),
+        [callback, context](AsyncHttpResponse& resp) {
+            #if DEBUG_HTTP
+            Serial.printf("[HTTP] %s %s: %d (%lums)\n", resp.ok() ? "✅" : "❌",
+                          context, resp.status, (unsigned long)resp.elapsedMs);
+            #else
+            (void)context;
+            #endif
+            if (callback) callback(resp.ok());
+        }, ASYNC_HTTP_DEADLINE_MS, msgpack ? ASYNC_HTTP_CT_MSGPACK : ASYNC_HTTP_CT_JSON);
+
+    if (!queued) printError(context);
+    return queued;
+}
+
+// O filtro é montado só na hora do parse e descarta o que o firmware não
+// lê: o documento fica do tamanho dos campos usados, não da resposta
+bool FermentadorHTTPClient::getJson(const String& endpoint, HttpJsonCallback callback,
+                                    const char* context, HttpJsonFilter filter,
+                                    const String& ifNoneMatch) {
+    if (!isConnected()) {
+        return false;
     }
 
-    http.end();
-    return false;
+    return asyncHttp.request(ASYNC_HTTP_GET, endpoint, String(),
+        [this, callback, context, filter](AsyncHttpResponse& resp) {
+            JsonDocument doc;
+            bool ok = resp.ok();
+
+            // Nada mudou desde o ETag enviado: sem corpo e sem parse
+            if (resp.notModified()) {
+                notModifiedCount++;
+                callback(true, doc);
+                return;
+            }
+
+            if (ok) {
+                uint32_t start = micros();
+                DeserializationError error;
+                if (filter) {
+                    JsonDocument filterDoc;
+                    filter(filterDoc);
+                    error = deserializeJson(doc, resp.body,
+                                            DeserializationOption::Filter(filterDoc));
+                } else {
+                    error = deserializeJson(doc, resp.body);
+                }
+                uint32_t us = micros() - start;
+                uint32_t heap = ESP.getFreeHeap();
+
+                parseCount++;
+                parseUsTotal += us;
+                if (us > parseUsMax) parseUsMax = us;
+                if (resp.body.length() > parseBytesMax) parseBytesMax = resp.body.length();
+                if (heap < parseHeapMin) parseHeapMin = heap;
+
+                resp.body = String();   // libera antes do callback
+                if (error) {
+                    ok = false;
+                    #if DEBUG_HTTP
+                    Serial.printf("[HTTP] ❌ %s: JSON parse error: %s\n", context, error.c_str());
+                    #endif
+                }
+            }
+
+            #if DEBUG_HTTP
+            if (!resp.ok()) {
+                Serial.printf("[HTTP] ❌ Falha em %s (%d)\n", context, resp.status);
+            }
+            #else
+            (void)context;
+            #endif
+
+            lastEtag = ok ? std::move(resp.etag) : String();
+            callback(ok, doc);
+            lastEtag = String();
+        }, ASYNC_HTTP_DEADLINE_MS, ASYNC_HTTP_CT_JSON, ifNoneMatch);
 }
 
 // =====================================================
-// MÉTODOS DE FERMENTAÇÃO
+// FILTROS DE RESPOSTA
 // =====================================================
+// Campos lidos por processActiveFermentation()
+static void filterActive(JsonDocument& f) {
+    f["active"] = true;
+    f["paused"] = true;
+    f["id"] = true;
+    f["currentStageIndex"] = true;
+    f["stageStartEpoch"] = true;
+    f["targetReached"] = true;
+}
 
-bool FermentadorHTTPClient::getActiveFermentation(JsonDocument& doc) {
-    String response;
-    yield();
-    // CORREÇÃO: Passar nullptr em vez de "" para requisições GET
-    if (!makeRequest("api.php?path=esp/active", "GET", nullptr, response)) {
-        return false;
+// Campos lidos por applyConfiguration(), loadConfigCache() e
+// processRemoteStatus(); o cache no LittleFS guarda só estes
+static void filterConfig(JsonDocument& f) {
+    f["name"] = true;
+    f["status"] = true;
+    f["currentStageIndex"] = true;
+
+    JsonObject stage = f["stages"].add<JsonObject>();
+    stage["type"] = true;
+    stage["targetTemp"] = true;
+    stage["startTemp"] = true;
+    stage["rampTime"] = true;
+    stage["duration"] = true;
+    stage["targetGravity"] = true;
+    stage["timeoutDays"] = true;
+    stage["tuningProfile"] = true;
+
+    f["tuningProfiles"].add(true);   // perfis inteiros (só campos do controle)
+}
+
+static void filterCommand(JsonDocument& f) {
+    f["command"] = true;
+}
+
+static void filterAssigned(JsonDocument& f) {
+    f["success"] = true;
+    f["sensors"]["sensor_fermentador"] = true;
+    f["sensors"]["sensor_geladeira"] = true;
+}
+
+// Sequências dos estados gravados (confirmam a base do delta)
+static void filterBatch(JsonDocument& f) {
+    f["acked"]["state"] = true;
+}
+
+// =====================================================
+// LOTE (esp/batch)
+// =====================================================
+// Registros duráveis de um lote que falhou voltam para a fila offline
+static void requeueDurable(JsonDocument& doc) {
+    for (JsonPair section : doc.as<JsonObject>()) {
+        for (JsonObject rec : section.value().as<JsonArray>()) {
+            JsonDocument one;
+            one.set(rec);
+            telemetryQueuePush(section.key().c_str(), one);
+        }
     }
-    
-    yield();
-    DeserializationError error = deserializeJson(doc, response);
-        
-    return !error;
 }
 
-bool FermentadorHTTPClient::getConfiguration(const char* configId, JsonDocument& doc) {
-    String endpoint = "api/esp/config.php?id=" + String(configId);
-    String response;
-    yield();
-    // CORREÇÃO: Passar nullptr em vez de "" [2]
-    if (!makeRequest(endpoint, "GET", nullptr, response)) {
-        #if DEBUG_HTTP
-        Serial.println(F("[HTTP] ❌ Falha em getConfiguration"));
-        #endif
-        return false;
+JsonObject FermentadorHTTPClient::addToBatch(const char* section, const JsonDocument& record,
+                                             bool durable) {
+    if (!isConnected()) {
+        return JsonObject();
     }
-    
-    yield();
-    DeserializationError error = deserializeJson(doc, response);
-    
-    #if DEBUG_HTTP
-    if (error) {
-        Serial.printf("[HTTP] ❌ JSON parse error: %s\n", error.c_str());
+
+    // Não cabe no lote atual: envia e abre outro
+    if (batchRecords > 0 && measureJson(batchDoc) + measureJson(record) > BATCH_MAX_BYTES) {
+        flushBatch();
     }
-    #endif
-    
-    return !error;
+
+    if (batchRecords == 0) batchStartMs = millis();
+
+    JsonObject rec = batchDoc[section].add<JsonObject>();
+    rec.set(record.as<JsonObjectConst>());
+    if (!record["seq"].isNull()) batchDoc["seq"] = telemetryQueueEpoch();
+    if (durable) {
+        rec["seq"] = telemetryQueueNextSeq();
+        batchDoc["seq"] = telemetryQueueEpoch();
+        batchDurable = true;
+    }
+    batchRecords++;
+    return rec;
 }
 
-bool FermentadorHTTPClient::updateFermentationState(const char* configId, const JsonDocument& doc) {
-    String endpoint = "api.php?path=fermentation-state&config_id=" + String(configId);
-    String response;
-    yield();
+void FermentadorHTTPClient::flushBatch() {
+    if (batchRecords == 0) return;
 
-    bool result = makeRequest(endpoint, "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] ✅ Estado atualizado"));
-    } else {
-        Serial.println(F("[HTTP] ❌ Falha ao atualizar estado"));
+    uint8_t records = batchRecords;
+
+    // Leituras e iSpindel ficam guardados até a resposta: com falha, voltam
+    // para a fila offline com a mesma sequência (o servidor descarta repetidos)
+    std::shared_ptr<JsonDocument> durable;
+    if (batchDurable) {
+        durable = std::make_shared<JsonDocument>();
+        for (const char* section : {"readings", "ispindel"}) {
+            if (!batchDoc[section].isNull()) (*durable)[section] = batchDoc[section];
+        }
+    }
+
+    std::shared_ptr<std::vector<BatchCallback>> callbacks;
+    if (!batchCallbacks.empty()) {
+        callbacks = std::make_shared<std::vector<BatchCallback>>(std::move(batchCallbacks));
+        batchCallbacks.clear();
+    }
+
+    // acked: seqs de estado que o servidor gravou. Um registro pode cair em
+    // "errors" com o lote em 201; só os listados valem como confirmados
+    auto done = [durable, callbacks](bool ok, JsonArrayConst acked) {
+        if (!ok && durable) requeueDurable(*durable);
+        if (!callbacks) return;
+        for (auto& entry : *callbacks) {
+            bool recOk = ok;
+            if (ok && entry.seq != 0) {
+                recOk = false;
+                for (JsonVariantConst s : acked) {
+                    if (s.as<uint32_t>() == entry.seq) { recOk = true; break; }
+                }
+            }
+            entry.cb(recOk);
+        }
+    };
+
+    bool queued = false;
+    if (isConnected()) {
+        queued = asyncHttp.request(ASYNC_HTTP_POST, "api.php?path=esp/batch", packBody(batchDoc),
+            [done](AsyncHttpResponse& resp) {
+                JsonDocument doc;
+                bool ok = resp.ok();
+                if (ok) {
+                    JsonDocument filterDoc;
+                    filterBatch(filterDoc);
+                    // Sem "acked" (servidor antigo) os estados ficam sem confirmação
+                    // e o próximo vai completo; o lote em si foi aceito
+                    deserializeJson(doc, resp.body, DeserializationOption::Filter(filterDoc));
+                    resp.body = String();
+                }
+                #if DEBUG_HTTP
+                Serial.printf("[HTTP] %s Lote: %d (%lums)\n", ok ? "✅" : "❌",
+                              resp.status, (unsigned long)resp.elapsedMs);
+                #endif
+                done(ok, doc["acked"]["state"].as<JsonArrayConst>());
+            }, ASYNC_HTTP_DEADLINE_MS, ASYNC_HTTP_CT_MSGPACK);
+        if (!queued) printError("Lote");
+    }
+    if (!queued) done(false, JsonArrayConst());
+
+    if (queued) {
+        batchesSent++;
+        batchedRecords += records;
     }
+
+    #if DEBUG_HTTP
+    Serial.printf("[HTTP] Lote com %u registros %s\n", records,
+                  queued ? "enfileirado" : "descartado");
     #endif
-    
-    return result;
+
+    batchDoc.clear();
+    batchRecords = 0;
+    batchDurable = false;
+}
+
+bool FermentadorHTTPClient::sendQueuedBatch(const JsonDocument& doc, HttpDoneCallback callback) {
+    if (!isConnected()) {
+        return false;
+    }
+
+    return asyncHttp.request(ASYNC_HTTP_POST, "api.php?path=esp/batch", packBody(doc),
+        [callback](AsyncHttpResponse& resp) {
+            // 4xx: registro rejeitado pelo servidor; reenviar não adianta
+            bool done = resp.status >= 200 && resp.status < 500;
+            #if DEBUG_HTTP
+            Serial.printf("[HTTP] %s Fila offline: %d (%lums)\n", done ? "✅" : "❌",
+                          resp.status, (unsigned long)resp.elapsedMs);
+            #endif
+            callback(done);
+        }, ASYNC_HTTP_DEADLINE_MS, ASYNC_HTTP_CT_MSGPACK);
+}
+
+// =====================================================
+// MÉTODOS DE FERMENTAÇÃO
+// =====================================================
+
+bool FermentadorHTTPClient::getActiveFermentation(HttpJsonCallback callback,
+                                                  const String& ifNoneMatch) {
+    return getJson("api.php?path=esp/active",
+        [this, callback](bool ok, JsonDocument& doc) {
+            if (ok) activeOkCount++;
+            callback(ok, doc);
+        }, "getActiveFermentation", filterActive, ifNoneMatch);
+}
+
+bool FermentadorHTTPClient::getConfiguration(const char* configId, HttpJsonCallback callback,
+                                             const String& ifNoneMatch) {
+    String endpoint = "api/esp/config.php?id=" + String(configId);
+    return getJson(endpoint, callback, "getConfiguration", filterConfig, ifNoneMatch);
+}
+
+bool FermentadorHTTPClient::updateFermentationState(const char* configId, const JsonDocument& doc,
+                                                    HttpDoneCallback callback) {
+    JsonObject rec = addToBatch("state", doc);
+    if (rec.isNull()) return false;
+
+    // No lote não há query string: o ID vai no próprio registro
+    if (rec["cid"].isNull() && rec["config_id"].isNull()) rec["config_id"] = configId;
+    if (callback) batchCallbacks.push_back({rec["seq"].as<uint32_t>(), callback});
+    return true;
 }
 
 // =====================================================
@@ -131,16 +385,7 @@ bool FermentadorHTTPClient::sendReading(const char* configId, float tempFridge,
     doc["tb"] = tempFermenter;
     doc["tt"] = tempTarget;
     
-    String response;
-    bool result = makeRequest("api.php?path=readings", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] Leitura enviada"));
-    }
-    #endif
-    
-    return result;
+    return !addToBatch("readings", doc, true).isNull();
 }
 
 bool FermentadorHTTPClient::updateControlState(const char* configId, float setpoint, 
@@ -151,81 +396,35 @@ bool FermentadorHTTPClient::updateControlState(const char* configId, float setpo
     doc["cooling"] = cooling;
     doc["heating"] = heating;
 
-    String response;
-    yield();
-
-    bool result = makeRequest("api.php?path=control", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] ✅ Estado de controle atualizado"));
-    } else {
-        Serial.println(F("[HTTP] ❌ Falha ao atualizar controle"));
-    }
-    #endif
-    
-    return result;
+    return !addToBatch("control", doc).isNull();
 }
 
-bool FermentadorHTTPClient::notifyTargetReached(const char* configId) {
+bool FermentadorHTTPClient::notifyTargetReached(const char* configId, HttpDoneCallback callback) {
     JsonDocument doc;
     doc["config_id"] = configId;
     doc["target_reached"] = true;
 
-    String response;
-    yield();
-    // CORREÇÃO: Passa &doc diretamente [7]
-    bool result = makeRequest("api/esp/target.php", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] ✅ Target reached notificado"));
-    } else {
-        Serial.println(F("[HTTP] ❌ Falha ao notificar target"));
-    }
-    #endif
-    
-    return result;
+    return post("api/esp/target.php", doc, callback, "Target reached");
 }
 
-bool FermentadorHTTPClient::updateStageIndex(const char* configId, int newStageIndex) {
+bool FermentadorHTTPClient::updateStageIndex(const char* configId, int newStageIndex,
+                                             HttpDoneCallback callback) {
     JsonDocument doc;
     doc["config_id"] = configId;
     doc["currentStageIndex"] = newStageIndex;
     doc["stage_advanced"] = true;
     doc["timestamp"] = millis() / 1000;
 
-    String response;
-    yield();
-    
-    bool result = makeRequest("api/esp/stage.php", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.printf("[HTTP] ✅ Etapa atualizada para %d\n", newStageIndex);
-    } else {
-        Serial.printf("[HTTP] ❌ Falha ao atualizar etapa para %d\n", newStageIndex);
-    }
-    #endif
-    
-    return result;
+    return post("api/esp/stage.php", doc, callback, "Índice da etapa");
 }
 
-String FermentadorHTTPClient::getPendingCommand(int configId) {
+bool FermentadorHTTPClient::getPendingCommand(int configId, HttpCommandCallback callback) {
     String endpoint = "api.php?path=commands/pending&config_id=" + String(configId);
-    String response;
-    
-    yield();
-    if (!makeRequest(endpoint, "GET", nullptr, response)) {
-        return "";
-    }
-    
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
-    if (error) return "";
-    
-    const char* cmd = doc["command"] | "";
-    return String(cmd);
+
+    return getJson(endpoint, [callback](bool ok, JsonDocument& doc) {
+        const char* cmd = ok ? (doc["command"] | "") : "";
+        callback(String(cmd));
+    }, "getPendingCommand", filterCommand);
 }
 
 bool FermentadorHTTPClient::sendSensorError(const char* configId, float tempTarget) {
@@ -237,8 +436,7 @@ bool FermentadorHTTPClient::sendSensorError(const char* configId, float tempTarg
     doc["tt"] = tempTarget;
     // tf e tb ausentes = null implícito
     
-    String response;
-    return makeRequest("api.php?path=readings", "POST", &doc, response);
+    return !addToBatch("readings", doc).isNull();
 }
 
 // =====================================================
@@ -250,29 +448,12 @@ bool FermentadorHTTPClient::updateCurrentTemperatures(float tempFermenter, float
     doc["temp_fermenter"] = tempFermenter;
     doc["temp_fridge"] = tempFridge;
 
-    String response;
-    yield();
-    // CORREÇÃO: Passa &doc em vez de payload String [3]
-    bool result = makeRequest("api/esp/sensors.php?action=update_temperatures", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] ✅ Temperaturas atualizadas"));
-    } else {
-        Serial.println(F("[HTTP] ❌ Falha ao atualizar temperaturas"));
-    }
-    #endif
-    
-    return result;
+    return post("api/esp/sensors.php?action=update_temperatures", doc, nullptr,
+                "Temperaturas atuais");
 }
 
-bool FermentadorHTTPClient::sendSpindelData(const String& spindelJson) {
-    // Se não vai usar, remova do .h
-    // Ou implemente:
-    JsonDocument doc;
-    deserializeJson(doc, spindelJson);
-    String response;
-    return makeRequest("api.php?path=ispindel/data", "POST", &doc, response);
+bool FermentadorHTTPClient::sendSpindelData(const JsonDocument& spindelDoc) {
+    return !addToBatch("ispindel", spindelDoc, true).isNull();
 }
 
 void FermentadorHTTPClient::printError(const char* context) {
@@ -282,82 +463,51 @@ void FermentadorHTTPClient::printError(const char* context) {
 }
 
 bool FermentadorHTTPClient::sendSensors(const JsonDocument& sensorsDoc) {
-    String response;
-    yield();
-    // Passa o endereço do documento diretamente
-    return makeRequest("api/esp/sensors.php?action=save_detected", "POST", &sensorsDoc, response);
+    return post("api/esp/sensors.php?action=save_detected", sensorsDoc, nullptr,
+                "Sensores detectados");
 }
 
 bool FermentadorHTTPClient::isConnected() {
     return WiFi.status() == WL_CONNECTED;
 }
 
-bool FermentadorHTTPClient::getAssignedSensors(String& fermenterAddr, String& fridgeAddr) {
-    String response;
-    String endpoint = "api/esp/sensors.php?action=get_assigned";
-    
-    // ✅ YIELD 1: Mantido para estabilidade do Watchdog no ESP8266 [1]
-    yield();
-    
-    // CORREÇÃO: Usamos nullptr no lugar de "" para coincidir com const JsonDocument* payloadDoc
-    // Isso evita a criação de um objeto String desnecessário para uma requisição GET [1, 2]
-    if (!makeRequest(endpoint, "GET", nullptr, response)) {
-        #if DEBUG_HTTP
-        Serial.println(F("[HTTP] Erro ao buscar sensores configurados"));
-        #endif
-        return false;
-    }
-    
-    JsonDocument doc; // Gerenciamento automático da ArduinoJson v7 [3]
-    
-    // ✅ YIELD 2: Antes de processar o JSON pesado
-    yield();
-    
-    DeserializationError error = deserializeJson(doc, response);
-    
-    // ✅ YIELD 3: Após o processamento
-    yield();
-    
-    if (error) {
-        #if DEBUG_HTTP
-        Serial.printf("[HTTP] JSON erro ao parsear sensores: %s\n", error.c_str());
-        #endif
-        return false;
-    }
-    
-    // Respeita a verificação de sucesso do seu servidor
-    if (!doc["success"].as<bool>()) {
-        #if DEBUG_HTTP
-        Serial.println(F("[HTTP] Servidor reportou falha"));
-        #endif
-        return false;
-    }
-    
-    JsonObject sensors = doc["sensors"];
-    
-    // Inicializa strings como vazias para evitar lixo de memória
-    fermenterAddr = "";
-    fridgeAddr = "";
-    
-    // Mapeia as chaves específicas do seu banco de dados
-    if (sensors["sensor_fermentador"].is<String>()) {
-        fermenterAddr = sensors["sensor_fermentador"].as<String>();
-        #if DEBUG_HTTP
-        Serial.printf("[HTTP] Sensor fermentador: %s\n", fermenterAddr.c_str());
-        #endif
-    }
-    
-    if (sensors["sensor_geladeira"].is<String>()) {
-        fridgeAddr = sensors["sensor_geladeira"].as<String>();
-        #if DEBUG_HTTP
-        Serial.printf("[HTTP] Sensor geladeira: %s\n", fridgeAddr.c_str());
-        #endif
-    }
-    
-    // ✅ YIELD 4: Finalização da tarefa
-    yield();
-    
-    return !fermenterAddr.isEmpty() || !fridgeAddr.isEmpty();
+bool FermentadorHTTPClient::getAssignedSensors(HttpSensorsCallback callback) {
+    return getJson("api/esp/sensors.php?action=get_assigned",
+        [callback](bool ok, JsonDocument& doc) {
+            String fermenterAddr;
+            String fridgeAddr;
+
+            // Respeita a verificação de sucesso do seu servidor
+            if (ok && !doc["success"].as<bool>()) {
+                #if DEBUG_HTTP
+                Serial.println(F("[HTTP] Servidor reportou falha"));
+                #endif
+                ok = false;
+            }
+
+            if (ok) {
+                JsonObject sensors = doc["sensors"];
+
+                // Mapeia as chaves específicas do seu banco de dados
+                if (sensors["sensor_fermentador"].is<String>()) {
+                    fermenterAddr = sensors["sensor_fermentador"].as<String>();
+                    #if DEBUG_HTTP
+                    Serial.printf("[HTTP] Sensor fermentador: %s\n", fermenterAddr.c_str());
+                    #endif
+                }
+
+                if (sensors["sensor_geladeira"].is<String>()) {
+                    fridgeAddr = sensors["sensor_geladeira"].as<String>();
+                    #if DEBUG_HTTP
+                    Serial.printf("[HTTP] Sensor geladeira: %s\n", fridgeAddr.c_str());
+                    #endif
+                }
+
+                ok = !fermenterAddr.isEmpty() || !fridgeAddr.isEmpty();
+            }
+
+            callback(ok, fermenterAddr, fridgeAddr);
+        }, "getAssignedSensors", filterAssigned);
 }
 
 bool FermentadorHTTPClient::sendHeartbeat(int configId, const DetailedControlStatus& status, 
@@ -381,6 +531,12 @@ bool FermentadorHTTPClient::sendHeartbeat(int configId, const DetailedControlSta
     JsonObject ctrl = doc["control_status"].to<JsonObject>();
     ctrl["state"] = status.stateName;
     ctrl["is_waiting"] = status.isWaiting;
+    if (status.heaterDuty > 0) {
+        ctrl["heater_duty"] = status.heaterDuty / 10.0f;  // %
+    }
+    if (status.feedForward < 0.0f) {
+        ctrl["ff"] = status.feedForward;  // °C
+    }
 
     if (status.isWaiting) {
         ctrl["wait_seconds"] = status.waitTimeRemaining;
@@ -401,24 +557,62 @@ bool FermentadorHTTPClient::sendHeartbeat(int configId, const DetailedControlSta
         ctrl["estimated_peak"] = status.estimatedPeak;
     }
 
-    // Envio Otimizado: Passa o endereço do documento para o makeRequest [3, 4]
-    String response;
-    bool result = makeRequest("api.php?path=heartbeat", "POST", &doc, response);
-    
-    #if DEBUG_HTTP
-    if (result) {
-        Serial.println(F("[HTTP] ✅ Heartbeat enviado"));
-    } else {
-        Serial.println(F("[HTTP] ❌ Falha ao enviar heartbeat"));
+    // Saúde do WiFi (quedas desde o boot e duração da última)
+    JsonObject wifi = ctrl["wifi"].to<JsonObject>();
+    wifi["rssi"] = WiFi.RSSI();
+    wifi["reconnects"] = wifiGetReconnects();
+    wifi["reconnect_ms"] = wifiLastReconnectMs();
+    wifi["fast"] = wifiLastReconnectFast();
+    if (wifiGetReconnects() > 0) {
+        wifi["last_outage_s"] = wifiLastOutageSeconds();
+        wifi["last_reason"] = wifiLastDisconnectReason();
     }
-    #endif
-    
-    return result;
+
+    // Conexão persistente com o servidor
+    JsonObject http = ctrl["http"].to<JsonObject>();
+    http["reuse_pct"] = asyncHttp.getReusePercent();
+    http["connects"] = asyncHttp.getConnects();
+    http["sent"] = asyncHttp.getRequestsSent();
+    http["pipelined"] = asyncHttp.getPipelined();
+    http["fail"] = asyncHttp.getFailed();
+    http["timeouts"] = asyncHttp.getTimeouts();
+    http["avg_ms"] = asyncHttp.getAvgLatencyMs();
+    http["max_ms"] = asyncHttp.getMaxLatencyMs();
+    http["pack_bytes"] = packedBytes;
+    http["json_bytes"] = packedJsonBytes;
+    http["pack_us"] = getPackAvgUs();
+    http["pack_us_max"] = packUsMax;
+    http["heap_min"] = getBodyHeapMin();
+    http["block_min"] = getBodyBlockMin();
+    http["frag_max"] = bodyFragMax;
+    http["parse_us"] = getParseAvgUs();
+    http["parse_us_max"] = parseUsMax;
+    http["parse_bytes_max"] = parseBytesMax;
+    http["parse_heap_min"] = getParseHeapMin();
+    http["not_modified"] = notModifiedCount;
+
+    // Tempos do boot (ms desde o reset; 0 = etapa ainda não concluída)
+    JsonObject boot = ctrl["boot"].to<JsonObject>();
+    boot["first_tick_ms"] = bootMetrics.firstTickMs;
+    boot["wifi_ms"] = bootMetrics.wifiMs;
+    boot["sync_ms"] = bootMetrics.syncMs;
+
+    // Prova da última atualização OTA
+    otaHealthToJson(ctrl["ota"].to<JsonObject>());
+
+    // Qualidade do relógio que conta o tempo das etapas
+    JsonObject clk = ctrl["clock"].to<JsonObject>();
+    clk["synced"] = clockIsSynced();
+    if (clockIsSynced()) {
+        clk["err_ms"] = clockErrorMs();
+        // float, não serialized(): no MessagePack o texto cru quebraria o lote
+        clk["drift_ppm"] = roundf(clockDriftPpm() * 10) / 10.0f;
+    }
+
+    return !addToBatch("heartbeat", doc).isNull();
 }
 
 bool FermentadorHTTPClient::sendSensorsData(const JsonDocument& sensorsDoc) {
-    String response;
-    yield();
-    return makeRequest("api/esp/sensors.php?action=save_detected", 
-                      "POST", &sensorsDoc, response);
+    return post("api/esp/sensors.php?action=save_detected", sensorsDoc, nullptr,
+                "Dados dos sensores");
 }
@@ -2,40 +2,119 @@
 #pragma once
 
 #include <Arduino.h>
-#include <ESP8266HTTPClient.h>
-#include <WiFiClient.h>
 #include <ArduinoJson.h>
+#include <functional>
+#include <vector>
 #include "ESP8266WiFi.h"
 #include "BrewPiStructs.h"        // Define o tipo 'temperature' [2]
 #include "controle_temperatura.h"   // Define a struct 'DetailedControlStatus'
+#include "async_http.h"
 
 // ========== CONFIGURAÇÕES ==========
 #define SERVER_URL "http://fermentador.mvrinaldi.com.br/"
-#define HTTP_TIMEOUT 5000 // 5 segundos
-#define MAX_RETRIES 3
+
+// Lote (esp/batch): estado, controle, heartbeat, leituras e iSpindel do
+// mesmo ciclo vão num POST só. O primeiro registro abre o lote, e
+// loop() envia BATCH_WINDOW_MS depois (antes, se passar de BATCH_MAX_BYTES).
+#define BATCH_WINDOW_MS 1000
+#define BATCH_MAX_BYTES 3072
+
+// ========== RESULTADOS ==========
+// Nenhum método espera a rede: todos serializam, enfileiram em asyncHttp
+// e retornam true se a requisição entrou na fila. Quem precisa da
+// resposta passa um callback, chamado depois em httpClient.loop().
+// GET condicional (com ETag): 304 chega como ok com doc nulo (nada mudou)
+typedef std::function<void(bool ok, JsonDocument& doc)> HttpJsonCallback;
+typedef std::function<void(bool ok)> HttpDoneCallback;
+typedef std::function<void(const String& command)> HttpCommandCallback;
+typedef std::function<void(bool ok, const String& fermenterAddr,
+                           const String& fridgeAddr)> HttpSensorsCallback;
+
+// Monta o filtro do deserializeJson: só os campos marcados com true entram
+// no documento (num array, o primeiro elemento vale para todos)
+typedef void (*HttpJsonFilter)(JsonDocument& filter);
 
 // ========== CLASSE CLIENTE HTTP ==========
 class FermentadorHTTPClient {
 private:
-    WiFiClient wifiClient;
-    HTTPClient http;
+    uint32_t activeOkCount = 0;   // respostas válidas de esp/active
+
+    JsonDocument batchDoc;
+    uint32_t batchStartMs = 0;
+    uint8_t batchRecords = 0;
+    bool batchDurable = false;
+    // Avisados com a resposta do lote; com seq, ok só se o servidor gravou
+    // o registro (acked.state), não basta o lote ter sido aceito
+    struct BatchCallback {
+        uint32_t seq;
+        HttpDoneCallback cb;
+    };
+    std::vector<BatchCallback> batchCallbacks;
+    uint32_t batchesSent = 0;
+    uint32_t batchedRecords = 0;
+
+    // durable: leva sequência e volta para a fila offline se o lote falhar
+    JsonObject addToBatch(const char* section, const JsonDocument& record,
+                          bool durable = false);
+    void flushBatch();
+
+    // Uplink (esp/batch) em MessagePack: bytes enviados, o que o mesmo
+    // documento daria em JSON e tempo de serialização
+    uint32_t packedBytes = 0;
+    uint32_t packedJsonBytes = 0;
+    uint32_t packCount = 0;
+    uint32_t packUsTotal = 0;
+    uint32_t packUsMax = 0;
+
+    // Heap no pico de cada envio (documento e corpo serializado juntos):
+    // menor heap livre, menor bloco contíguo e maior fragmentação (%)
+    uint32_t bodyHeapMin = 0xFFFFFFFF;
+    uint32_t bodyBlockMin = 0xFFFFFFFF;
+    uint8_t bodyFragMax = 0;
+
+    String packBody(const JsonDocument& doc);
+    void noteBodyHeap();
 
-    bool makeRequest(const String& endpoint, const String& method, 
-                    const JsonDocument* payloadDoc, String& response);
+    // Respostas JSON: tempo de parse, maior corpo recebido e menor heap
+    // livre com corpo e documento juntos
+    uint32_t parseCount = 0;
+    uint32_t parseUsTotal = 0;
+    uint32_t parseUsMax = 0;
+    uint32_t parseBytesMax = 0;
+    uint32_t parseHeapMin = 0xFFFFFFFF;
+    uint32_t notModifiedCount = 0;   // respostas 304
+
+    String lastEtag;   // ETag da resposta em entrega
+
+    bool post(const String& endpoint, const JsonDocument& payloadDoc,
+              HttpDoneCallback callback, const char* context,
+              bool msgpack = false);
+    bool getJson(const String& endpoint, HttpJsonCallback callback,
+                 const char* context, HttpJsonFilter filter = nullptr,
+                 const String& ifNoneMatch = String());
 
 public:
     FermentadorHTTPClient();
-    ~FermentadorHTTPClient();
-    
+
+    void begin();
+    void loop();   // entrega as respostas; chamar a cada passe do loop()
+
     // ==================== FERMENTAÇÃO ====================
-    bool getActiveFermentation(JsonDocument& doc);
-    bool getConfiguration(const char* configId, JsonDocument& doc);
-    bool updateFermentationState(const char* configId, const JsonDocument& doc);
-    bool notifyTargetReached(const char* configId);
-    bool updateStageIndex(const char* configId, int newStageIndex);
+    // ifNoneMatch: ETag já processado; sem mudança, doc chega nulo (304)
+    bool getActiveFermentation(HttpJsonCallback callback,
+                               const String& ifNoneMatch = String());
+    bool getConfiguration(const char* configId, HttpJsonCallback callback,
+                          const String& ifNoneMatch = String());
+    // callback: resposta do lote em que o estado foi (base dos deltas)
+    bool updateFermentationState(const char* configId, const JsonDocument& doc,
+                                 HttpDoneCallback callback = nullptr);
+    bool notifyTargetReached(const char* configId, HttpDoneCallback callback = nullptr);
+    bool updateStageIndex(const char* configId, int newStageIndex,
+                          HttpDoneCallback callback = nullptr);
 
     // ==================== COMANDOS ====================
-    String getPendingCommand(int configId);
+    // Comando vazio = nenhum pendente ou falha na consulta
+    bool getPendingCommand(int configId, HttpCommandCallback callback);
 
     // ==================== LEITURAS ====================
     bool sendReading(const char* configId, float tempFridge, 
@@ -48,16 +127,42 @@ public:
     // ==================== SENSORES ====================
     bool sendSensors(const JsonDocument& sensorsDoc);
     bool sendSensorsData(const JsonDocument& sensorsDoc);
-    bool getAssignedSensors(String& fermenterAddr, String& fridgeAddr);
+    bool getAssignedSensors(HttpSensorsCallback callback);
     bool updateCurrentTemperatures(float tempFermenter, float tempFridge);
     bool sendSensorError(const char* configId, float tempTarget);
     
     // ==================== ISPINDEL ====================
-    bool sendSpindelData(const String& spindelJson);
+    bool sendSpindelData(const JsonDocument& spindelDoc);
+
+    // Lote da fila offline (telemetry_queue); callback(true) = servidor deu
+    // a palavra final (2xx ou 4xx) e os registros não precisam voltar
+    bool sendQueuedBatch(const JsonDocument& doc, HttpDoneCallback callback);
  
     // ==================== UTILIDADES ====================
     bool isConnected();
+    uint8_t pendingRequests() const { return asyncHttp.pending(); }
     void printError(const char* context);
+    uint32_t getActiveOkCount() const { return activeOkCount; }
+    uint32_t getBatchesSent() const { return batchesSent; }
+    uint32_t getBatchedRecords() const { return batchedRecords; }
+    uint32_t getPackedBytes() const { return packedBytes; }
+    uint32_t getPackedJsonBytes() const { return packedJsonBytes; }
+    uint32_t getPackAvgUs() const { return packCount ? packUsTotal / packCount : 0; }
+    uint32_t getPackMaxUs() const { return packUsMax; }
+    uint32_t getBodyHeapMin() const { return bodyHeapMin == 0xFFFFFFFF ? 0 : bodyHeapMin; }
+    uint32_t getBodyBlockMin() const { return bodyBlockMin == 0xFFFFFFFF ? 0 : bodyBlockMin; }
+    uint8_t getBodyFragMax() const { return bodyFragMax; }
+    uint32_t getParseAvgUs() const { return parseCount ? parseUsTotal / parseCount : 0; }
+    uint32_t getParseMaxUs() const { return parseUsMax; }
+    uint32_t getParseBytesMax() const { return parseBytesMax; }
+    uint32_t getParseHeapMin() const { return parseHeapMin == 0xFFFFFFFF ? 0 : parseHeapMin; }
+    uint32_t getNotModifiedCount() const { return notModifiedCount; }
+
+    // ETag da resposta JSON cujo callback está rodando (vazio fora dele)
+    const String& getLastEtag() const { return lastEtag; }
+    uint8_t getPackSavedPercent() const {
+        return packedJsonBytes ? 100 - (uint8_t)((uint64_t)packedBytes * 100 / packedJsonBytes) : 0;
+    }
 
     bool sendHeartbeat(int configId, const DetailedControlStatus& status, temperature beerTemp, temperature fridgeTemp);
 };
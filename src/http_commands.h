@@ -5,11 +5,9 @@
 #include "http_client.h"
 #include "preferences_utils.h"
 
-inline void checkPendingCommands() {
-    if (!fermentacaoState.active || !isValidString(fermentacaoState.activeId)) return;
-
-    String command = httpClient.getPendingCommand(atoi(fermentacaoState.activeId));
+inline void executePendingCommand(const String& command) {
     if (command.length() == 0) return;
+    if (!fermentacaoState.active) return;
 
     Serial.printf("[CMD] Executando: %s\n", command.c_str());
 
@@ -43,4 +41,18 @@ inline void checkPendingCommands() {
         Serial.printf("[CMD] ✅ Avançado para etapa %d/%d (alvo: %.1f°C)\n",
                       nextIndex + 1, fermentacaoState.totalStages, newTarget);
     }
-}
\ No newline at end of file
+}
+
+// Só enfileira a consulta; o comando é executado quando a resposta chegar
+inline void checkPendingCommands() {
+    static bool pending = false;
+
+    if (!fermentacaoState.active || !isValidString(fermentacaoState.activeId)) return;
+    if (pending) return;
+
+    pending = httpClient.getPendingCommand(atoi(fermentacaoState.activeId),
+        [](const String& command) {
+            pending = false;
+            executePendingCommand(command);
+        });
+}
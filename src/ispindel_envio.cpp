@@ -13,6 +13,7 @@
 #include "network_manager.h"
 #include "globais.h"
 #include "controle_fermentacao.h"
+#include "telemetry_queue.h"
 
 // Cliente HTTP
 extern FermentadorHTTPClient httpClient;
@@ -107,6 +108,21 @@ void processCloudUpdatesiSpindel() {
         if (mysqlOk) {
             Serial.println(F("[MySQL] ✅ Dados iSpindel enviados (vinculados ao config_id)"));
         }
+    } else if (fermentacaoState.active && isValidString(fermentacaoState.activeId)) {
+        // Sem link: a amostra vai para a fila offline e sai quando ele voltar
+        JsonDocument mysqlDoc;
+        mysqlDoc["name"] = mySpindel.name;
+        mysqlDoc["temperature"] = mySpindel.temperature;
+        mysqlDoc["gravity"] = mySpindel.gravity;
+        mysqlDoc["battery"] = mySpindel.battery;
+        mysqlDoc["angle"] = mySpindel.angle;
+        mysqlDoc["config_id"] = fermentacaoState.activeId;
+
+        mysqlOk = telemetryQueuePush("ispindel", mysqlDoc);
+
+        if (mysqlOk) {
+            Serial.println(F("[MySQL] 📦 Sem link: iSpindel guardado na fila offline"));
+        }
     } else if (!fermentacaoState.active && isHTTPOnline()) {
         // Opcional: log para indicar por que não está enviando
         static unsigned long lastLog = 0;
@@ -115,7 +131,6 @@ void processCloudUpdatesiSpindel() {
             lastLog = millis();
         }
     }
-    // Se !isHTTPOnline(), já tratado no Brewfather/outros logs
 
     sucesso = brewfatherOk || mysqlOk;
 
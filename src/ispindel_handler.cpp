@@ -10,6 +10,7 @@
 #include "controle_fermentacao.h"
 #include "definitions.h"  // Para SERVER_URL e isValidString
 #include "globais.h"      // Para fermentacaoState
+#include "exotherm_estimator.h"
 
 // Definição real da variável global
 SpindelData mySpindel;
@@ -121,6 +122,9 @@ void setupSpindelRoutes(ESP8266WebServer& server) {
         mySpindel.lastUpdate  = millis();
         mySpindel.newDataAvailable = true;
 
+        // Histórico de gravidade para o feed-forward da exotermia
+        exothermAddGravity(gravity, mySpindel.lastUpdate);
+
         // Log 4: Confirmação de processamento
         LOG_ISPINDEL("[iSpindel] Dados processados e armazenados");
 
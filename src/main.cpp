@@ -35,20 +35,27 @@
 #include "BrewPiTicks.h"
 #include "TempSensor.h"
 #include "BrewPiTempControl.h"
+#include "BrewPiTrace.h"
+#include "HeaterPwm.h"
+#include "exotherm_estimator.h"
+#include "scheduler.h"
 #include "ota.h"
 #include "wifi_manager.h"
 #include "network_manager.h"
+#include "clock_sync.h"
+#include "ota_health.h"
+#include "telemetry_queue.h"
+#include "coroutine.h"
+#include "console.h"
+#include "control_history.h"
+#include "control_profiles.h"
 #include "preferences_utils.h"
 #include "http_commands.h"
+#include "preferences_layout.h"
 #include <LittleFS.h>
 
 ESP8266WebServer server(80);
 
-unsigned long lastTemperatureControl = 0;
-unsigned long lastPhaseCheck = 0;
-unsigned long lastSensorCheck = 0;
-
-const unsigned long SENSOR_CHECK_INTERVAL = 30000;
 
 // ========== Funções Auxiliares ==========
 
@@ -83,172 +90,665 @@ String getBuildTimeShort() {
     return String(timeBuf);
 }
 
-// ========== Setup NTP Melhorado ==========
+// ========== Relógio (SNTP assíncrono) ==========
 
+// Só dispara o SNTP: a sincronização chega pelo callback do clock_sync,
+// sem prender o setup() nem o loop() esperando a rede
 void setupNTP() {
-    LOG_MAIN(F("\n╔════════════════════════════════════╗"));
-    LOG_MAIN(F("║     SINCRONIZANDO RELÓGIO NTP      ║"));
-    LOG_MAIN(F("╚════════════════════════════════════╝"));
+    LOG_MAIN(F("[NTP] Iniciando SNTP em segundo plano"));
+    clockBegin(NTP_SERVER1, NTP_SERVER2, NTP_SERVER3);
+}
+
+void printClockStatus() {
+    char buffer[96];
+    time_t now = clockNow();
+
+    consolePrint("\n╔════════════════════════════════════════╗");
+    consolePrint("║      DIAGNÓSTICO DO RELÓGIO NTP        ║");
+    consolePrint("╠════════════════════════════════════════╣");
+
+    if (now < CLOCK_VALID_EPOCH) {
+        consolePrint("║ Status:     ❌ DESSINCRONIZADO         ║");
+        consolePrint("║ Digite 'SYNC' para forçar NTP          ║");
+        consolePrint("╚════════════════════════════════════════╝\n");
+        return;
+    }
+
+    struct tm timeinfo;
+    gmtime_r(&now, &timeinfo);
+
+    consolePrint(clockIsSynced() ? "║ Status:     ✅ SINCRONIZADO            ║"
+                              : "║ Status:     ⚠️  BACKUP (sem SNTP)       ║");
+    snprintf(buffer, sizeof(buffer), "║ Data: %02d/%02d/%04d  Hora UTC: %02d:%02d:%02d ║",
+             timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
+             timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
+    consolePrint(buffer);
+
+    if (clockIsSynced()) {
+        snprintf(buffer, sizeof(buffer), "║ Erro máx: ±%lu ms, última sync há %lus",
+                 (unsigned long)clockErrorMs(), (unsigned long)clockSecondsSinceSync());
+        consolePrint(buffer);
+        snprintf(buffer, sizeof(buffer), "║ Deriva: %.1f ppm%s, %lu syncs, correção %ld ms",
+                 clockDriftPpm(), clockDriftCalibrated() ? "" : " (não calibrada)",
+                 (unsigned long)clockSyncCount(), (long)clockLastOffsetMs());
+        consolePrint(buffer);
+    } else {
+        consolePrint("║ Erro: desconhecido (tempo desligado)   ║");
+    }
+    consolePrint("╚════════════════════════════════════════╝\n");
+}
+
+// ========== Trace do Controle ==========
+
+// Liga/desliga a gravação e persiste a escolha (sobrevive a reboot)
+void setControlTrace(bool enabled) {
+    bool ok = true;
     
-    configTime(0, 0, NTP_SERVER1, NTP_SERVER2, NTP_SERVER3);
+    if (enabled) {
+        ok = brewPiControl.startTrace();
+    } else {
+        brewPiControl.stopTrace();
+    }
     
-    telnetLog("[NTP] Aguardando sincronização");
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_FERMENT, false);
+    prefs.putBool(KEY_TRACE_ON, enabled && ok);
+    prefs.end();
     
-    int timeout = 0;
-    time_t now = time(nullptr);
+    char buffer[80];
+    snprintf(buffer, sizeof(buffer), "[Trace] %s",
+             !enabled ? "⏹️  Gravação parada" :
+             ok ? "🔴 Gravando entradas do controle" : "❌ Falha ao iniciar gravação");
+    consolePrint(buffer);
+}
+
+void restoreControlTrace() {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_FERMENT, true);
+    bool enabled = prefs.getBool(KEY_TRACE_ON, false);
+    prefs.end();
     
-    while (now < 1577836800L && timeout < 100) {
-        delay(100);
-        now = time(nullptr);
-        timeout++;
+    if (enabled) {
+        brewPiControl.startTrace();
     }
-        
-    if (now >= 1577836800L) {
-        struct tm timeinfo;
-        gmtime_r(&now, &timeinfo);
-        
-        LOG_MAIN(F("[NTP] Sincronização bem-sucedida!"));
-        
-        char buffer[80];
-        snprintf(buffer, sizeof(buffer), 
-                "[NTP] Data/Hora UTC: %02d/%02d/%04d %02d:%02d:%02d",
-                timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-                timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-        LOG_MAIN(buffer);
-        
-        snprintf(buffer, sizeof(buffer), "[NTP] Epoch: %lu", (unsigned long)now);
-        LOG_MAIN(buffer);
-        
-        // Salva backup em Preferences
-        Preferences prefs;
-        prefs.begin("ferment", false);
-        prefs.putULong("lastEpoch", now);
-        prefs.putULong("lastMillis", millis());
-        prefs.end();
-        
-        LOG_MAIN(F("[NTP] Backup salvo em Preferences"));
-        
+}
+
+// ========== Console (Serial e telnet) ==========
+
+static void cmdStatus(const char* args) {
+    (void)args;
+    char buffer[96];
+    DetailedControlStatus st = brewPiControl.getDetailedStatus();
+
+    consolePrint("\n━━━━━━━━━━━━━━━━ STATUS ━━━━━━━━━━━━━━━━");
+    snprintf(buffer, sizeof(buffer), "Controle:  %s (modo %c)%s%s",
+             st.stateName.c_str(), brewPiControl.getMode(),
+             st.isWaiting ? ", " : "", st.isWaiting ? st.waitReason.c_str() : "");
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Cerveja:   %.2f°C (alvo %.2f°C)",
+             tempToFloat(brewPiControl.getBeerTemp()), tempToFloat(brewPiControl.getBeerSetting()));
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Geladeira: %.2f°C (alvo %.2f°C)",
+             tempToFloat(brewPiControl.getFridgeTemp()), tempToFloat(brewPiControl.getFridgeSetting()));
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Saídas:    cooler %s, aquecedor %s (duty %u‰), ff %.2f°C",
+             st.coolerActive ? "ON" : "OFF", st.heaterActive ? "ON" : "OFF",
+             st.heaterDuty, st.feedForward);
+    consolePrint(buffer);
+
+    if (fermentacaoState.active || fermentacaoState.paused) {
+        snprintf(buffer, sizeof(buffer), "Fermentação %s: etapa %d/%d, alvo %.1f°C%s",
+                 fermentacaoState.activeId,
+                 fermentacaoState.currentStageIndex + 1, fermentacaoState.totalStages,
+                 fermentacaoState.tempTarget,
+                 fermentacaoState.paused ? " (PAUSADA)" : "");
     } else {
-        LOG_MAIN(F("[NTP] FALHA NA SINCRONIZAÇÃO!"));
-        LOG_MAIN(F("[NTP] Tentando usar backup..."));
-        
-        Preferences prefs;
-        prefs.begin("ferment", true);
-        time_t backupEpoch = prefs.getULong("lastEpoch", 0);
-        unsigned long backupMillis = prefs.getULong("lastMillis", 0);
-        prefs.end();
-        
-        if (backupEpoch > 1577836800L) {
-            unsigned long elapsed = (millis() - backupMillis) / 1000;
-            time_t estimatedNow = backupEpoch + elapsed;
-            
-            struct tm timeinfo;
-            gmtime_r(&estimatedNow, &timeinfo);
-            
-            LOG_MAIN(F("[NTP] Usando horário estimado do backup:"));
-            
-            char buffer[80];
-            snprintf(buffer, sizeof(buffer),
-                    "[NTP] Data/Hora UTC: %02d/%02d/%04d %02d:%02d:%02d",
-                    timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-            LOG_MAIN(buffer);
-            
-            snprintf(buffer, sizeof(buffer), "[NTP] Precisão: ±%lu segundos", elapsed);
-            LOG_MAIN(buffer);
-            
-            LOG_MAIN(F("[NTP] ATENÇÃO: Contagem de etapas pode estar imprecisa!"));
-        } else {
-            LOG_MAIN(F("[NTP] Sem backup válido!"));
-            LOG_MAIN(F("[NTP] Sistema funcionará com horário inválido"));
-            LOG_MAIN(F("[NTP] Contagem de etapas NÃO funcionará!"));
-        }
+        snprintf(buffer, sizeof(buffer), "Fermentação: nenhuma ativa");
     }
-    
-    LOG_MAIN("");
+    consolePrint(buffer);
+
+    snprintf(buffer, sizeof(buffer), "WiFi: %s, RSSI %d dBm | uptime %lus",
+             wifiStateName(), (int)WiFi.RSSI(), millis() / 1000UL);
+    consolePrint(buffer);
+    consolePrint("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
 }
 
-// ========== Check NTP Melhorado ==========
+static void cmdMetrics(const char* args) {
+    (void)args;
+    char buffer[128];
+    uint32_t otaBytes, otaMs;
+    getLastOTAStats(otaBytes, otaMs);
+
+    consolePrint("\n━━━━━━━━━━━━━━━━ MÉTRICAS ━━━━━━━━━━━━━━━━");
+    snprintf(buffer, sizeof(buffer), "Heap: %u livres, maior bloco %u, fragmentação %u%%",
+             ESP.getFreeHeap(), ESP.getMaxFreeBlockSize(), ESP.getHeapFragmentation());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Boot: 1º tick %lu ms, WiFi %lu ms, servidor %lu ms",
+             (unsigned long)bootMetrics.firstTickMs, (unsigned long)bootMetrics.wifiMs,
+             (unsigned long)bootMetrics.syncMs);
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Escalonador: %lu estouros de orçamento",
+             (unsigned long)scheduler.getTotalOverruns());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "WiFi: %lu quedas (última %lus, motivo %u)",
+             (unsigned long)wifiGetReconnects(), (unsigned long)wifiLastOutageSeconds(),
+             wifiLastDisconnectReason());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Relógio: %s, erro ±%lu ms, deriva %.1f ppm",
+             clockIsSynced() ? "sincronizado" : "sem SNTP",
+             (unsigned long)clockErrorMs(), clockDriftPpm());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "HTTP: %lu respostas válidas de esp/active, %lu lotes (%lu registros)",
+             (unsigned long)httpClient.getActiveOkCount(),
+             (unsigned long)httpClient.getBatchesSent(),
+             (unsigned long)httpClient.getBatchedRecords());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "HTTP: fila %u, %lu ok, %lu falhas (%lu prazo), %lu descartadas, latência %lu/%lu/%lu ms",
+             asyncHttp.pending(), (unsigned long)asyncHttp.getCompleted(),
+             (unsigned long)asyncHttp.getFailed(), (unsigned long)asyncHttp.getTimeouts(),
+             (unsigned long)asyncHttp.getDropped(), (unsigned long)asyncHttp.getLastLatencyMs(),
+             (unsigned long)asyncHttp.getAvgLatencyMs(), (unsigned long)asyncHttp.getMaxLatencyMs());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "HTTP: %u%% reaproveitadas, %lu conexões, %lu em pipeline, %lu reenvios%s",
+             asyncHttp.getReusePercent(), (unsigned long)asyncHttp.getConnects(),
+             (unsigned long)asyncHttp.getPipelined(), (unsigned long)asyncHttp.getRetries(),
+             asyncHttp.isConnected() ? " (conectado)" : "");
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Uplink: %lu bytes MessagePack (JSON: %lu, -%u%%), serialização %lu/%lu us",
+             (unsigned long)httpClient.getPackedBytes(), (unsigned long)httpClient.getPackedJsonBytes(),
+             httpClient.getPackSavedPercent(), (unsigned long)httpClient.getPackAvgUs(),
+             (unsigned long)httpClient.getPackMaxUs());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Envio: heap mín %lu, maior bloco mín %lu, fragmentação máx %u%%",
+             (unsigned long)httpClient.getBodyHeapMin(), (unsigned long)httpClient.getBodyBlockMin(),
+             httpClient.getBodyFragMax());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Respostas: parse %lu/%lu us, maior corpo %lu bytes, heap mín %lu, %lu sem mudança (304)",
+             (unsigned long)httpClient.getParseAvgUs(), (unsigned long)httpClient.getParseMaxUs(),
+             (unsigned long)httpClient.getParseBytesMax(), (unsigned long)httpClient.getParseHeapMin(),
+             (unsigned long)httpClient.getNotModifiedCount());
+    consolePrint(buffer);
+    uint32_t stateSent, stateFull;
+    getStateUploadStats(stateSent, stateFull);
+    snprintf(buffer, sizeof(buffer), "Estado: %lu bytes em deltas/keyframes (só completos: %lu)",
+             (unsigned long)stateSent, (unsigned long)stateFull);
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "Fila offline: %lu bytes, %lu gravados, %lu confirmados, %lu descartados",
+             (unsigned long)telemetryQueueBytes(), (unsigned long)telemetryQueuePushed(),
+             (unsigned long)telemetryQueueSent(), (unsigned long)telemetryQueueDropped());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "OTA: último %lu bytes em %lu ms | trace %lu bytes",
+             (unsigned long)otaBytes, (unsigned long)otaMs,
+             (unsigned long)brewPiTrace.getBytesWritten());
+    consolePrint(buffer);
+    consolePrint("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
 
-void checkNTPSync() {
-    static unsigned long lastCheck = 0;
-    
-    if (millis() - lastCheck < 3600000UL) {
+// history [n]: últimas n amostras (padrão 10), mais recente primeiro
+static void cmdHistory(const char* args) {
+    char buffer[96];
+    int n = (*args) ? atoi(args) : 10;
+    if (n <= 0) n = 10;
+    if (n > historyCount()) n = historyCount();
+
+    snprintf(buffer, sizeof(buffer), "\n[Histórico] %d de %u amostras (1/min)",
+             n, historyCount());
+    consolePrint(buffer);
+    consolePrint("  idade(s)  cerveja/alvo    geladeira/alvo  est duty");
+
+    ControlSample sample;
+    for (uint8_t age = 0; age < n && historyGet(age, sample); age++) {
+        snprintf(buffer, sizeof(buffer), "  %8lu  %6.2f/%6.2f  %6.2f/%6.2f  %3u %4u",
+                 (millis() - sample.ms) / 1000UL,
+                 tempToFloat(sample.beer), tempToFloat(sample.beerSetting),
+                 tempToFloat(sample.fridge), tempToFloat(sample.fridgeSetting),
+                 sample.state, sample.heaterDuty);
+        consolePrint(buffer);
+    }
+}
+
+// cc: lista; cc <nome> <valor>: ajusta em operação
+static void cmdConstants(const char* args) {
+    if (*args == '\0') {
+        printControlConstants();
+        return;
+    }
+
+    char name[24];
+    float value;
+    if (sscanf(args, "%23s %f", name, &value) != 2) {
+        consolePrint("[cc] Uso: cc <nome> <valor>");
         return;
     }
+
+    char buffer[64];
+    snprintf(buffer, sizeof(buffer), setControlConstant(name, value)
+             ? "[cc] ✅ %s = %.3f" : "[cc] ❌ %s: nome ou valor inválido (%.3f)",
+             name, value);
+    consolePrint(buffer);
+}
+
+// trace: situação; trace start|stop
+static void cmdTrace(const char* args) {
+    if (strcasecmp(args, "start") == 0) {
+        setControlTrace(true);
+    } else if (strcasecmp(args, "stop") == 0) {
+        setControlTrace(false);
+    } else {
+        char buffer[80];
+        snprintf(buffer, sizeof(buffer), "[Trace] %s, %lu bytes no arquivo atual",
+                 brewPiTrace.isRecording() ? "GRAVANDO" : "PARADO",
+                 (unsigned long)brewPiTrace.getBytesWritten());
+        consolePrint(buffer);
+    }
+}
+
+static void cmdTasks(const char* args) {
+    (void)args;
+    scheduler.printStats();
+    coPrintStats();
+}
+
+static void cmdClock(const char* args) {
+    (void)args;
+    printClockStatus();
+}
+
+static void cmdSync(const char* args) {
+    (void)args;
+    consolePrint("\n[Comando] Forçando sincronização NTP...");
+    clockForceSync();
+}
+
+static void cmdWifi(const char* args) {
+    (void)args;
+    char buffer[96];
+    snprintf(buffer, sizeof(buffer), "[WiFi] %s em '%s', RSSI %d dBm, %lu quedas (última: %lus, motivo %u)",
+             wifiStateName(), wifiCurrentSsid(), (int)WiFi.RSSI(),
+             (unsigned long)wifiGetReconnects(),
+             (unsigned long)wifiLastOutageSeconds(),
+             wifiLastDisconnectReason());
+    consolePrint(buffer);
+    snprintf(buffer, sizeof(buffer), "[WiFi] Última conexão em %lu ms (%s), canal %d, BSSID %s",
+             (unsigned long)wifiLastReconnectMs(), wifiLastReconnectFast() ? "rápida" : "varredura",
+             WiFi.channel(), WiFi.BSSIDstr().c_str());
+    consolePrint(buffer);
+}
+
+static void setupConsole() {
+    consoleRegister("status",  "estado do controle, fermentação e WiFi", cmdStatus);
+    consoleRegister("metrics", "heap, boot, estouros, relógio e OTA",    cmdMetrics);
+    consoleRegister("history", "[n] últimas amostras do controle",       cmdHistory);
+    consoleRegister("cc",      "[nome valor] constantes do controle",    cmdConstants);
+    consoleRegister("trace",   "[start|stop] gravação do controle",      cmdTrace);
+    consoleRegister("tasks",   "tarefas do escalonador e fluxos",        cmdTasks);
+    consoleRegister("time",    "diagnóstico do relógio",                 cmdClock);
+    consoleRegister("clock",   nullptr,                                  cmdClock);
+    consoleRegister("ntp",     nullptr,                                  cmdClock);
+    consoleRegister("sync",    "força sincronização NTP",                cmdSync);
+    consoleRegister("wifi",    "estado e quedas do WiFi",                cmdWifi);
+}
+
+// ========== Sensores atribuídos no site ==========
+
+// Estado do fluxo (sobrevive aos pontos de suspensão)
+static bool sensorSyncScan = false;
+static String assignedFermenter, assignedFridge;
+static bool assignedUpdated = false;
+static bool assignedDone = false;
+static bool assignedOk = false;
+
+// Varre (opcional), busca os sensores escolhidos no site, grava no
+// Preferences e reinicia o gerenciador se algo mudou
+static CoStatus sensorSyncFlow(CoState& co) {
+    CO_BEGIN(co);
     
-    lastCheck = millis();
+    if (sensorSyncScan) {
+        scanAndSendSensors();
+        CO_YIELD(co);
+    }
     
-    time_t now = time(nullptr);
+    assignedOk = false;
+    assignedDone = !httpClient.getAssignedSensors(
+        [](bool ok, const String& fermenterAddr, const String& fridgeAddr) {
+            assignedOk = ok;
+            assignedFermenter = fermenterAddr;
+            assignedFridge = fridgeAddr;
+            assignedDone = true;
+        });
+    CO_WAIT_UNTIL(co, assignedDone);
+    if (!assignedOk) CO_EXIT(co);
+    assignedUpdated = false;
+    
+    if (!assignedFermenter.isEmpty() && saveSensorToEEPROM(SENSOR1_NOME, assignedFermenter)) {
+        assignedUpdated = true;
+    }
+    CO_YIELD(co);
     
-    if (now < 1577836800L) {
-        LOG_MAIN(F("\n[NTP] Relógio dessincronizado! Tentando ressincronizar..."));
-        
-        setupNTP();
+    if (!assignedFridge.isEmpty() && saveSensorToEEPROM(SENSOR2_NOME, assignedFridge)) {
+        assignedUpdated = true;
+    }
+    
+    if (assignedUpdated) {
+        CO_YIELD(co);
+        setupSensorManager();
         
-        now = time(nullptr);
-        if (now < 1577836800L) {
-            LOG_MAIN(F("[NTP] Ressincronização FALHOU!"));
-            LOG_MAIN(F("[NTP] Sistema continuará com horário estimado\n"));
-        } else {
-            LOG_MAIN(F("[NTP] Ressincronização bem-sucedida!\n"));
+        DallasTemperature* dallasPtr = getSensorsPointer();
+        if (dallasPtr) {
+            brewPiControl.setSensors(dallasPtr, 1, 0);
         }
     }
+    
+    assignedFermenter = String();
+    assignedFridge = String();
+    
+    CO_END(co);
 }
 
-// ========== Comandos Serial ==========
+static void startSensorSync(bool scan) {
+    if (coIsRunning(sensorSyncFlow)) return;
+    
+    sensorSyncScan = scan;
+    coStart("sensores", sensorSyncFlow);
+}
+
+// ========== Tarefas do Escalonador ==========
+
+static SchedulerTaskId controlTaskId = SCHED_INVALID_TASK;
+static uint32_t lastControlTickMs = 0;
 
-void checkSerialCommands() {
-    if (!Serial.available()) return;
+// Malha rápida do controle (a malha lenta da cerveja é agendada dentro
+// de update() por cc.beerLoopPeriod)
+static void taskControle() {
+    lastControlTickMs = millis();
+    bool sensorsOk;
     
-    String cmd = Serial.readStringUntil('\n');
-    cmd.trim();
-    cmd.toUpperCase();
+    // ← MODIFICADO: roda controle também quando pausado
+    if (fermentacaoState.active || fermentacaoState.paused) {
+        brewPiControl.setGravityDropRate(exothermDropRate(millis()));
+        brewPiControl.update();
+        state.currentTemp = tempToFloat(brewPiControl.getBeerTemp());
+        state.targetTemp = fermentacaoState.tempTarget;
+        sensorsOk = brewPiControl.getBeerTemp() != INVALID_TEMP &&
+                    brewPiControl.getFridgeTemp() != INVALID_TEMP;
+    } else {
+        sensorsOk = sensors.getDeviceCount() > 0;
+    }
     
-    if (cmd == "TIME" || cmd == "CLOCK" || cmd == "NTP") {
-        
-        telnetLog("\n╔════════════════════════════════════════╗");
-        telnetLog("║      DIAGNÓSTICO DO RELÓGIO NTP        ║");
-        telnetLog("╠════════════════════════════════════════╣");
-        
-        time_t now = time(nullptr);
+    historyRecord(lastControlTickMs);
+
+    // Prova pós-OTA: conta ticks com leitura válida
+    otaHealthRecordTick(sensorsOk);
+
+    // Conversão para o próximo tick, sem bloquear os 750ms aqui
+    requestTemperaturesAsync();
+
+    // Perfil de sintonia pode ter mudado o período da malha rápida
+    scheduler.setPeriod(controlTaskId, brewPiControl.getFridgeLoopMs());
+}
+
+// Durante o OTA: chamado pelo loop() e a cada bloco do upload, no mesmo
+// ritmo da tarefa de controle
+static void otaControlTick() {
+    if (millis() - lastControlTickMs < brewPiControl.getFridgeLoopMs()) return;
+    
+    taskControle();
+}
+
+static void taskFase() {
+    verificarTrocaDeFase();
+}
+
+static void taskAlvo() {
+    if (isHTTPOnline()) {
+        verificarTargetAtingido();
+    }
+}
+
+static void taskEstado() {
+    // Sem link, as transições vão para a fila offline
+    enviarEstadoCompletoMySQL();
+}
+
+static void taskHeartbeat() {
+    // Envia heartbeat se estiver ativo OU pausado
+    if (!isHTTPOnline() || strlen(fermentacaoState.activeId) == 0) return;
+    if (!fermentacaoState.active && !fermentacaoState.paused) return;
+
+    int configId = atoi(fermentacaoState.activeId);
+    if (configId > 0) {
+        sendHeartbeatMySQL(configId);
+    }
+}
+
+static void taskComandos() {
+    checkPendingCommands();
+}
+
+static void taskFermentacaoAtiva() {
+    if (isHTTPOnline()) {
+        getTargetFermentacao();
+        checkPauseOrComplete();
+    }
+}
+
+static void taskLeituras() {
+    // Sem link, a leitura vai para a fila offline
+    enviarLeiturasSensoresMySQL();
+}
+
+static void taskFilaOffline() {
+    telemetryQueueLoop();
+}
+
+static void taskSensores() {
+    if (isHTTPOnline()) {
+        float tempF, tempG;
+        bool sensoresOk = readConfiguredTemperatures(tempF, tempG);
         
-        if (now < 1577836800L) {            
-            telnetLog("║ Status:     ❌ DESSINCRONIZADO         ║");
-            telnetLog("║ Digite 'SYNC' para forçar NTP          ║");
-            telnetLog("╚════════════════════════════════════════╝\n");
-        } else {
-            struct tm timeinfo;
-            gmtime_r(&now, &timeinfo);
-            
-            time_t brTime = now - (3 * 3600);
-            gmtime_r(&brTime, &timeinfo);
-            
-            telnetLog("║ Status:     ✅ SINCRONIZADO            ║");
-            char buffer[80];
-            snprintf(buffer, sizeof(buffer), "║ Data: %02d/%02d/%04d  Hora UTC: %02d:%02d:%02d ║",
-                    timeinfo.tm_mday, timeinfo.tm_mon + 1, timeinfo.tm_year + 1900,
-                    timeinfo.tm_hour, timeinfo.tm_min, timeinfo.tm_sec);
-            telnetLog(buffer);
-            telnetLog("╚════════════════════════════════════════╝\n");
-        }
+        char logBuf[80];
+        snprintf(logBuf, sizeof(logBuf), 
+                "[DEBUG] Sensores OK: %s, Ferm: %.1f, Geladeira: %.1f",
+                sensoresOk ? "SIM" : "NAO", tempF, tempG);
+        LOG_SENSORES_MAIN(logBuf);
     }
-    else if (cmd == "SYNC") {
-        telnetLog("\n[Comando] Forçando sincronização NTP...");
-        setupNTP();
+
+    auto lista = listSensors();
+    
+    if (lista.empty() && isHTTPOnline()) {
+        startSensorSync(true);
     }
 }
 
+static void taskISpindel() {
+    processCloudUpdatesiSpindel();
+}
+
+static void taskOtaSaude() {
+    otaHealthLoop();
+}
+
+static void taskNTP() {
+    clockLoop();
+}
+
+static void taskFluxos() {
+    coRunAll();
+}
+
+// Etapa de rede do boot: espera WiFi e servidor, reconcilia sensores e
+// fermentação uma vez e termina
+static CoStatus bootFlow(CoState& co) {
+    char buffer[80];
+    
+    CO_BEGIN(co);
+    
+    CO_WAIT_UNTIL(co, isWiFiOnline());
+    bootMetrics.wifiMs = millis();
+    snprintf(buffer, sizeof(buffer), "[Boot] 📡 WiFi em %lu ms", bootMetrics.wifiMs);
+    LOG_MAIN(buffer);
+    
+    CO_WAIT_UNTIL(co, isHTTPOnline());
+    
+    startSensorSync(false);
+    CO_WAIT_UNTIL(co, !coIsRunning(sensorSyncFlow));
+    
+    if (fermentacaoState.active) {
+        getTargetFermentacao();
+        CO_WAIT_UNTIL(co, !isActiveCheckPending());
+        CO_WAIT_UNTIL(co, !isConfigLoading());
+    }
+    
+    sendHeartbeatMySQL(atoi(fermentacaoState.activeId));
+    
+    bootMetrics.syncMs = millis();
+    snprintf(buffer, sizeof(buffer), "[Boot] ✅ Servidor reconciliado em %lu ms", bootMetrics.syncMs);
+    LOG_MAIN(buffer);
+    
+    CO_END(co);
+}
+
+// ✅ VERIFICAÇÃO DE INTEGRIDADE DO PREFERENCES
+static void taskIntegridade() {
+    // ✅ LOG ANTES DE VERIFICAR fermentacaoState.active
+#ifdef DEBUG_EEPROM
+    char buf[128];
+    snprintf(buf, sizeof(buf), 
+            "[Integrity] Check disparado! active=%s, activeId='%s'", 
+            fermentacaoState.active ? "TRUE" : "FALSE",
+            fermentacaoState.activeId);
+    Serial.println(buf);
+#endif
+
+    if (!fermentacaoState.active) return;
+
+    Preferences p;
+    p.begin("ferment", true);
+    
+    String savedId = p.getString("activeId", "");
+    int savedCfg = p.getInt("cfgSaved", 0);
+    int savedIdx = p.getInt("stageIdx", -1);
+    unsigned long savedEpoch = (unsigned long)p.getULong64("stageStart", 0);
+    int savedReached = p.getInt("tgtReached", 0);
+    
+    p.end();
+    
+#ifdef DEBUG_EEPROM
+    snprintf(buf, sizeof(buf), "[Integrity] RAM activeId='%s', Prefs='%s'", 
+            fermentacaoState.activeId, savedId.c_str());
+    Serial.println(buf);
+    
+    snprintf(buf, sizeof(buf), "[Integrity] RAM stageStart=%lu, Prefs=%lu", 
+            (unsigned long)fermentacaoState.stageStartEpoch, savedEpoch);
+    Serial.println(buf);
+    
+    snprintf(buf, sizeof(buf), "[Integrity] RAM stageIdx=%d, Prefs=%d", 
+            fermentacaoState.currentStageIndex, savedIdx);
+    Serial.println(buf);
+    
+    snprintf(buf, sizeof(buf), "[Integrity] RAM targetReached=%s, Prefs=%d", 
+            fermentacaoState.targetReachedSent ? "true" : "false", savedReached);
+    Serial.println(buf);
+    
+    snprintf(buf, sizeof(buf), "[Integrity] cfgSaved=%d", savedCfg);
+    Serial.println(buf);
+#else
+    (void)savedReached;
+#endif
+    
+    // Verifica corrupção
+    bool corrupted = false;
+    
+    if (savedCfg != 1) {
+#ifdef DEBUG_EEPROM
+        Serial.println(F("cfgSaved != 1 (dados não salvos ou corrompidos)"));
+#endif
+        corrupted = true;
+    }
+    
+    if (savedId != String(fermentacaoState.activeId)) {
+#ifdef DEBUG_EEPROM
+        Serial.println(F("activeId não corresponde"));
+#endif
+        corrupted = true;
+    }
+    
+    if (savedIdx != fermentacaoState.currentStageIndex) {
+#ifdef DEBUG_EEPROM
+        Serial.println(F("stageIdx não corresponde"));
+#endif
+        corrupted = true;
+    }
+    
+    if (fermentacaoState.targetReachedSent && savedEpoch == 0) {
+#ifdef DEBUG_EEPROM
+        Serial.println(F("targetReached=true mas stageStart=0"));
+#endif
+        corrupted = true;
+    }
+    
+    if (corrupted) {
+#ifdef DEBUG_EEPROM
+        Serial.println(F(""));
+        Serial.println(F("╔════════════════════════════════════════════╗"));
+        Serial.println(F("║         CORRUPÇÃO DETECTADA!               ║"));
+        Serial.println(F("╠════════════════════════════════════════════╣"));
+        Serial.println(F("║  Tentando salvar novamente...              ║"));
+        Serial.println(F("╚════════════════════════════════════════════╝"));
+        Serial.println(F(""));
+#endif
+        saveStateToPreferences();
+    } else {
+#ifdef DEBUG_EEPROM
+        Serial.println(F("✅ Integridade OK\n"));
+#endif
+    }
+}
+
+// Período, prioridade e orçamento (ms) de cada tarefa. As tarefas HTTP só
+// serializam e enfileiram (a rede anda em httpClient.loop()); orçamentos
+// maiores ficam para flash, varredura OneWire e o Brewfather (HTTPS).
+// Estado, heartbeat e leituras partem no mesmo tick (6 s, múltiplos de 30 s)
+// para caírem no mesmo lote esp/batch.
+static void setupScheduler() {
+    // O primeiro tick já rodou no setup()
+    controlTaskId = scheduler.add("controle", taskControle,
+                                  brewPiControl.getFridgeLoopMs(), SCHED_PRIO_CONTROL, 250,
+                                  brewPiControl.getFridgeLoopMs());
+    scheduler.add("fluxos",      taskFluxos,           SCHED_TICK_MS,            SCHED_PRIO_HIGH,   500);
+    scheduler.add("fase",        taskFase,             PHASE_CHECK_INTERVAL,     SCHED_PRIO_HIGH,   200);
+    scheduler.add("alvo",        taskAlvo,             TARGET_CHECK_INTERVAL,    SCHED_PRIO_HIGH,   200);
+    scheduler.add("comandos",    taskComandos,         COMMAND_CHECK_INTERVAL,   SCHED_PRIO_NORMAL, 200, 2000);
+    scheduler.add("ativa",       taskFermentacaoAtiva, ACTIVE_CHECK_INTERVAL,    SCHED_PRIO_NORMAL, 200, 4000);
+    scheduler.add("estado",      taskEstado,           STATE_SEND_INTERVAL,      SCHED_PRIO_NORMAL, 300, 6000);
+    scheduler.add("heartbeat",   taskHeartbeat,        HEARTBEAT_INTERVAL,       SCHED_PRIO_NORMAL, 300, 6000);
+    scheduler.add("ispindel",    taskISpindel,         ISPINDEL_FLUSH_INTERVAL,  SCHED_PRIO_LOW,    10000);
+    scheduler.add("sensores",    taskSensores,         SENSOR_CHECK_INTERVAL,    SCHED_PRIO_LOW,    1500);
+    scheduler.add("leituras",    taskLeituras,         READINGS_UPDATE_INTERVAL, SCHED_PRIO_LOW,    200, 6000);
+    scheduler.add("ntp",         taskNTP,              NTP_CHECK_INTERVAL,       SCHED_PRIO_LOW,    200, NTP_CHECK_INTERVAL);
+    scheduler.add("fila",        taskFilaOffline,      TELEMETRY_DRAIN_INTERVAL, SCHED_PRIO_LOW,    300);
+    scheduler.add("ota",         taskOtaSaude,         OTA_HEALTH_INTERVAL,      SCHED_PRIO_LOW,    100);
+    scheduler.add("integridade", taskIntegridade,      INTEGRITY_CHECK_INTERVAL, SCHED_PRIO_LOW,    200, INTEGRITY_CHECK_INTERVAL);
+
+    // Etapa de rede do boot roda como fluxo da tarefa "fluxos"
+    coStart("boot", bootFlow);
+}
+
 // ========== SETUP ==========
 
 void setup() {
     Serial.begin(115200);
-    delay(1000);
-        
+    
+    // =============================================
+    // ETAPA 1: CONTROLE A PARTIR DO ESTADO LOCAL
+    // =============================================
+    // Só Preferences, LittleFS e sensores: nada aqui depende de rede, e o
+    // primeiro tick do controle sai em menos de 1s após um reset
     pinMode(cooler.pino, OUTPUT);
     pinMode(heater.pino, OUTPUT);
     cooler.atualizar();
     heater.atualizar();
+    heaterPwm.begin(&heater);
 
     setupSensorManager();
     
@@ -260,64 +760,66 @@ void setup() {
         brewPiControl.init();
     }
     
+    // Conversão corre enquanto o estado é restaurado
+    requestTemperaturesAsync();
+    
 // ✅ Monta LittleFS antes de restaurar estado
     if (!LittleFS.begin()) {
         LOG_MAIN(F("[LittleFS] ❌ Falha ao montar! Cache offline indisponível."));
     } else {
         LOG_MAIN(F("[LittleFS] ✅ Montado"));
+        restoreControlTrace();
+        
+        // Imagem recém-atualizada: conta o boot da prova (rollback em crash loop)
+        otaHealthBegin();
     }
 
+    // Reserva as sequências mesmo sem LittleFS: os lotes ao vivo também usam
+    telemetryQueueBegin();
+
     setupActiveListener();
-    networkSetup(server);
     
-    // ✅ Telnet APÓS WiFi conectar
-    #if DEBUG_TELNET
-        if (WiFi.status() == WL_CONNECTED) {
-            telnetSetup();
-            LOG_MAIN(F("[Telnet] ✅ Servidor iniciado na porta 23"));
+    if (!fermentacaoState.active) {
+        if (state.targetTemp != DEFAULT_TEMPERATURE) {
+            updateTargetTemperature(DEFAULT_TEMPERATURE);
+        }
+    } else {
+        if (fermentacaoState.tempTarget < MIN_SAFE_TEMPERATURE || 
+            fermentacaoState.tempTarget > MAX_SAFE_TEMPERATURE) {
+            updateTargetTemperature(DEFAULT_TEMPERATURE);
         }
-    #endif
-
-    if (WiFi.status() == WL_CONNECTED) {
-        setupNTP();
     }
     
-    if (isHTTPOnline()) {
-        scanAndSendSensors();
-        
-        String fermenterAddr, fridgeAddr;
-        
-        if (httpClient.getAssignedSensors(fermenterAddr, fridgeAddr)) {
-            bool updated = false;
-            
-            if (!fermenterAddr.isEmpty()) {
-                if (saveSensorToEEPROM(SENSOR1_NOME, fermenterAddr)) {
-                    updated = true;
-                }
-            }
-            
-            if (!fridgeAddr.isEmpty()) {
-                if (saveSensorToEEPROM(SENSOR2_NOME, fridgeAddr)) {
-                    updated = true;
-                }
-            }
-            
-            if (updated) {
-                setupSensorManager();
-                
-                DallasTemperature* dallasPtr = getSensorsPointer();
-                if (dallasPtr) {
-                    brewPiControl.setSensors(dallasPtr, 1, 0);
-                }
-            }
-        }
-        
-        if (fermentacaoState.active) {
-            getTargetFermentacao();
-        }
-        sendHeartbeatMySQL(fermentacaoState.activeId ? atoi(fermentacaoState.activeId) : 0);
+    if (!waitTemperaturesReady(BOOT_CONVERSION_TIMEOUT_MS)) {
+        LOG_MAIN(F("[Boot] ⚠️ Conversão DS18B20 não terminou a tempo"));
     }
     
+    taskControle();
+    bootMetrics.firstTickMs = millis();
+    
+    {
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "[Boot] 🌡️ Primeiro tick do controle em %lu ms",
+                 bootMetrics.firstTickMs);
+        LOG_MAIN(buffer);
+    }
+    
+    // =============================================
+    // ETAPA 2: SERVIÇOS (SEM BLOQUEAR)
+    // =============================================
+    // WiFi, SNTP e HTTP seguem em segundo plano; a reconciliação com o
+    // servidor (sensores, fermentação ativa, heartbeat) é a tarefa "boot"
+    networkSetup(server);
+    
+    #if DEBUG_TELNET
+        // O servidor escuta em qualquer interface: pode subir antes do WiFi
+        telnetSetup();
+        LOG_MAIN(F("[Telnet] ✅ Servidor iniciado na porta 23"));
+    #endif
+
+    // SNTP tenta sozinho quando a rede subir
+    setupNTP();
+    
     setupSpindelRoutes(server);
     
     server.on("/version", HTTP_GET, []() {
@@ -327,6 +829,9 @@ void setup() {
         json += "\"md5\":\"" + ESP.getSketchMD5() + "\",";
         json += "\"size\":" + String(ESP.getSketchSize()) + ",";
         json += "\"free_ota_space\":" + String(ESP.getFreeSketchSpace()) + ",";
+        uint32_t otaBytes, otaMs;
+        getLastOTAStats(otaBytes, otaMs);
+        json += "\"last_ota\":{\"bytes\":" + String(otaBytes) + ",\"ms\":" + String(otaMs) + "},";
         json += "\"control_system\":\"BrewPi\",";
         json += "\"storage\":\"Preferences\"";
         json += "}";
@@ -334,6 +839,23 @@ void setup() {
         server.send(200, "application/json", json);
     });
         
+    // Download do trace do controle (replay em tools/brewpi_replay)
+    server.on("/trace", HTTP_GET, []() {
+        const char* path = server.hasArg("old") ? BREWPI_TRACE_OLD_PATH : BREWPI_TRACE_PATH;
+        
+        brewPiTrace.flush();
+        
+        File f = LittleFS.open(path, "r");
+        if (!f) {
+            server.send(404, "text/plain", "Trace nao encontrado");
+            return;
+        }
+        
+        server.sendHeader("Content-Disposition", "attachment; filename=brewpi_trace.bin");
+        server.streamFile(f, "application/octet-stream");
+        f.close();
+    });
+        
     server.on("/", HTTP_GET, []() {
         String html = R"(
 <!DOCTYPE html>
@@ -460,19 +982,12 @@ void setup() {
     });
     
     setupOTA(server);
+    setOTATickHook(otaControlTick);
     
     server.begin();
     
-    if (!fermentacaoState.active) {
-        if (state.targetTemp != DEFAULT_TEMPERATURE) {
-            updateTargetTemperature(DEFAULT_TEMPERATURE);
-        }
-    } else {
-        if (fermentacaoState.tempTarget < MIN_SAFE_TEMPERATURE || 
-            fermentacaoState.tempTarget > MAX_SAFE_TEMPERATURE) {
-            updateTargetTemperature(DEFAULT_TEMPERATURE);
-        }
-    }
+    setupScheduler();
+    setupConsole();
     
     LOG_MAIN(F("\n✅ Sistema inicializado com sucesso!\n"));
 }
@@ -480,22 +995,16 @@ void setup() {
 // ========== LOOP ==========
 
 void loop() {
-    unsigned long now = millis();
-    
+    // OTA: só o controle continua junto com o upload
     if (isOTAInProgress()) {
         server.handleClient();
         handleOTA();
+        otaControlTick();
         yield();
         return;
     }
     
-    checkSerialCommands();
-    
-    static unsigned long lastCommandCheck = 0;
-    if (now - lastCommandCheck >= 10000) {
-        lastCommandCheck = now;
-        checkPendingCommands();
-    }
+    consoleLoop();
     
     networkLoop();
     server.handleClient();
@@ -505,201 +1014,8 @@ void loop() {
         telnetLoop();
     #endif
     
-    checkNTPSync();
-    
-    if (now - lastTemperatureControl >= 5000) {
-        lastTemperatureControl = now;
-
-        // ← MODIFICADO: roda controle também quando pausado
-        if (fermentacaoState.active || fermentacaoState.paused) {
-            brewPiControl.update();
-            state.currentTemp = tempToFloat(brewPiControl.getBeerTemp());
-            state.targetTemp = fermentacaoState.tempTarget;
-        }
-
-        if (isHTTPOnline()) {
-            verificarTargetAtingido();
-            enviarEstadoCompletoMySQL();
-        }
-    }
-
-if (isHTTPOnline() && strlen(fermentacaoState.activeId) > 0) {
-    // Envia heartbeat se estiver ativo OU pausado
-    if (fermentacaoState.active || fermentacaoState.paused) {
-        int configId = atoi(fermentacaoState.activeId);
-        if (configId > 0) {
-            sendHeartbeatMySQL(configId);
-        }
-    }
-}
-
-    static unsigned long lastCheck = 0;
-    if (isHTTPOnline() && now - lastCheck >= ACTIVE_CHECK_INTERVAL) {
-        lastCheck = now;
-        getTargetFermentacao();
-        checkPauseOrComplete();
-    }
-
-    if (now - lastPhaseCheck >= PHASE_CHECK_INTERVAL) {
-        lastPhaseCheck = now;
-        verificarTrocaDeFase();
-    }
-    
-    static unsigned long lastSpindel = 0;
-    if (now - lastSpindel >= 10000) {
-        lastSpindel = now;
-        processCloudUpdatesiSpindel();
-    }
-    
-    if (isHTTPOnline()) {
-        enviarLeiturasSensoresMySQL();
-        
-        float tempF, tempG;
-        bool sensoresOk = readConfiguredTemperatures(tempF, tempG);
-        
-        char logBuf[80];
-        snprintf(logBuf, sizeof(logBuf), 
-                "[DEBUG] Sensores OK: %s, Ferm: %.1f, Geladeira: %.1f",
-                sensoresOk ? "SIM" : "NAO", tempF, tempG);
-        LOG_SENSORES_MAIN(logBuf);
-    }
-
-    if (now - lastSensorCheck >= SENSOR_CHECK_INTERVAL) {
-        auto lista = listSensors();
-        
-        if (lista.empty()) {
-            if (isHTTPOnline()) {
-                scanAndSendSensors();
-                
-                String fermenterAddr, fridgeAddr;
-                if (httpClient.getAssignedSensors(fermenterAddr, fridgeAddr)) {
-                    
-                    if (!fermenterAddr.isEmpty()) {
-                        saveSensorToEEPROM(SENSOR1_NOME, fermenterAddr);
-                    }
-                    
-                    if (!fridgeAddr.isEmpty()) {
-                        saveSensorToEEPROM(SENSOR2_NOME, fridgeAddr);
-                    }
-                    
-                    setupSensorManager();
-                    DallasTemperature* dallasPtr = getSensorsPointer();
-                    if (dallasPtr) {
-                        brewPiControl.setSensors(dallasPtr, 1, 0);
-                    }
-                }
-            }
-        }
-        
-        lastSensorCheck = now;
-    }
-
-        // ✅ VERIFICAÇÃO DE INTEGRIDADE DO PREFERENCES (a cada 5 minutos)
-    static unsigned long lastIntegrityCheck = 0;
-        if (now - lastIntegrityCheck > 300000) { // 5 minutos
-            lastIntegrityCheck = now;
-            
-            // ✅ LOG ANTES DE VERIFICAR fermentacaoState.active
-    #ifdef DEBUG_EEPROM
-            char buf[128];
-            snprintf(buf, sizeof(buf), 
-                    "[Integrity] Check disparado! active=%s, activeId='%s'", 
-                    fermentacaoState.active ? "TRUE" : "FALSE",
-                    fermentacaoState.activeId);
-            Serial.println(buf);
-    #endif
-
-            if (fermentacaoState.active) {
-                Preferences p;
-                p.begin("ferment", true);
-                
-                String savedId = p.getString("activeId", "");
-                int savedCfg = p.getInt("cfgSaved", 0);
-                int savedIdx = p.getInt("stageIdx", -1);
-                unsigned long savedEpoch = (unsigned long)p.getULong64("stageStart", 0);
-                int savedReached = p.getInt("tgtReached", 0);
-                
-                p.end();
-                
-                char buf[128];
-                snprintf(buf, sizeof(buf), "[Integrity] RAM activeId='%s', Prefs='%s'", 
-                        fermentacaoState.activeId, savedId.c_str());
-                #ifdef DEBUG_EEPROM
-                            Serial.println(buf);
-                #endif
-                            
-                            snprintf(buf, sizeof(buf), "[Integrity] RAM stageStart=%lu, Prefs=%lu", 
-                                    (unsigned long)fermentacaoState.stageStartEpoch, savedEpoch);
-                #ifdef DEBUG_EEPROM
-                            Serial.println(buf);
-                #endif
-                            
-                            snprintf(buf, sizeof(buf), "[Integrity] RAM stageIdx=%d, Prefs=%d", 
-                                    fermentacaoState.currentStageIndex, savedIdx);
-                #ifdef DEBUG_EEPROM
-                            Serial.println(buf);
-                #endif
-                            
-                            snprintf(buf, sizeof(buf), "[Integrity] RAM targetReached=%s, Prefs=%d", 
-                                    fermentacaoState.targetReachedSent ? "true" : "false", savedReached);
-                #ifdef DEBUG_EEPROM
-                            Serial.println(buf);
-                #endif
-                            
-                            snprintf(buf, sizeof(buf), "[Integrity] cfgSaved=%d", savedCfg);
-                #ifdef DEBUG_EEPROM
-                            Serial.println(buf);
-                #endif
-                            
-                            // Verifica corrupção
-                            bool corrupted = false;
-                            
-                            if (savedCfg != 1) {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F("cfgSaved != 1 (dados não salvos ou corrompidos)"));
-                #endif
-                                corrupted = true;
-                            }
-                            
-                            if (savedId != String(fermentacaoState.activeId)) {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F("activeId não corresponde"));
-                #endif
-                                corrupted = true;
-                            }
-                            
-                            if (savedIdx != fermentacaoState.currentStageIndex) {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F("stageIdx não corresponde"));
-                #endif
-                                corrupted = true;
-                            }
-                            
-                            if (fermentacaoState.targetReachedSent && savedEpoch == 0) {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F("targetReached=true mas stageStart=0"));
-                #endif
-                                corrupted = true;
-                            }
-                            
-                            if (corrupted) {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F(""));
-                                Serial.println(F("╔════════════════════════════════════════════╗"));
-                                Serial.println(F("║         CORRUPÇÃO DETECTADA!               ║"));
-                                Serial.println(F("╠════════════════════════════════════════════╣"));
-                                Serial.println(F("║  Tentando salvar novamente...              ║"));
-                                Serial.println(F("╚════════════════════════════════════════════╝"));
-                                Serial.println(F(""));
-                #endif
-                                saveStateToPreferences();
-                            } else {
-                #ifdef DEBUG_EEPROM
-                                Serial.println(F("✅ Integridade OK\n"));
-                #endif
-            }
-        }
-    }
+    // Tarefas periódicas: só as vencidas rodam neste passe
+    scheduler.run();
 
     yield();
-}
\ No newline at end of file
+}
@@ -18,6 +18,9 @@
 #include "debug_config.h"
 #include "message_codes.h"
 #include "ispindel_struct.h"
+#include "network_manager.h"
+#include "telemetry_queue.h"
+#include <memory>
 
 extern FermentadorHTTPClient httpClient;
 
@@ -72,194 +75,107 @@ void formatTimeRemaining(JsonObject& timeRemaining, float remainingH, const char
 }
 
 // =====================================================
-// COMPRESSÃO DE DADOS
+// DELTA DO ESTADO
 // =====================================================
+// O servidor guarda o último estado completo. Entre keyframes, só vão os
+// campos que mudaram desde o último estado CONFIRMADO ("base"), então um
+// delta perdido não deixa buraco: o próximo já leva a mudança. Campo que
+// sumiu vai como null. timestamp e uptime_ms mudam sempre e só vão nos
+// keyframes (o servidor põe a própria hora nos deltas).
 
-void compressStateData(JsonDocument &doc) {
-    #if DEBUG_ENVIODADOS
-    Serial.println(F("[Compress] 🗜️ Iniciando compressão de dados..."));
-    #endif
-    
-    // ========== 1. Comprimir mensagens ==========
-    if (doc["message"].is<const char*>()) {
-        const char* msg = doc["message"].as<const char*>();
-        if (strstr(msg, "Fermentação concluída automaticamente")) {
-            doc["msg"] = MSG_FCONC;
-            doc.remove("message");
-        }
+static JsonDocument lastAckedState;
+static uint32_t lastAckedSeq = 0;
+static uint8_t deltasSinceKeyframe = 0;
+static bool stateKeyframeDue = false;   // estado não confirmado: o próximo vai completo
+static uint32_t stateSentBytes = 0;   // MessagePack dos estados enviados
+static uint32_t stateFullBytes = 0;   // o mesmo se todos fossem completos
+
+static bool isVolatileStateField(JsonString key) {
+    return key == "timestamp" || key == "uptime_ms";
+}
+
+static void buildStateDelta(const JsonDocument& cur, const JsonDocument& base, JsonDocument& out) {
+    for (JsonPairConst kv : cur.as<JsonObjectConst>()) {
+        if (isVolatileStateField(kv.key())) continue;
+        JsonVariantConst prev = base[kv.key()];
+        if (prev.isNull() || prev != kv.value()) out[kv.key()] = kv.value();
     }
-    
-    // ========== 2. Comprimir status de controle ==========
-    if (doc["control_status"].is<JsonObject>()) {
-        JsonObject cs = doc["control_status"].as<JsonObject>();
-        if (cs["state"].is<const char*>()) {
-            const char* state = cs["state"].as<const char*>();
-            
-            if (strstr(state, "Cooling")) {
-                cs["s"] = MSG_COOL;
-                cs.remove("state");
-            } else if (strstr(state, "Heating")) {
-                cs["s"] = MSG_HEAT;
-                cs.remove("state");
-            } else if (strstr(state, "Waiting")) {
-                cs["s"] = MSG_WAIT;
-                cs.remove("state");
-            } else if (strstr(state, "Idle")) {
-                cs["s"] = MSG_IDLE;
-                cs.remove("state");
-            }
-        }
+    for (JsonPairConst kv : base.as<JsonObjectConst>()) {
+        if (isVolatileStateField(kv.key()) || kv.key() == "seq") continue;
+        if (cur[kv.key()].isNull()) out[kv.key()] = nullptr;
     }
-    
-    // ========== 3. Comprimir tipo de etapa ==========
-    if (fermentacaoState.currentStageIndex < fermentacaoState.totalStages) {
-        FermentationStage& stage = fermentacaoState.stages[fermentacaoState.currentStageIndex];
-        switch(stage.type) {
-            case STAGE_TEMPERATURE: doc["st"] = ST_TEMP; break;
-            case STAGE_RAMP: doc["st"] = ST_RAMP; break;
-            case STAGE_GRAVITY: doc["st"] = ST_GRAV; break;
-            case STAGE_GRAVITY_TIME: doc["st"] = ST_GRAVT; break;
-        }
+}
+
+static void sendStateUpdate(JsonDocument& doc) {
+    bool keyframe = lastAckedSeq == 0 || stateKeyframeDue ||
+                    deltasSinceKeyframe + 1 >= STATE_KEYFRAME_EVERY ||
+                    strcmp(lastAckedState["config_id"] | "", fermentacaoState.activeId) != 0;
+
+    uint32_t seq = telemetryQueueNextSeq();
+    JsonDocument out;
+
+    if (keyframe) {
+        out.set(doc);
+        deltasSinceKeyframe = 0;
+        stateKeyframeDue = false;
+    } else {
+        buildStateDelta(doc, lastAckedState, out);
+        out["config_id"] = fermentacaoState.activeId;
+        out["base"] = lastAckedSeq;
+        deltasSinceKeyframe++;
     }
-    
-    // ========== 4. Comprimir timeRemaining ==========
-    bool trCreatedFromTimeRemaining = false;
-    
-    if (!doc["timeRemaining"].isNull() && doc["timeRemaining"].is<JsonObject>()) {
-        JsonObject tr = doc["timeRemaining"].as<JsonObject>();
-        const char* unit = tr["unit"] | "";
-        const char* status = tr["status"] | "";
-        
-        // Formato detailed: [dias, horas, minutos, status]
-        if (strcmp(unit, "detailed") == 0) {
-            int days = tr["days"] | 0;
-            int hours = tr["hours"] | 0;
-            int minutes = tr["minutes"] | 0;
-            
-            JsonArray compactTR = doc["tr"].to<JsonArray>();
-            compactTR.add(days);
-            compactTR.add(hours);
-            compactTR.add(minutes);
-            
-            if (strcmp(status, "running") == 0) {
-                compactTR.add(MSG_RUN);
-            } else if (strcmp(status, "waiting") == 0) {
-                compactTR.add(MSG_WAIT);
-            } else if (strcmp(status, "waiting_gravity") == 0) {
-                compactTR.add(WG);
-            } else if (strcmp(status, MSG_TC) == 0) {
-                compactTR.add(MSG_TC);  // "tc" = time completed
-            } else {
-                compactTR.add(status);
-            }
-            
-            trCreatedFromTimeRemaining = true;
-            doc.remove("timeRemaining");
-            
-            #if DEBUG_ENVIODADOS
-            Serial.printf("[Compress] tr (detailed): [%d, %d, %d, %s]\n", 
-                         days, hours, minutes, status);
-            #endif
-        } 
-        // Formato antigo: [valor, unidade, status]
-        else if (tr["value"].is<float>() || tr["value"].is<int>()) {
-            float value = tr["value"].is<float>() ? tr["value"].as<float>() : (float)tr["value"].as<int>();
-            
-            JsonArray compactTR = doc["tr"].to<JsonArray>();
-            compactTR.add(value);
-            
-            if (strcmp(unit, "hours") == 0) {
-                compactTR.add(UNIT_H);
-            } else if (strcmp(unit, "days") == 0) {
-                compactTR.add(UNIT_D);
-            } else if (strcmp(unit, "minutes") == 0) {
-                compactTR.add(UNIT_M);
-            } else if (strcmp(unit, "indefinite") == 0) {
-                compactTR.add("ind");
-            } else if (strcmp(unit, "completed") == 0) {
-                compactTR.add(MSG_TC);  // "tc" para fermentação concluída
-            } else {
-                compactTR.add(unit);
-            }
-            
-            if (strcmp(status, "running") == 0) {
-                compactTR.add(MSG_RUN);
-            } else if (strcmp(status, "waiting") == 0) {
-                compactTR.add(MSG_WAIT);
-            } else if (strcmp(status, "waiting_gravity") == 0) {
-                compactTR.add(WG);
-            } else if (strcmp(status, MSG_TC) == 0) {
-                compactTR.add(MSG_TC);  // "tc" = time completed
-            } else {
-                compactTR.add(status);
+    out["seq"] = seq;
+
+    stateSentBytes += measureMsgPack(out);
+    stateFullBytes += measureMsgPack(doc) + (keyframe ? 0 : measureMsgPack(out["seq"]) + 4);
+
+    // O estado completo vira a base quando o servidor confirmar ESTE registro
+    // (seq em acked.state). Se ele não foi gravado, o servidor pode não ter a
+    // base que os próximos deltas supõem: força um completo
+    auto sent = std::make_shared<JsonDocument>(std::move(doc));
+    (*sent)["seq"] = seq;
+
+    bool queued = httpClient.updateFermentationState(fermentacaoState.activeId, out,
+        [sent, seq](bool ok) {
+            if (!ok) {
+                stateKeyframeDue = true;
+                return;
             }
-            
-            trCreatedFromTimeRemaining = true;
-            doc.remove("timeRemaining");
-            
-            #if DEBUG_ENVIODADOS
-            Serial.printf("[Compress] tr (legacy): [%.1f, %s, %s]\n", 
-                         value, unit, status);
-            #endif
-        }
-    }
-    
-    // ========== 5. Mapeamento de campos ==========
-    struct FieldMapping {
-        const char* longName;
-        const char* shortName;
-    };
-    
-    FieldMapping fieldMappings[] = {
-        {"config_name", "cn"},
-        {"currentStageIndex", "csi"},
-        {"totalStages", "ts"},
-        {"stageTargetTemp", "stt"},
-        {"pidTargetTemp", "ptt"},
-        {"currentTargetTemp", "ctt"},
-        {"cooling", "c"},
-        {"heating", "h"},
-        {"status", "s"},
-        {"config_id", "cid"},
-        {"completedAt", "ca"},
-        {"timestamp", "tms"},
-        {"uptime_ms", "um"},
-        {"rampProgress", "rp"}
-    };
-    
-    for (const auto& mapping : fieldMappings) {
-        if (!doc[mapping.longName].isNull()) {
-            doc[mapping.shortName] = doc[mapping.longName];
-            doc.remove(mapping.longName);
-        }
-    }
-    
-    // ========== 6. Tratar targetReached ==========
-    if (!doc["targetReached"].isNull()) {
-        if (trCreatedFromTimeRemaining) {
-            doc.remove("targetReached");
-            #if DEBUG_ENVIODADOS
-            Serial.println(F("[Compress] targetReached removido (já temos tr array)"));
-            #endif
-        } else {
-            doc["tr"] = doc["targetReached"].as<bool>();
-            doc.remove("targetReached");
-            #if DEBUG_ENVIODADOS
-            Serial.printf("[Compress] tr (fallback bool): %s\n", 
-                         doc["tr"].as<bool>() ? "true" : "false");
-            #endif
-        }
-    }
-    
+            lastAckedState = std::move(*sent);
+            lastAckedSeq = seq;
+        });
+
     #if DEBUG_ENVIODADOS
-    Serial.println(F("[Compress] ✅ Compressão concluída"));
+    Serial.printf("[Envio] Estado %s (seq %lu, %u bytes): %s\n",
+                  keyframe ? "completo" : "delta", (unsigned long)seq,
+                  (unsigned)measureJson(out), queued ? "✅ Enfileirado" : "❌ Sem conexão");
+    Serial.printf("[DEBUG] Heap livre: %d bytes\n", ESP.getFreeHeap());
+    #else
+    (void)queued;
     #endif
 }
 
+void getStateUploadStats(uint32_t& sentBytes, uint32_t& fullBytes) {
+    sentBytes = stateSentBytes;
+    fullBytes = stateFullBytes;
+}
+
 // =====================================================
 // ENVIAR ESTADO COMPLETO (FUNÇÃO PRINCIPAL)
 // Intervalo: 30 segundos
 // =====================================================
+// Sem link, só as transições (etapa, alvo atingido, conclusão) vão para a
+// fila offline; o estado periódico igual ao anterior é descartado
+static bool isStateTransition() {
+    static int32_t lastKey = -1;
+    int32_t key = (fermentacaoState.currentStageIndex << 2) |
+                  (fermentacaoState.targetReachedSent ? 2 : 0) |
+                  (fermentacaoState.concluidaMantendoTemp ? 1 : 0);
+    bool changed = key != lastKey;
+    lastKey = key;
+    return changed;
+}
+
 void enviarEstadoCompletoMySQL() {
     // ========== VERIFICAÇÕES INICIAIS ==========
     if (!fermentacaoState.active && !fermentacaoState.concluidaMantendoTemp) {
@@ -276,15 +192,7 @@ void enviarEstadoCompletoMySQL() {
         return;
     }
     
-    // ========== CONTROLE DE TEMPO (30 segundos) ==========
-    static unsigned long lastStateSend = 0;
-    unsigned long now = millis();
-    
-    if (now - lastStateSend < 30000) {
-        return;
-    }
-    
-    lastStateSend = now;
+    // Cadência: tarefa "estado" do escalonador (STATE_SEND_INTERVAL)
     
     // ========== PREPARAÇÃO DOS DADOS ==========
     JsonDocument doc;
@@ -415,6 +323,12 @@ void enviarEstadoCompletoMySQL() {
     JsonObject controlStatus = doc["control_status"].to<JsonObject>();
     controlStatus["state"] = detailedStatus.stateName;
     controlStatus["is_waiting"] = detailedStatus.isWaiting;
+    if (detailedStatus.heaterDuty > 0) {
+        controlStatus["heater_duty"] = detailedStatus.heaterDuty / 10.0f;  // %
+    }
+    if (detailedStatus.feedForward < 0.0f) {
+        controlStatus["ff"] = detailedStatus.feedForward;  // °C
+    }
     
     if (detailedStatus.isWaiting) {
         controlStatus["wait_reason"] = detailedStatus.waitReason;
@@ -463,9 +377,12 @@ void enviarEstadoCompletoMySQL() {
         doc["stageType"] = stageTypeStr;
     }
 
+    bool online = canUseHTTP();
+    bool transition = isStateTransition();
+
     // ========== ENVIO DO CONTROLLER_STATE ==========
     // Envia dados específicos para a tabela controller_states
-    if (fermentacaoState.activeId && strlen(fermentacaoState.activeId) > 0) {
+    if (online && strlen(fermentacaoState.activeId) > 0) {
         // Apenas chama a função sem armazenar o resultado
         httpClient.updateControlState(
             fermentacaoState.activeId,
@@ -474,22 +391,22 @@ void enviarEstadoCompletoMySQL() {
             detailedStatus.heaterActive
         );
         
-        LOG_ESTADO("[HTTP] controller_states enviado");
+        LOG_ESTADO("[HTTP] controller_states enfileirado");
     }
     
-    // ========== COMPRESSÃO DOS DADOS ==========
-    compressStateData(doc);
-    
-    // ========== ENVIO ==========
-    #if DEBUG_ENVIODADOS
-    bool stateSendSuccess = httpClient.updateFermentationState(fermentacaoState.activeId, doc);
-    Serial.printf("[Envio] Resultado estado: %s\n", stateSendSuccess ? "✅ Sucesso" : "❌ Falha");
-    Serial.printf("[DEBUG] Heap livre: %d bytes\n", ESP.getFreeHeap());
-    #else
-    httpClient.updateFermentationState(fermentacaoState.activeId, doc);
-    #endif
+    // ========== SEM LINK: FILA OFFLINE ==========
+    if (!online) {
+        if (transition) {
+            telemetryQueuePush("state", doc);
+            LOG_ENVIODADOS("[Envio] Sem link: transição de estado guardada na fila offline");
+        }
+        return;
+    }
+
+    // ========== ENVIO (KEYFRAME OU DELTA) ==========
+    sendStateUpdate(doc);
     
-    LOG_MAIN("[HTTP] Estado completo enviado (30s interval)");
+    LOG_MAIN("[HTTP] Estado enfileirado (30s interval)");
     LOG_MAIN("[DEBUG] State: " + String(detailedStatus.stateName) + 
         ", Cooler: " + (detailedStatus.coolerActive ? "ON" : "OFF") +
         ", Heater: " + (detailedStatus.heaterActive ? "ON" : "OFF"));
@@ -512,12 +429,7 @@ void enviarLeiturasSensoresMySQL() {
         return;
     }
 
-    static unsigned long lastSensorReading = 0;
-    unsigned long now = millis();
-    if (now - lastSensorReading < READINGS_UPDATE_INTERVAL) {
-        return;  // Não loga aqui pois seria muito frequente
-    }
-    lastSensorReading = now;
+    // Cadência: tarefa "leituras" do escalonador (READINGS_UPDATE_INTERVAL)
 
     float tempFermenter, tempFridge;
     if (!readConfiguredTemperatures(tempFermenter, tempFridge)) {
@@ -534,14 +446,23 @@ void enviarLeiturasSensoresMySQL() {
     }
     
     // ✅ ENVIO REAL
-    if (httpClient.isConnected()) {
-        httpClient.sendReading(
+    if (canUseHTTP() && httpClient.sendReading(
             fermentacaoState.activeId,
             tempFridge,
             tempFermenter,
-            fermentacaoState.tempTarget
-        );
+            fermentacaoState.tempTarget)) {
+        return;
     }
+
+    // Sem link: guarda na fila offline com o horário da leitura
+    JsonDocument doc;
+    doc["cid"] = fermentacaoState.activeId;
+    doc["tf"] = tempFridge;
+    doc["tb"] = tempFermenter;
+    doc["tt"] = fermentacaoState.tempTarget;
+    telemetryQueuePush("readings", doc);
+
+    LOG_ENVIODADOS("[Leituras] Sem link: leitura guardada na fila offline");
 }
 
 // =====================================================
@@ -554,13 +475,7 @@ bool sendHeartbeatMySQL(int configId) {
         return false;
     }
     
-    // Controle de tempo interno (30 segundos)
-    static unsigned long lastHeartbeat = 0;
-    unsigned long now = millis();
-    if (now - lastHeartbeat < 30000) {
-        return true;
-    }
-    lastHeartbeat = now;
+    // Cadência: tarefa "heartbeat" do escalonador (HEARTBEAT_INTERVAL)
     
     JsonDocument doc;
     
@@ -578,13 +493,13 @@ bool sendHeartbeatMySQL(int configId) {
     
     // NÃO envia estado de controle - já está em enviarEstadoCompletoMySQL
     
-    String response;
+    // true = enfileirado; o envio acontece em httpClient.loop()
     bool result = httpClient.sendHeartbeat(configId, brewPiControl.getDetailedStatus(), 
                                             beerTemp, fridgeTemp);
     
     #if DEBUG_HEARTBEAT
     if (result) {
-        Serial.println(F("[MySQL] ✅ Heartbeat enviado (simplificado)"));
+        Serial.println(F("[MySQL] ✅ Heartbeat enfileirado (simplificado)"));
     }
     #endif
     
@@ -626,11 +541,9 @@ bool sendISpindelDataMySQL(const JsonDocument& doc) {
         return false;
     }
     
-    // ✅ Usa a função centralizada do httpClient
-    String jsonString;
-    serializeJson(doc, jsonString);
-    
-    bool success = httpClient.sendSpindelData(jsonString);
+    // ✅ Usa a função centralizada do httpClient (o documento vai direto
+    // para o lote, sem passar por String)
+    bool success = httpClient.sendSpindelData(doc);
     
     #if DEBUG_FERMENTATION
     if (success) {
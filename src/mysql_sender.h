@@ -19,6 +19,10 @@ void enviarEstadoCompletoMySQL();
 // Inclui: temp_fridge, temp_fermenter, temp_target, gravity
 void enviarLeiturasSensoresMySQL();
 
+// Bytes (MessagePack) dos estados enviados e quanto seriam só com estados
+// completos, para medir o ganho dos deltas
+void getStateUploadStats(uint32_t& sentBytes, uint32_t& fullBytes);
+
 // Envia heartbeat simplificado (saúde do sistema)
 // Inclui: uptime, free_heap (sem dados de controle - já em enviarEstadoCompleto)
 bool sendHeartbeatMySQL(int configId);
@@ -36,8 +40,5 @@ void sendStagesSummaryMySQL();
 // FUNÇÕES AUXILIARES DE FORMATAÇÃO
 // =====================================================
 
-// Comprime dados de estado para reduzir tamanho do JSON
-void compressStateData(JsonDocument &doc);
-
 // Formata tempo restante no objeto JSON
 void formatTimeRemaining(JsonObject& timeRemaining, float remainingH, const char* status);
@@ -18,7 +18,7 @@ static bool sensorsScanned = false;
 static unsigned long lastHttpAttempt = 0;
 static unsigned int httpAttemptCount = 0;
 static unsigned long wifiStableSince = 0;
-static unsigned long lastWiFiCheck = 0;
+static bool httpProbePending = false;
 
 static ESP8266WebServer* webServer = nullptr;
 
@@ -26,7 +26,6 @@ static ESP8266WebServer* webServer = nullptr;
 // CONSTANTES
 // =================================================
 
-static const unsigned long NET_WIFI_CHECK_INTERVAL = 60000; // 1 min
 static const unsigned long NET_WIFI_STABLE_TIME = 15000; // 15 s
 static const unsigned long HTTP_RETRY_INTERVAL = 10000; // 10 seg entre tentativas
 static const unsigned int MAX_HTTP_ATTEMPTS = 3; // Máximo de tentativas consecutivas
@@ -37,7 +36,8 @@ static const unsigned long MAX_ATTEMPTS_COOLDOWN = 60000; // 1 min após max ten
 // =================================================
 
 bool isWiFiOnline() {
-    return wifiOnline;
+    // Tempo real: os eventos do WiFi atualizam o estado na hora
+    return wifiIsConnected();
 }
 
 bool isHTTPOnline() {
@@ -49,7 +49,7 @@ bool isOTAOnline() {
 }
 
 bool canUseHTTP() {
-    return wifiOnline && httpOnline;
+    return wifiIsConnected() && httpOnline;
 }
 
 // =================================================
@@ -61,27 +61,13 @@ void networkSetup(ESP8266WebServer &server) {
 
     Serial.println(F("🌐 NetworkManager iniciando..."));
 
-    wifiOnline = setupWiFi(true);
-
-    if (wifiOnline) {
-        wifiStableSince = millis();
-        Serial.println(F("📡 WiFi online"));
-        
-        // Testa conexão HTTP
-        JsonDocument testDoc;
-        if (httpClient.getActiveFermentation(testDoc)) {
-            httpOnline = true;
-            httpAttemptCount = 0;
-            Serial.println(F("✅ HTTP online"));
-        } else {
-            httpOnline = false;
-            Serial.println(F("⚠️  HTTP offline"));
-        }
-    } else {
-        Serial.println(F("❌ WiFi offline"));
-        httpOnline = false;
-    }
+    // Não espera a conexão: o controle já está rodando e o networkLoop()
+    // testa o HTTP quando o WiFi estabilizar
+    wifiBegin();
+    httpClient.begin();
 
+    wifiOnline = false;
+    httpOnline = false;
     otaOnline = false;
     sensorsScanned = false;
 }
@@ -96,33 +82,36 @@ void networkLoop() {
     // =============================================
     // 1. MONITORAMENTO DO WI-FI
     // =============================================
-    if (now - lastWiFiCheck >= NET_WIFI_CHECK_INTERVAL) {
-        lastWiFiCheck = now;
+    // Máquina de estados não bloqueante: nunca segura o loop()
+    wifiLoop();
 
-        bool wasOnline = wifiOnline;
-        wifiOnline = setupWiFi(false);
+    // Fila HTTP: prazos e entrega das respostas (também sem WiFi, para
+    // que as pendentes falhem em vez de esperar o prazo)
+    httpClient.loop();
 
-        if (!wifiOnline) {
-            if (wasOnline) {
-                Serial.println(F("⚠️ WiFi caiu, desativando serviços"));
-            }
+    bool wasOnline = wifiOnline;
+    wifiOnline = wifiIsConnected();
+
+    if (!wifiOnline) {
+        if (wasOnline) {
+            Serial.println(F("⚠️ WiFi caiu, desativando serviços"));
 
             // Reset estados dependentes do WiFi
             httpOnline = false;
             otaOnline = false;
             sensorsScanned = false;
             httpAttemptCount = 0;
-            return;
         }
+        return;
+    }
 
-        if (!wasOnline && wifiOnline) {
-            wifiStableSince = now;
-            Serial.println(F("📡 WiFi reconectado"));
-            
-            // Reset do estado HTTP quando WiFi reconecta
-            httpOnline = false;
-            httpAttemptCount = 0;
-        }
+    if (!wasOnline) {
+        wifiStableSince = wifiConnectedSince();
+        Serial.println(F("📡 WiFi reconectado"));
+
+        // Reset do estado HTTP quando WiFi reconecta
+        httpOnline = false;
+        httpAttemptCount = 0;
     }
 
     // =============================================
@@ -138,6 +127,7 @@ void networkLoop() {
         }
         
         bool canAttemptConnection = 
+            !httpProbePending &&
             (now - wifiStableSince >= NET_WIFI_STABLE_TIME) &&
             (now - lastHttpAttempt >= minRetryTime);
         
@@ -148,25 +138,25 @@ void networkLoop() {
             
             lastHttpAttempt = now;
             
-            // Testa conexão
-            JsonDocument testDoc;
-            if (httpClient.getActiveFermentation(testDoc)) {
-                httpOnline = true;
-                httpAttemptCount = 0;
-                Serial.println(F("✅ HTTP online"));
-                
-                // Processa scan imediatamente
-                if (!sensorsScanned) {
-                    scanAndSendSensors();
-                    sensorsScanned = true;
+            // Testa conexão; o resultado chega num passe seguinte e o
+            // scan de sensores roda na seção 3
+            httpProbePending = httpClient.getActiveFermentation([](bool ok, JsonDocument&) {
+                httpProbePending = false;
+
+                if (ok && wifiIsConnected()) {
+                    httpOnline = true;
+                    httpAttemptCount = 0;
+                    Serial.println(F("✅ HTTP online"));
+                } else {
+                    httpAttemptCount++;
+                    
+                    if (httpAttemptCount >= MAX_HTTP_ATTEMPTS) {
+                        Serial.println(F("🔄 Máximo de tentativas HTTP atingido, aguardando..."));
+                    }
                 }
-            } else {
-                httpAttemptCount++;
-                
-                if (httpAttemptCount >= MAX_HTTP_ATTEMPTS) {
-                    Serial.println(F("🔄 Máximo de tentativas HTTP atingido, aguardando..."));
-                }
-            }
+            });
+
+            if (!httpProbePending) httpAttemptCount++;
         }
     }
 
@@ -7,7 +7,7 @@
 // =================================================
 
 /**
- * @brief Inicializa o gerenciador de rede
+ * @brief Inicializa o gerenciador de rede (não bloqueia: só dispara o WiFi)
  * @param server Referência ao servidor web para OTA
  */
 void networkSetup(ESP8266WebServer &server);
@@ -24,8 +24,8 @@ void networkLoop();
 // =================================================
 
 /**
- * @brief Verifica se o WiFi está online e estável
- * @return true se WiFi online e com conexão estável
+ * @brief Verifica se o WiFi está conectado agora
+ * @return true se WiFi com IP (estado em tempo real, via eventos)
  */
 bool isWiFiOnline();
 
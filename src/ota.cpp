@@ -2,12 +2,24 @@
 
 #include "ota.h"
 #include "ElegantOTA.h"
+#include "BrewPiTempControl.h"
+#include "BrewPiTrace.h"
+#include "preferences_layout.h"
+#include "ota_health.h"
 
 static bool otaInitialized = false;
 static unsigned long ota_progress_millis = 0;
+static unsigned long otaStartMillis = 0;
+static size_t otaBytes = 0;
 
 bool otaInProgress = false;
 
+static void (*otaTickHook)() = nullptr;
+
+void setOTATickHook(void (*hook)()) {
+    otaTickHook = hook;
+}
+
 void setupOTA(ESP8266WebServer &server) {
     if (otaInitialized) {
         return;
@@ -19,10 +31,19 @@ void setupOTA(ESP8266WebServer &server) {
     // Callback: Início do upload
     ElegantOTA.onStart([]() {
         otaInProgress = true;
+        otaStartMillis = millis();
+        otaBytes = 0;
     });
 
     // Callback: Progresso do upload (opcional - apenas para monitoramento)
     ElegantOTA.onProgress([](size_t current, size_t final) {
+        otaBytes = current;
+
+        // Controle de temperatura intercalado com o upload
+        if (otaTickHook) {
+            otaTickHook();
+        }
+
         // Atualiza a cada 1 segundo
         if (millis() - ota_progress_millis > 1000) {
             ota_progress_millis = millis();
@@ -34,8 +55,27 @@ void setupOTA(ESP8266WebServer &server) {
     // Callback: Finalização
     ElegantOTA.onEnd([](bool success) {
         otaInProgress = false;
+
+        unsigned long elapsed = millis() - otaStartMillis;
+        Serial.printf("[OTA] %s: %u bytes em %lu ms\n",
+                      success ? "✅ Concluído" : "❌ Falhou", (unsigned int)otaBytes, elapsed);
         
         if (success) {
+            // Bytes e tempo do upload sobrevivem ao reboot (GET /version)
+            Preferences prefs;
+            prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+            prefs.putULong(KEY_OTA_BYTES, otaBytes);
+            prefs.putULong(KEY_OTA_MS, elapsed);
+            prefs.end();
+
+            // Imagem nova entra em prova no próximo boot
+            otaHealthMarkPending();
+
+            // Relés em estado seguro antes do reboot: nada fica ligado sem
+            // controle enquanto o firmware novo sobe
+            brewPiControl.shutdownOutputs();
+            brewPiTrace.end();
+
             // Delay para garantir resposta HTTP
             delay(1000);
             ESP.restart();
@@ -58,3 +98,11 @@ bool isOTAInitialized() {
 bool isOTAInProgress() {
     return otaInProgress;
 }
+
+void getLastOTAStats(uint32_t& bytes, uint32_t& ms) {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, true);
+    bytes = prefs.getULong(KEY_OTA_BYTES, 0);
+    ms = prefs.getULong(KEY_OTA_MS, 0);
+    prefs.end();
+}
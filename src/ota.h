@@ -7,3 +7,11 @@ void setupOTA(ESP8266WebServer &server);
 void handleOTA();
 bool isOTAInitialized();
 bool isOTAInProgress();
+
+// Bytes enviados e duração (ms) do último OTA bem-sucedido (0 se nenhum).
+// Com imagem .bin.gz os bytes são os comprimidos.
+void getLastOTAStats(uint32_t& bytes, uint32_t& ms);
+
+// Chamado a cada bloco recebido durante o upload: o upload prende o
+// handleClient() até terminar, então é por aqui que o controle continua
+void setOTATickHook(void (*hook)());
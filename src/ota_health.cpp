@@ -0,0 +1,293 @@
+// ota_health.cpp - Período de prova após OTA e rollback para a imagem anterior
+#include "ota_health.h"
+#include <LittleFS.h>
+#include <Updater.h>
+#include <Preferences.h>
+#include "preferences_layout.h"
+#include "http_client.h"
+#include "BrewPiTempControl.h"
+#include "BrewPiTrace.h"
+#include "debug_config.h"
+
+// ========================================
+// ESTADO
+// ========================================
+
+static OtaHealthState healthState = OTA_HEALTH_OK;
+static bool healthy = false;             // critérios atingidos neste boot
+static unsigned long probationStart = 0;
+static uint32_t ticksOk = 0;
+static uint32_t serverBase = 0;
+static uint32_t httpBase = 0;
+static uint8_t probationBoots = 0;
+static bool probationExtended = false;   // prazo vencido sem servidor
+static String backupMd5;
+
+// Cópia da imagem atual para o LittleFS, em blocos
+static bool backupRunning = false;
+static bool backupDone = false;
+static File backupFile;
+static uint32_t backupOffset = 0;
+static uint32_t backupSize = 0;
+
+static uint32_t serverOk() {
+    return httpClient.getActiveOkCount() - serverBase;
+}
+
+// Respostas do servidor a qualquer requisição (lote, comandos, esp/active)
+static uint32_t httpOk() {
+    return asyncHttp.getCompleted() - httpBase;
+}
+
+static void saveResult(bool probation, uint8_t boots, OtaHealthState result) {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    prefs.putBool(KEY_OTA_PROBE, probation);
+    prefs.putUChar(KEY_OTA_BOOTS, boots);
+    prefs.putUChar(KEY_OTA_HEALTH, (uint8_t)result);
+    prefs.end();
+}
+
+// ========================================
+// ROLLBACK
+// ========================================
+
+// Grava a imagem do LittleFS pelo Updater e reinicia. Só retorna em falha.
+static bool rollback() {
+    if (backupMd5.length() == 0 || backupMd5 == ESP.getSketchMD5()) {
+        return false;
+    }
+
+    File f = LittleFS.open(OTA_BACKUP_PATH, "r");
+    if (!f) return false;
+
+    Serial.println(F("[OTA] ⏪ Rollback para a imagem anterior..."));
+
+    brewPiControl.shutdownOutputs();
+    brewPiTrace.end();
+
+    if (!Update.begin(f.size(), U_FLASH)) {
+        f.close();
+        return false;
+    }
+    Update.setMD5(backupMd5.c_str());
+
+    uint8_t buf[OTA_BACKUP_BLOCK];
+    while (f.available()) {
+        size_t n = f.read(buf, sizeof(buf));
+        if (Update.write(buf, n) != n) break;
+        yield();
+    }
+    f.close();
+
+    // end() confere o md5 e agenda a instalação no bootloader
+    if (!Update.end()) {
+        Serial.printf("[OTA] ❌ Rollback falhou: %s\n", Update.getErrorString().c_str());
+        return false;
+    }
+
+    saveResult(false, 0, OTA_HEALTH_ROLLED_BACK);
+    delay(500);
+    ESP.restart();
+    return true;
+}
+
+static void failProbation(const char* reason) {
+    Serial.printf("[OTA] ❌ Imagem nova reprovada: %s\n", reason);
+
+    if (!rollback()) {
+        Serial.println(F("[OTA] ⚠️ Sem imagem anterior válida, mantendo a atual"));
+        healthState = OTA_HEALTH_NO_BACKUP;
+        saveResult(false, 0, OTA_HEALTH_NO_BACKUP);
+    }
+}
+
+// ========================================
+// CÓPIA DA IMAGEM CONFIRMADA
+// ========================================
+
+static void backupStart() {
+    // A cópia antiga é de outra imagem: a atual acabou de se confirmar
+    LittleFS.remove(OTA_BACKUP_TMP_PATH);
+    LittleFS.remove(OTA_BACKUP_PATH);
+
+    backupSize = ESP.getSketchSize();
+
+    FSInfo info;
+    LittleFS.info(info);
+    if (info.totalBytes - info.usedBytes < backupSize + OTA_BACKUP_MARGIN) {
+        #if DEBUG_MAIN
+        Serial.println(F("[OTA] ⚠️ LittleFS sem espaço para a cópia da imagem"));
+        #endif
+        backupDone = true;
+        return;
+    }
+
+    backupFile = LittleFS.open(OTA_BACKUP_TMP_PATH, "w");
+    if (!backupFile) {
+        backupDone = true;
+        return;
+    }
+
+    backupOffset = 0;
+    backupRunning = true;
+}
+
+static void backupStep() {
+    static uint32_t block[OTA_BACKUP_BLOCK / 4];
+
+    for (uint8_t i = 0; i < OTA_BACKUP_BLOCKS_PER_RUN && backupOffset < backupSize; i++) {
+        uint32_t len = backupSize - backupOffset;
+        if (len > OTA_BACKUP_BLOCK) len = OTA_BACKUP_BLOCK;
+
+        // A imagem em execução começa no endereço 0 da flash; a leitura é
+        // em palavras de 4 bytes, a escrita só até o fim do sketch
+        if (!ESP.flashRead(backupOffset, block, (len + 3) & ~3UL) ||
+            backupFile.write((const uint8_t*)block, len) != len) {
+            backupFile.close();
+            LittleFS.remove(OTA_BACKUP_TMP_PATH);
+            backupRunning = false;
+            backupDone = true;
+            Serial.println(F("[OTA] ❌ Falha ao copiar a imagem"));
+            return;
+        }
+        backupOffset += len;
+    }
+
+    if (backupOffset < backupSize) return;
+
+    backupFile.close();
+    backupRunning = false;
+    backupDone = true;
+
+    LittleFS.rename(OTA_BACKUP_TMP_PATH, OTA_BACKUP_PATH);
+
+    backupMd5 = ESP.getSketchMD5();
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    prefs.putString(KEY_OTA_BAK_MD5, backupMd5);
+    prefs.end();
+
+    Serial.printf("[OTA] 💾 Imagem atual copiada para rollback (%lu bytes)\n",
+                  (unsigned long)ESP.getSketchSize());
+}
+
+// ========================================
+// API
+// ========================================
+
+void otaHealthBegin() {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, true);
+    bool probation = prefs.getBool(KEY_OTA_PROBE, false);
+    probationBoots = prefs.getUChar(KEY_OTA_BOOTS, 0);
+    healthState = (OtaHealthState)prefs.getUChar(KEY_OTA_HEALTH, OTA_HEALTH_OK);
+    backupMd5 = prefs.getString(KEY_OTA_BAK_MD5, "");
+    prefs.end();
+
+    // Cópia órfã (reboot no meio) ou de imagem que não existe mais
+    if (!LittleFS.exists(OTA_BACKUP_PATH)) {
+        backupMd5 = "";
+    }
+    LittleFS.remove(OTA_BACKUP_TMP_PATH);
+
+    serverBase = httpClient.getActiveOkCount();
+    httpBase = asyncHttp.getCompleted();
+
+    if (!probation) return;
+
+    probationBoots++;
+    saveResult(true, probationBoots, OTA_HEALTH_PROBATION);
+
+    if (probationBoots > OTA_PROBATION_MAX_BOOTS) {
+        failProbation("reinícios seguidos durante a prova");
+        return;
+    }
+
+    healthState = OTA_HEALTH_PROBATION;
+    probationStart = millis();
+
+    Serial.printf("[OTA] 🧪 Imagem nova em prova (boot %u de %u)\n",
+                  probationBoots, OTA_PROBATION_MAX_BOOTS);
+}
+
+void otaHealthMarkPending() {
+    saveResult(true, 0, OTA_HEALTH_PROBATION);
+}
+
+void otaHealthRecordTick(bool sensorsOk) {
+    if (sensorsOk) ticksOk++;
+}
+
+void otaHealthLoop() {
+    if (!healthy && ticksOk >= OTA_PROBATION_MIN_TICKS && serverOk() >= OTA_PROBATION_MIN_SERVER) {
+        healthy = true;
+
+        if (healthState == OTA_HEALTH_PROBATION) {
+            healthState = OTA_HEALTH_CONFIRMED;
+            saveResult(false, 0, OTA_HEALTH_CONFIRMED);
+            Serial.println(F("[OTA] ✅ Imagem nova confirmada"));
+        }
+    }
+
+    if (healthState == OTA_HEALTH_PROBATION && millis() - probationStart >= OTA_PROBATION_MS) {
+        if (ticksOk < OTA_PROBATION_MIN_TICKS) {
+            failProbation("controle sem leituras válidas");
+            return;
+        }
+
+        // O servidor responde, mas esp/active não passa: a imagem é que falha
+        if (httpOk() >= OTA_PROBATION_MIN_HTTP) {
+            failProbation("esp/active sem resposta válida");
+            return;
+        }
+
+        // Sem rede não há o que provar: a imagem sobreviveu à janela, então
+        // os reinícios voltam a zero (só crash loop conta) e a prova segue
+        if (!probationExtended) {
+            probationExtended = true;
+            probationBoots = 0;
+            saveResult(true, 0, OTA_HEALTH_PROBATION);
+            Serial.println(F("[OTA] ⏳ Servidor inalcançável: prova estendida até ele responder"));
+        }
+    }
+
+    // Imagem saudável que ainda não é a cópia de rollback
+    if (healthy && !backupDone) {
+        if (backupMd5 == ESP.getSketchMD5()) {
+            backupDone = true;
+        } else if (!backupRunning) {
+            backupStart();
+        } else {
+            backupStep();
+        }
+    }
+}
+
+OtaHealthState otaHealthState() {
+    return healthState;
+}
+
+const char* otaHealthStateName() {
+    switch (healthState) {
+        case OTA_HEALTH_PROBATION:   return "probation";
+        case OTA_HEALTH_CONFIRMED:   return "confirmed";
+        case OTA_HEALTH_ROLLED_BACK: return "rolled_back";
+        case OTA_HEALTH_NO_BACKUP:   return "failed_no_backup";
+        default:                     return "ok";
+    }
+}
+
+void otaHealthToJson(JsonObject obj) {
+    obj["state"] = otaHealthStateName();
+    obj["backup"] = backupMd5.length() > 0;
+
+    if (healthState == OTA_HEALTH_PROBATION) {
+        obj["ticks"] = ticksOk;
+        obj["server"] = serverOk();
+        obj["boots"] = probationBoots;
+        obj["extended"] = probationExtended;
+        obj["remaining_s"] = probationExtended ? 0 :
+                             (OTA_PROBATION_MS - (millis() - probationStart)) / 1000;
+    }
+}
@@ -0,0 +1,60 @@
+// ota_health.h - Período de prova após OTA e rollback para a imagem anterior
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+// O ESP8266 não tem duas partições de aplicação: a última imagem que passou
+// pela prova fica copiada no LittleFS e o rollback a grava de volta pelo
+// Updater (o bootloader instala no próximo boot).
+//
+// Reprovam a imagem: reinícios seguidos na prova, controle sem leituras
+// válidas ou servidor alcançável (outras respostas HTTP chegam) sem
+// esp/active válido. Sem WiFi ou sem servidor, a prova só se estende: o
+// controle já provou a imagem e a confirmação espera o servidor voltar.
+
+#define OTA_PROBATION_MS          600000UL   // 10 min para a imagem nova se confirmar
+#define OTA_PROBATION_MIN_TICKS   24         // ticks do controle com sensores lidos (~2 min)
+#define OTA_PROBATION_MIN_SERVER  2          // respostas válidas de esp/active
+#define OTA_PROBATION_MIN_HTTP    10         // respostas HTTP que provam o servidor alcançável
+#define OTA_PROBATION_MAX_BOOTS   3          // reboots durante a prova = imagem quebrada
+
+#define OTA_BACKUP_PATH           "/fw_good.bin"
+#define OTA_BACKUP_TMP_PATH       "/fw_good.tmp"
+#define OTA_BACKUP_BLOCK          1024       // bytes lidos da flash por vez
+#define OTA_BACKUP_BLOCKS_PER_RUN 4          // ~400KB em ~50s com a tarefa a cada 500ms
+#define OTA_BACKUP_MARGIN         16384UL    // folga no LittleFS além da imagem
+
+enum OtaHealthState : uint8_t {
+    OTA_HEALTH_OK = 0,          // sem atualização pendente
+    OTA_HEALTH_PROBATION,       // imagem nova em prova
+    OTA_HEALTH_CONFIRMED,       // última atualização se confirmou
+    OTA_HEALTH_ROLLED_BACK,     // última atualização falhou e voltou à anterior
+    OTA_HEALTH_NO_BACKUP        // falhou, mas não havia imagem para voltar
+};
+
+// ========================================
+// API
+// ========================================
+
+// Boot (após montar o LittleFS): conta reboots da prova e, em crash loop,
+// faz o rollback antes de qualquer outra coisa
+void otaHealthBegin();
+
+// OTA concluído: a próxima imagem começa em prova
+void otaHealthMarkPending();
+
+// Um tick do controle rodou; sensorsOk = leitura válida dos sensores
+void otaHealthRecordTick(bool sensorsOk);
+
+// Avalia a prova e copia a imagem confirmada (tarefa do escalonador)
+void otaHealthLoop();
+
+OtaHealthState otaHealthState();
+const char* otaHealthStateName();
+
+// Resumo para o heartbeat
+void otaHealthToJson(JsonObject obj);
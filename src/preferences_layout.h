@@ -10,6 +10,7 @@
 // ===============================================
 #define PREFS_NAMESPACE_SENSORS "sensors"   // Para sensores
 #define PREFS_NAMESPACE_FERMENT "ferment"   // Para fermentação
+#define PREFS_NAMESPACE_SYSTEM  "system"    // Do aparelho; nunca limpo por clearPreferences()
 
 // ===============================================
 // CHAVES DO NAMESPACE "sensors" (máx 15 chars)
@@ -26,8 +27,22 @@
 #define KEY_STAGE_STARTED "stageStrtd"   // Flag etapa iniciada
 #define KEY_CFG_SAVED "cfgSaved"         // Flag config válida
 #define KEY_TARGET_REACH "tgtReached"    // Flag temperatura atingida
-#define KEY_LAST_EPOCH "lastEpoch"       // Backup NTP epoch
-#define KEY_LAST_MILLIS "lastMillis"     // Backup NTP millis
+#define KEY_TRACE_ON "traceOn"           // Gravação de trace do controle ativa
+
+// ===============================================
+// CHAVES DO NAMESPACE "system" (máx 15 chars)
+// ===============================================
+#define KEY_LAST_EPOCH "lastEpoch"       // Backup do epoch disciplinado (u64)
+#define KEY_CLOCK_DRIFT "clkDrift"       // Deriva do cristal em ppm (float)
+#define KEY_OTA_BYTES "otaBytes"         // Bytes do último OTA
+#define KEY_OTA_MS "otaMs"               // Duração do último OTA (ms)
+#define KEY_OTA_PROBE "otaProbe"         // Imagem atual em período de prova
+#define KEY_OTA_BOOTS "otaBoots"         // Reinícios durante a prova
+#define KEY_OTA_HEALTH "otaHealth"       // Resultado da última atualização
+#define KEY_OTA_BAK_MD5 "otaBakMd5"      // md5 da imagem copiada para rollback
+#define KEY_WIFI_CACHE "wifiCache"       // Último AP bom: BSSID, canal e IP (bytes)
+#define KEY_TLM_SEQ "tlmSeq"             // Fim do bloco de sequências da fila offline
+#define KEY_TLM_EPOCH "tlmEpoch"         // Época das sequências (aleatória, por instalação)
 
 // ===============================================
 // FUNÇÕES DE DIAGNÓSTICO
@@ -49,8 +64,20 @@ inline void printPreferencesLayout() {
     Serial.printf( "║ - stageStrtd:   Flag iniciada             ║\n");
     Serial.printf( "║ - cfgSaved:     Flag válida               ║\n");
     Serial.printf( "║ - tgtReached:   Flag temp atingida        ║\n");
+    Serial.printf( "║ - traceOn:      Trace do controle         ║\n");
+    Serial.println(F("╠══════════════════════════════════════════╣"));
+    Serial.println(F("║ NAMESPACE: system                         ║"));
     Serial.printf( "║ - lastEpoch:    Backup NTP                ║\n");
-    Serial.printf( "║ - lastMillis:   Backup millis             ║\n");
+    Serial.printf( "║ - clkDrift:     Deriva do cristal (ppm)   ║\n");
+    Serial.printf( "║ - otaBytes:     Bytes do último OTA       ║\n");
+    Serial.printf( "║ - otaMs:        Duração do último OTA     ║\n");
+    Serial.printf( "║ - otaProbe:     OTA em prova              ║\n");
+    Serial.printf( "║ - otaBoots:     Reinícios na prova        ║\n");
+    Serial.printf( "║ - otaHealth:    Resultado do último OTA   ║\n");
+    Serial.printf( "║ - otaBakMd5:    md5 da imagem de rollback ║\n");
+    Serial.printf( "║ - wifiCache:    Último AP bom (rápido)    ║\n");
+    Serial.printf( "║ - tlmSeq:       Sequência da fila offline ║\n");
+    Serial.printf( "║ - tlmEpoch:     Época das sequências      ║\n");
     Serial.println(F("╚═══════════════════════════════════════════╝\n"));
     #endif
 }
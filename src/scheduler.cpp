@@ -0,0 +1,234 @@
+// scheduler.cpp - Implementação do escalonador cooperativo
+#include "scheduler.h"
+#include "debug_config.h"
+#include "console.h"
+
+// Definição da instância global
+Scheduler scheduler;
+
+Scheduler::Scheduler()
+    : taskCount(0)
+    , currentTick(0)
+    , lastMillis(0)
+    , totalOverruns(0)
+{
+    for (uint8_t i = 0; i < SCHED_WHEEL_SLOTS; i++) {
+        wheel[i] = SCHED_INVALID_TASK;
+    }
+}
+
+// ========================================
+// REGISTRO
+// ========================================
+
+uint32_t Scheduler::periodTicks(uint32_t periodMs) const {
+    uint32_t t = (periodMs + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+    return (t == 0) ? 1 : t;
+}
+
+SchedulerTaskId Scheduler::add(const char* name, SchedulerCallback callback,
+                               uint32_t periodMs, uint8_t priority, uint16_t budgetMs,
+                               uint32_t firstDelayMs) {
+    if (taskCount >= SCHED_MAX_TASKS || !callback) {
+        #if DEBUG_SCHEDULER
+        Serial.printf("[Sched] ❌ Tarefa '%s' não registrada\n", name);
+        #endif
+        return SCHED_INVALID_TASK;
+    }
+
+    if (taskCount == 0) {
+        lastMillis = millis();
+    }
+
+    SchedulerTaskId id = taskCount++;
+    SchedulerTask& t = tasks[id];
+    memset(&t, 0, sizeof(t));
+    t.name = name;
+    t.callback = callback;
+    t.periodMs = periodMs;
+    t.budgetMs = budgetMs;
+    t.priority = priority;
+    t.enabled = true;
+    t.dueTick = currentTick + periodTicks(firstDelayMs);
+    t.next = SCHED_INVALID_TASK;
+
+    link(id);
+    return id;
+}
+
+void Scheduler::link(SchedulerTaskId id) {
+    uint8_t slot = tasks[id].dueTick % SCHED_WHEEL_SLOTS;
+    tasks[id].next = wheel[slot];
+    wheel[slot] = id;
+}
+
+void Scheduler::unlink(SchedulerTaskId id) {
+    uint8_t slot = tasks[id].dueTick % SCHED_WHEEL_SLOTS;
+    int8_t* p = &wheel[slot];
+    while (*p != SCHED_INVALID_TASK) {
+        if (*p == id) {
+            *p = tasks[id].next;
+            tasks[id].next = SCHED_INVALID_TASK;
+            return;
+        }
+        p = &tasks[*p].next;
+    }
+}
+
+void Scheduler::setPeriod(SchedulerTaskId id, uint32_t periodMs) {
+    if (id < 0 || id >= taskCount || tasks[id].periodMs == periodMs) return;
+
+    tasks[id].periodMs = periodMs;
+
+    // Na fila do passe: execute() já reagenda com o novo período
+    if (tasks[id].pending) return;
+
+    // Reagenda a partir de agora para o novo período valer já
+    unlink(id);
+    tasks[id].dueTick = currentTick + periodTicks(periodMs);
+    link(id);
+}
+
+void Scheduler::setEnabled(SchedulerTaskId id, bool enabled) {
+    if (id < 0 || id >= taskCount) return;
+    tasks[id].enabled = enabled;
+}
+
+void Scheduler::triggerNow(SchedulerTaskId id) {
+    if (id < 0 || id >= taskCount || tasks[id].pending) return;
+
+    unlink(id);
+    tasks[id].dueTick = currentTick + 1;
+    link(id);
+}
+
+const SchedulerTask* Scheduler::getTask(SchedulerTaskId id) const {
+    if (id < 0 || id >= taskCount) return nullptr;
+    return &tasks[id];
+}
+
+// ========================================
+// EXECUÇÃO
+// ========================================
+
+void Scheduler::advance(uint32_t ticks, SchedulerTaskId* ready, uint8_t& readyCount) {
+    // Mais de uma volta: basta visitar cada slot uma vez
+    uint32_t visits = (ticks > SCHED_WHEEL_SLOTS) ? SCHED_WHEEL_SLOTS : ticks;
+    currentTick += ticks;
+
+    for (uint32_t v = 0; v < visits; v++) {
+        uint8_t slot = (currentTick - v) % SCHED_WHEEL_SLOTS;
+        int8_t* p = &wheel[slot];
+
+        while (*p != SCHED_INVALID_TASK) {
+            SchedulerTaskId id = *p;
+            SchedulerTask& t = tasks[id];
+
+            if ((int32_t)(t.dueTick - currentTick) <= 0) {
+                // Vencida: sai da roda e entra na fila do passe
+                *p = t.next;
+                t.next = SCHED_INVALID_TASK;
+                t.pending = true;
+                ready[readyCount++] = id;
+            } else {
+                p = &t.next;
+            }
+        }
+    }
+}
+
+void Scheduler::execute(SchedulerTaskId id) {
+    SchedulerTask& t = tasks[id];
+
+    uint32_t late = (currentTick - t.dueTick) * SCHED_TICK_MS;
+    if (late > t.maxLateMs) t.maxLateMs = late;
+
+    // Próximo vencimento alinhado ao período; se atrasou mais de um
+    // período, não tenta recuperar as execuções perdidas
+    uint32_t period = periodTicks(t.periodMs);
+    t.dueTick += period;
+    if ((int32_t)(t.dueTick - currentTick) <= 0) {
+        t.dueTick = currentTick + period;
+    }
+    t.pending = false;
+    link(id);
+
+    if (!t.enabled) return;
+
+    uint32_t start = millis();
+    t.callback();
+    uint32_t elapsed = millis() - start;
+
+    t.runs++;
+    t.lastRunMs = elapsed;
+    if (elapsed > t.maxRunMs) t.maxRunMs = elapsed;
+
+    if (t.budgetMs > 0 && elapsed > t.budgetMs) {
+        t.overruns++;
+        totalOverruns++;
+
+        #if DEBUG_SCHEDULER
+        Serial.printf("[Sched] ⚠️  '%s' estourou orçamento: %lums (limite %ums)\n",
+                      t.name, (unsigned long)elapsed, t.budgetMs);
+        #endif
+    }
+}
+
+void Scheduler::run() {
+    uint32_t now = millis();
+    uint32_t elapsed = now - lastMillis;
+    if (elapsed < SCHED_TICK_MS) return;
+
+    uint32_t ticks = elapsed / SCHED_TICK_MS;
+    lastMillis += ticks * SCHED_TICK_MS;
+
+    SchedulerTaskId ready[SCHED_MAX_TASKS];
+    uint8_t readyCount = 0;
+    advance(ticks, ready, readyCount);
+
+    // Ordena por prioridade (inserção; poucas tarefas)
+    for (uint8_t i = 1; i < readyCount; i++) {
+        SchedulerTaskId id = ready[i];
+        int8_t j = i - 1;
+        while (j >= 0 && tasks[ready[j]].priority > tasks[id].priority) {
+            ready[j + 1] = ready[j];
+            j--;
+        }
+        ready[j + 1] = id;
+    }
+
+    for (uint8_t i = 0; i < readyCount; i++) {
+        execute(ready[i]);
+        yield();
+    }
+}
+
+// ========================================
+// DIAGNÓSTICO
+// ========================================
+
+void Scheduler::printStats() {
+    char buffer[96];
+
+    consolePrint("\n━━━━━━━━━━━━━━━━ TAREFAS ━━━━━━━━━━━━━━━━");
+    consolePrint("tarefa          período(ms) pri  exec  estouro  máx(ms) atraso(ms)");
+
+    for (uint8_t i = 0; i < taskCount; i++) {
+        const SchedulerTask& t = tasks[i];
+        snprintf(buffer, sizeof(buffer), "%-15s %11lu %3u %5lu  %7lu  %7lu  %7lu%s",
+                 t.name,
+                 (unsigned long)t.periodMs,
+                 t.priority,
+                 (unsigned long)t.runs,
+                 (unsigned long)t.overruns,
+                 (unsigned long)t.maxRunMs,
+                 (unsigned long)t.maxLateMs,
+                 t.enabled ? "" : "  (desativada)");
+        consolePrint(buffer);
+    }
+
+    snprintf(buffer, sizeof(buffer), "Estouros totais: %lu",
+             (unsigned long)totalOverruns);
+    consolePrint(buffer);
+    consolePrint("━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━━\n");
+}
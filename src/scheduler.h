@@ -0,0 +1,91 @@
+// scheduler.h - Escalonador cooperativo com roda de temporização (timer wheel)
+#pragma once
+
+#include <Arduino.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+// Roda hasheada: cada tarefa fica no slot (vencimento % SCHED_WHEEL_SLOTS).
+// Um passe do loop só visita os slots dos ticks que passaram desde o último
+// passe; se nenhum tick passou, run() retorna sem tocar em nenhuma tarefa.
+
+#define SCHED_TICK_MS        100   // resolução da roda
+#define SCHED_WHEEL_SLOTS    32    // 3,2s por volta
+#define SCHED_MAX_TASKS      16
+#define SCHED_INVALID_TASK   (-1)
+
+// Prioridades (menor = roda primeiro quando várias vencem no mesmo passe)
+#define SCHED_PRIO_CONTROL   0
+#define SCHED_PRIO_HIGH      1
+#define SCHED_PRIO_NORMAL    2
+#define SCHED_PRIO_LOW       3
+
+typedef void (*SchedulerCallback)();
+typedef int8_t SchedulerTaskId;
+
+struct SchedulerTask {
+    const char* name;
+    SchedulerCallback callback;
+    uint32_t periodMs;
+    uint16_t budgetMs;          // tempo máximo esperado por execução
+    uint8_t priority;
+    bool enabled;
+    bool pending;               // fora da roda, na fila do passe atual
+
+    // Roda
+    uint32_t dueTick;
+    int8_t next;                // próxima tarefa no mesmo slot (-1 = fim)
+
+    // Métricas
+    uint32_t runs;
+    uint32_t overruns;          // execuções acima de budgetMs
+    uint32_t lastRunMs;
+    uint32_t maxRunMs;
+    uint32_t maxLateMs;         // maior atraso entre vencimento e execução
+};
+
+// ========================================
+// CLASSE DO ESCALONADOR
+// ========================================
+
+class Scheduler {
+public:
+    Scheduler();
+
+    // Registra tarefa periódica; primeira execução após firstDelayMs
+    SchedulerTaskId add(const char* name, SchedulerCallback callback,
+                        uint32_t periodMs, uint8_t priority, uint16_t budgetMs,
+                        uint32_t firstDelayMs = 0);
+
+    // Chamar a cada passe do loop(): executa só as tarefas vencidas
+    void run();
+
+    void setPeriod(SchedulerTaskId id, uint32_t periodMs);
+    void setEnabled(SchedulerTaskId id, bool enabled);
+    void triggerNow(SchedulerTaskId id);   // executa no próximo passe
+
+    uint8_t getTaskCount() const { return taskCount; }
+    const SchedulerTask* getTask(SchedulerTaskId id) const;
+    uint32_t getTotalOverruns() const { return totalOverruns; }
+
+    // Tabela de tarefas e métricas no console (serial e telnet)
+    void printStats();
+
+private:
+    void link(SchedulerTaskId id);
+    void unlink(SchedulerTaskId id);
+    void advance(uint32_t ticks, SchedulerTaskId* ready, uint8_t& readyCount);
+    void execute(SchedulerTaskId id);
+    uint32_t periodTicks(uint32_t periodMs) const;
+
+    SchedulerTask tasks[SCHED_MAX_TASKS];
+    int8_t wheel[SCHED_WHEEL_SLOTS];    // cabeça da lista de cada slot
+    uint8_t taskCount;
+    uint32_t currentTick;
+    uint32_t lastMillis;
+    uint32_t totalOverruns;
+};
+
+// Instância global
+extern Scheduler scheduler;
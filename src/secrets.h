@@ -4,6 +4,19 @@
 #define WIFI_SSID "NET_RINALDI"
 #define WIFI_PASSWORD "2F2D8FE5"
 
+// APs adicionais (opcional): tentados em ordem no caminho completo
+// #define WIFI_SSID2 "OutraRede"
+// #define WIFI_PASSWORD2 "senha"
+// #define WIFI_SSID3 "Repetidor"
+// #define WIFI_PASSWORD3 "senha"
+
+// IP fixo (opcional): sem ele, o IP vem do DHCP (reuso da última concessão
+// no caminho rápido: WIFI_FAST_REUSE_LEASE em wifi_manager.h)
+// #define WIFI_STATIC_IP "192.168.68.108"
+// #define WIFI_STATIC_GATEWAY "192.168.68.1"
+// #define WIFI_STATIC_MASK "255.255.255.0"
+// #define WIFI_STATIC_DNS "192.168.68.1"
+
 // Configurações OTA
 #define OTA_USERNAME "otaFerm"
 #define OTA_PASSWORD "senhaOtaFerm"
\ No newline at end of file
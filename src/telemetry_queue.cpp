@@ -0,0 +1,247 @@
+// telemetry_queue.cpp - Implementação da fila offline de telemetria
+#include "telemetry_queue.h"
+
+#include <LittleFS.h>
+#include <Preferences.h>
+
+#include "preferences_layout.h"
+#include "clock_sync.h"
+#include "network_manager.h"
+#include "http_client.h"
+#include "debug_config.h"
+
+extern FermentadorHTTPClient httpClient;
+
+// Sequências: o Preferences ("system", que o fim de uma fermentação não
+// limpa) guarda o fim do bloco reservado. No boot o bloco seguinte é
+// reservado, então nenhuma sequência se repete mesmo após reset sem aviso
+// (as não usadas do bloco anterior são puladas). Se o contador sumir (flash
+// apagada), uma época nova é sorteada: o servidor usa época + sequência e
+// não confunde a contagem nova com a antiga.
+static uint32_t nextSeq = 0;
+static uint32_t seqLimit = 0;
+static uint32_t seqEpoch = 0;
+
+// Leitura: bytes já confirmados do arquivo mais antigo (.old, ou o atual
+// se não houver .old). Após reboot volta a 0 e o servidor descarta os
+// registros que já tinha.
+static uint32_t drainOffset = 0;
+static uint8_t drainGeneration = 0;   // muda quando o .old é descartado
+static bool drainInFlight = false;
+
+static uint32_t pushedCount = 0;
+static uint32_t sentCount = 0;
+static uint32_t droppedCount = 0;
+
+// ========================================
+// AUXILIARES
+// ========================================
+
+static void reserveSeqBlock() {
+    seqLimit = nextSeq + TLM_SEQ_BLOCK;
+
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    prefs.putULong(KEY_TLM_SEQ, seqLimit);
+    prefs.end();
+}
+
+static const char* oldestPath() {
+    return LittleFS.exists(TLM_QUEUE_OLD_PATH) ? TLM_QUEUE_OLD_PATH : TLM_QUEUE_PATH;
+}
+
+static uint32_t fileSize(const char* path) {
+    File f = LittleFS.open(path, "r");
+    if (!f) return 0;
+    uint32_t size = f.size();
+    f.close();
+    return size;
+}
+
+// Conta as linhas ainda não confirmadas de um arquivo que vai ser descartado
+static uint32_t countLines(const char* path, uint32_t from) {
+    File f = LittleFS.open(path, "r");
+    if (!f) return 0;
+
+    uint32_t lines = 0;
+    uint8_t buf[128];
+    f.seek(from);
+    while (f.available()) {
+        size_t n = f.read(buf, sizeof(buf));
+        for (size_t i = 0; i < n; i++) {
+            if (buf[i] == '\n') lines++;
+        }
+    }
+    f.close();
+    return lines;
+}
+
+// Arquivo atual cheio: vira o .old; o .old anterior (mais velho) é descartado
+static void rotateQueue() {
+    if (LittleFS.exists(TLM_QUEUE_OLD_PATH)) {
+        uint32_t lost = countLines(TLM_QUEUE_OLD_PATH, drainOffset);
+        droppedCount += lost;
+        LittleFS.remove(TLM_QUEUE_OLD_PATH);
+
+        // O offset era do .old descartado; o lote em andamento também
+        drainOffset = 0;
+        drainGeneration++;
+
+        #if DEBUG_HTTP
+        Serial.printf("[Fila] ⚠️  Fila cheia: %lu registros antigos descartados\n",
+                      (unsigned long)lost);
+        #endif
+    }
+    // Sem .old, o atual era o mais antigo e o offset continua valendo
+    LittleFS.rename(TLM_QUEUE_PATH, TLM_QUEUE_OLD_PATH);
+}
+
+// ========================================
+// API
+// ========================================
+
+void telemetryQueueBegin() {
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+    nextSeq = prefs.getULong(KEY_TLM_SEQ, 1);
+    seqEpoch = prefs.getULong(KEY_TLM_EPOCH, 0);
+    if (seqEpoch == 0) {
+        // Contador novo: época nova (0 = sem época)
+        do { seqEpoch = ESP.random(); } while (seqEpoch == 0);
+        prefs.putULong(KEY_TLM_EPOCH, seqEpoch);
+        nextSeq = 1;
+    }
+    prefs.end();
+
+    reserveSeqBlock();
+
+    #if DEBUG_HTTP
+    uint32_t pending = telemetryQueueBytes();
+    if (pending > 0) {
+        Serial.printf("[Fila] 📦 %lu bytes pendentes da fila offline (seq %lu)\n",
+                      (unsigned long)pending, (unsigned long)nextSeq);
+    }
+    #endif
+}
+
+uint32_t telemetryQueueEpoch() {
+    return seqEpoch;
+}
+
+uint32_t telemetryQueueNextSeq() {
+    if (nextSeq >= seqLimit) reserveSeqBlock();
+    return nextSeq++;
+}
+
+bool telemetryQueuePush(const char* section, const JsonDocument& record) {
+    if (fileSize(TLM_QUEUE_PATH) >= TLM_QUEUE_FILE_MAX) rotateQueue();
+
+    File f = LittleFS.open(TLM_QUEUE_PATH, "a");
+    if (!f) {
+        #if DEBUG_HTTP
+        Serial.println(F("[Fila] ❌ Falha ao abrir a fila offline"));
+        #endif
+        return false;
+    }
+
+    JsonDocument line;
+    line["k"] = section;
+    line["q"] = record["seq"].isNull() ? telemetryQueueNextSeq() : record["seq"].as<uint32_t>();
+    time_t now = clockNow();
+    if (now > CLOCK_VALID_EPOCH) line["dt"] = (uint32_t)now;
+    line["r"] = record;
+
+    size_t len = measureJson(line);
+    size_t written = serializeJson(line, f);
+    written += f.write('\n');
+    f.close();
+
+    if (written != len + 1) {
+        // Flash cheia: a linha truncada será pulada no envio
+        #if DEBUG_HTTP
+        Serial.println(F("[Fila] ❌ Falha de escrita na fila offline"));
+        #endif
+        return false;
+    }
+
+    pushedCount++;
+    return true;
+}
+
+void telemetryQueueLoop() {
+    if (drainInFlight || !canUseHTTP()) return;
+
+    const char* path = oldestPath();
+    File f = LittleFS.open(path, "r");
+    if (!f) return;   // fila vazia
+
+    if (drainOffset >= f.size()) {
+        // Arquivo todo confirmado: o próximo passe segue no outro
+        f.close();
+        LittleFS.remove(path);
+        drainOffset = 0;
+        return;
+    }
+
+    JsonDocument batch;
+    batch["seq"] = seqEpoch;
+
+    uint8_t records = 0;
+    uint32_t end = drainOffset;
+    f.seek(drainOffset);
+
+    while (records < TLM_DRAIN_MAX_RECORDS && f.available() &&
+           end - drainOffset < TLM_DRAIN_MAX_BYTES) {
+        String text = f.readStringUntil('\n');
+        end = f.position();
+
+        JsonDocument line;
+        if (deserializeJson(line, text)) continue;   // linha truncada
+
+        const char* section = line["k"] | "";
+        if (!*section || line["q"].isNull()) continue;
+
+        JsonObject rec = batch[section].add<JsonObject>();
+        rec.set(line["r"].as<JsonObjectConst>());
+        rec["seq"] = line["q"];
+        if (!line["dt"].isNull()) rec["dt"] = line["dt"];
+        records++;
+    }
+    f.close();
+
+    if (records == 0) {
+        drainOffset = end;
+        return;
+    }
+
+    uint8_t generation = drainGeneration;
+    drainInFlight = true;
+
+    bool queued = httpClient.sendQueuedBatch(batch, [generation, end, records](bool ok) {
+        drainInFlight = false;
+        if (!ok || generation != drainGeneration) return;   // reenvia no próximo passe
+        drainOffset = end;
+        sentCount += records;
+    });
+
+    if (!queued) drainInFlight = false;
+
+    #if DEBUG_HTTP
+    if (queued) {
+        Serial.printf("[Fila] 📤 Reenviando %u registros da fila offline\n", records);
+    }
+    #endif
+}
+
+bool telemetryQueueEmpty() {
+    return telemetryQueueBytes() == 0;
+}
+
+uint32_t telemetryQueueBytes() {
+    uint32_t total = fileSize(TLM_QUEUE_OLD_PATH) + fileSize(TLM_QUEUE_PATH);
+    return total > drainOffset ? total - drainOffset : 0;
+}
+
+uint32_t telemetryQueuePushed() { return pushedCount; }
+uint32_t telemetryQueueSent() { return sentCount; }
+uint32_t telemetryQueueDropped() { return droppedCount; }
@@ -0,0 +1,60 @@
+// telemetry_queue.h - Fila offline de telemetria no LittleFS (store-and-forward)
+#pragma once
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ========================================
+// PARÂMETROS
+// ========================================
+// Sem link com o servidor, leituras, transições de estado e amostras do
+// iSpindel vão para um arquivo só de acréscimo, uma linha JSON por registro:
+//
+//   {"k":"readings","q":1234,"dt":1769500800,"r":{...registro...}}
+//
+// "q" é o número de sequência (único entre reboots, dentro da época da
+// instalação) e "dt" o epoch em que o registro foi gerado. Com o link de
+// volta, a fila é enviada aos poucos em lotes para esp/batch; o servidor
+// descarta época + "q" repetidos, então reenviar
+// depois de uma queda ou reboot nunca duplica linhas. Leituras e iSpindel
+// enviados ao vivo também levam sequência: se o lote falhar, voltam para
+// a fila com o mesmo número.
+//
+// Limite: ao passar de TLM_QUEUE_FILE_MAX, o arquivo atual vira o antigo e o
+// antigo anterior (os registros mais velhos) é descartado. Linha truncada por
+// falta de energia não passa no parse e é pulada.
+
+#define TLM_QUEUE_PATH          "/tlm_queue.log"
+#define TLM_QUEUE_OLD_PATH      "/tlm_queue.old"
+#define TLM_QUEUE_FILE_MAX      24576UL   // 24KB por arquivo (~48KB no total)
+#define TLM_SEQ_BLOCK           256       // sequências reservadas por gravação no Preferences
+
+#define TLM_DRAIN_MAX_RECORDS   10        // registros por lote
+#define TLM_DRAIN_MAX_BYTES     2048      // bytes de linhas lidas por lote
+
+// ========================================
+// API
+// ========================================
+
+// Boot (após montar o LittleFS): reserva o bloco de sequências
+void telemetryQueueBegin();
+
+// Grava um registro na fila; section é a seção do esp/batch. Mantém o
+// "seq" do registro, se houver
+bool telemetryQueuePush(const char* section, const JsonDocument& record);
+
+// Próximo número de sequência (registros enviados ao vivo)
+uint32_t telemetryQueueNextSeq();
+
+// Época das sequências: vai no "seq" do lote; o servidor deduplica por
+// época + sequência
+uint32_t telemetryQueueEpoch();
+
+// Envia o próximo lote se houver link (tarefa do escalonador)
+void telemetryQueueLoop();
+
+bool telemetryQueueEmpty();
+uint32_t telemetryQueueBytes();     // bytes ainda não confirmados
+uint32_t telemetryQueuePushed();    // registros gravados desde o boot
+uint32_t telemetryQueueSent();      // registros confirmados pelo servidor
+uint32_t telemetryQueueDropped();   // registros descartados por falta de espaço
@@ -43,6 +43,11 @@ bool isTelnetConnected() {
     return telnetClient && telnetClient.connected();
 }
 
+int telnetRead() {
+    if (!telnetClient || !telnetClient.available()) return -1;
+    return telnetClient.read();
+}
+
 #else
 
 // ========================
@@ -53,5 +58,6 @@ void telnetSetup() {}
 void telnetLoop() {}
 void telnetLog(const String &msg) { (void)msg; }
 bool isTelnetConnected() { return false; }
+int telnetRead() { return -1; }
 
 #endif
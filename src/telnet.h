@@ -7,6 +7,9 @@ void telnetLoop();
 void telnetLog(const String &msg);
 bool isTelnetConnected();
 
+// Próximo byte digitado no cliente (-1 = nada disponível)
+int telnetRead();
+
 // telnet.h - para debug sem precisar conectar esp via usb
 // para acessar:
 // Windows + R
@@ -1,38 +1,367 @@
 //wifi_manager.cpp - Gerenciamento de conexão WiFi
 #include "wifi_manager.h"
 #include "secrets.h"
+#include "debug_config.h"
+#include "preferences_layout.h"
+#include <coredecls.h>   // crc32()
 
-bool setupWiFi(bool verbose) {
-    if (WiFi.status() == WL_CONNECTED) {
-        return true;
+// =================================================
+// APS CONFIGURADOS
+// =================================================
+
+struct WifiAp {
+    const char* ssid;
+    const char* password;
+};
+
+static const WifiAp WIFI_APS[] = {
+    { WIFI_SSID, WIFI_PASSWORD },
+#ifdef WIFI_SSID2
+    { WIFI_SSID2, WIFI_PASSWORD2 },
+#endif
+#ifdef WIFI_SSID3
+    { WIFI_SSID3, WIFI_PASSWORD3 },
+#endif
+};
+
+#define WIFI_AP_COUNT (sizeof(WIFI_APS) / sizeof(WIFI_APS[0]))
+
+// =================================================
+// CACHE DO ÚLTIMO AP BOM
+// =================================================
+// Memória RTC de usuário em blocos de 4 bytes. Os 128 primeiros bytes
+// (blocos 0-31) são do comando do eboot no OTA.
+
+#define WIFI_CACHE_RTC_OFFSET 32
+
+struct WifiCache {
+    uint32_t crc;        // crc32 do resto da estrutura
+    uint8_t apIndex;
+    uint8_t channel;
+    uint8_t bssid[6];
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t mask;
+    uint32_t dns;
+};
+
+static WifiCache cache;
+static bool cacheValid = false;
+
+static uint32_t cacheCrc(const WifiCache& c) {
+    return crc32((const uint8_t*)&c + sizeof(c.crc), sizeof(c) - sizeof(c.crc));
+}
+
+static bool cacheCheck(const WifiCache& c) {
+    return c.crc == cacheCrc(c) && c.apIndex < WIFI_AP_COUNT &&
+           c.channel >= 1 && c.channel <= 14;
+}
+
+static void loadCache() {
+    WifiCache c;
+
+    if (ESP.rtcUserMemoryRead(WIFI_CACHE_RTC_OFFSET, (uint32_t*)&c, sizeof(c)) && cacheCheck(c)) {
+        cache = c;
+        cacheValid = true;
+        return;
     }
 
-    if (verbose) {
-        Serial.print("📡 Conectando ao WiFi");
+    // Falta de energia apaga a RTC: tenta a cópia do Preferences
+    Preferences prefs;
+    prefs.begin(PREFS_NAMESPACE_SYSTEM, true);
+    size_t len = prefs.getBytes(KEY_WIFI_CACHE, &c, sizeof(c));
+    prefs.end();
+
+    if (len == sizeof(c) && cacheCheck(c)) {
+        cache = c;
+        cacheValid = true;
     }
+}
 
-    WiFi.mode(WIFI_STA);
-    WiFi.begin(WIFI_SSID, WIFI_PASSWORD);
+static void saveCache(uint8_t apIndex) {
+    WifiCache c;
+    memset(&c, 0, sizeof(c));
+    c.apIndex = apIndex;
+    c.channel = WiFi.channel();
+    memcpy(c.bssid, WiFi.BSSID(), sizeof(c.bssid));
+    c.ip      = (uint32_t)WiFi.localIP();
+    c.gateway = (uint32_t)WiFi.gatewayIP();
+    c.mask    = (uint32_t)WiFi.subnetMask();
+    c.dns     = (uint32_t)WiFi.dnsIP(0);
+    c.crc     = cacheCrc(c);
 
-    unsigned long start = millis();
-    const unsigned long timeout = 10000; // 10s
+    ESP.rtcUserMemoryWrite(WIFI_CACHE_RTC_OFFSET, (uint32_t*)&c, sizeof(c));
 
-    while (WiFi.status() != WL_CONNECTED && millis() - start < timeout) {
-        delay(500);
-        if (verbose) Serial.print(".");
+    // Flash só quando mudou (troca de AP, canal ou concessão)
+    if (!cacheValid || c.crc != cache.crc) {
+        Preferences prefs;
+        prefs.begin(PREFS_NAMESPACE_SYSTEM, false);
+        prefs.putBytes(KEY_WIFI_CACHE, &c, sizeof(c));
+        prefs.end();
     }
 
-    if (WiFi.status() == WL_CONNECTED) {
-        if (verbose) {
-            Serial.println("\n✅ WiFi conectado");
-            Serial.println(WiFi.localIP());
-        }
-        return true;
+    cache = c;
+    cacheValid = true;
+}
+
+// =================================================
+// ESTADO
+// =================================================
+
+static WifiState wifiState = WIFI_STATE_IDLE;
+static WiFiEventHandler gotIpHandler;
+static WiFiEventHandler disconnectedHandler;
+
+// Escritos pelos eventos, consumidos no wifiLoop()
+static volatile bool evGotIp = false;
+static volatile bool evDisconnected = false;
+static volatile uint8_t evReason = 0;
+
+static unsigned long stateSince = 0;
+static unsigned long backoffMs = WIFI_BACKOFF_MIN_MS;
+static unsigned long connectedSince = 0;
+static unsigned long outageStart = 0;
+static uint32_t reconnects = 0;
+static uint32_t lastOutageSeconds = 0;
+static uint32_t lastReconnectMs = 0;
+static uint8_t lastReason = 0;
+static uint8_t attempts = 0;
+
+// Tentativa em andamento
+static bool attemptFast = false;
+static bool lastFast = false;
+static bool fastFailed = false;     // caminho rápido já falhou nesta queda
+static uint8_t apCursor = 0;        // próximo AP do caminho completo
+static uint8_t attemptAp = 0;
+
+// =================================================
+// TRANSIÇÕES
+// =================================================
+
+static void enterState(WifiState s) {
+    wifiState = s;
+    stateSince = millis();
+}
+
+static void configureIp(bool fast) {
+#ifdef WIFI_STATIC_IP
+    (void)fast;
+    IPAddress ip, gateway, mask, dns;
+    ip.fromString(WIFI_STATIC_IP);
+    gateway.fromString(WIFI_STATIC_GATEWAY);
+    mask.fromString(WIFI_STATIC_MASK);
+    dns.fromString(WIFI_STATIC_DNS);
+    WiFi.config(ip, gateway, mask, dns);
+#else
+    if (fast && WIFI_FAST_REUSE_LEASE && cache.ip != 0) {
+        WiFi.config(IPAddress(cache.ip), IPAddress(cache.gateway),
+                    IPAddress(cache.mask), IPAddress(cache.dns));
     } else {
-        if (verbose) {
-            Serial.println("\n⚠️ Falha no WiFi — modo offline");
-        }
+        // 0.0.0.0 volta ao DHCP
+        WiFi.config(IPAddress(0u), IPAddress(0u), IPAddress(0u));
+    }
+#endif
+}
+
+static void startConnect() {
+    attempts++;
+    attemptFast = cacheValid && !fastFailed;
+
+    if (attemptFast) {
+        attemptAp = cache.apIndex;
+    } else {
+        attemptAp = apCursor;
+        apCursor = (apCursor + 1) % WIFI_AP_COUNT;
+    }
+
+    const WifiAp& ap = WIFI_APS[attemptAp];
+
+    #if DEBUG_MAIN
+    Serial.printf("📡 Conectando a '%s' (tentativa %u, %s)\n", ap.ssid, attempts,
+                  attemptFast ? "rápida" : "varredura");
+    #endif
+
+    configureIp(attemptFast);
+
+    if (attemptFast) {
+        WiFi.begin(ap.ssid, ap.password, cache.channel, cache.bssid);
+    } else {
+        WiFi.begin(ap.ssid, ap.password);
+    }
+    enterState(WIFI_STATE_CONNECTING);
+}
+
+static void startBackoff() {
+    WiFi.disconnect();
+
+    #if DEBUG_MAIN
+    Serial.printf("⚠️ WiFi indisponível, nova tentativa em %lus\n", backoffMs / 1000);
+    #endif
+
+    enterState(WIFI_STATE_BACKOFF);
+}
+
+// Tentativa falhou: rápida cai para varredura na hora; varredura
+// passa para o próximo AP e, depois de todos, espera o backoff
+static void attemptFailed() {
+    if (attemptFast) {
+        fastFailed = true;
         WiFi.disconnect();
-        return false;
+        startConnect();
+        return;
     }
-}
\ No newline at end of file
+
+    if (apCursor != 0) {
+        WiFi.disconnect();
+        startConnect();
+        return;
+    }
+
+    startBackoff();
+}
+
+// =================================================
+// API
+// =================================================
+
+void wifiBegin() {
+    if (wifiState != WIFI_STATE_IDLE) return;
+
+    // Reconexão é nossa (com backoff), não do SDK
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+
+    gotIpHandler = WiFi.onStationModeGotIP([](const WiFiEventStationModeGotIP&) {
+        evGotIp = true;
+    });
+    disconnectedHandler = WiFi.onStationModeDisconnected([](const WiFiEventStationModeDisconnected& e) {
+        evReason = (uint8_t)e.reason;
+        evDisconnected = true;
+    });
+
+    loadCache();
+
+    outageStart = millis();
+    startConnect();
+}
+
+void wifiLoop() {
+    unsigned long now = millis();
+
+    if (evDisconnected) {
+        evDisconnected = false;
+        lastReason = evReason;
+
+        if (wifiState == WIFI_STATE_CONNECTED) {
+            // Queda: começa a contar a indisponibilidade e tenta já
+            reconnects++;
+            outageStart = now;
+            backoffMs = WIFI_BACKOFF_MIN_MS;
+            attempts = 0;
+            fastFailed = false;
+            apCursor = 0;
+
+            Serial.printf("⚠️ WiFi caiu (motivo %u)\n", lastReason);
+            startConnect();
+        } else if (wifiState == WIFI_STATE_CONNECTING &&
+                   lastReason != WIFI_DISCONNECT_REASON_ASSOC_LEAVE) {
+            // Falha de associação/autenticação. ASSOC_LEAVE é o nosso
+            // próprio disconnect() ao trocar de tentativa.
+            attemptFailed();
+        }
+    }
+
+    if (evGotIp) {
+        evGotIp = false;
+
+        if (wifiState != WIFI_STATE_CONNECTED) {
+            connectedSince = now;
+            lastReconnectMs = now - outageStart;
+            lastOutageSeconds = lastReconnectMs / 1000;
+            lastFast = attemptFast;
+            backoffMs = WIFI_BACKOFF_MIN_MS;
+            attempts = 0;
+            fastFailed = false;
+            apCursor = 0;
+            saveCache(attemptAp);
+            enterState(WIFI_STATE_CONNECTED);
+
+            Serial.print(F("✅ WiFi conectado: "));
+            Serial.print(WiFi.localIP());
+            Serial.printf(" em %lu ms (%s)\n", (unsigned long)lastReconnectMs,
+                          lastFast ? "rápida" : "varredura");
+        }
+    }
+
+    switch (wifiState) {
+        case WIFI_STATE_CONNECTING:
+            if (now - stateSince >= (attemptFast ? WIFI_FAST_TIMEOUT_MS : WIFI_CONNECT_TIMEOUT_MS)) {
+                attemptFailed();
+            }
+            break;
+
+        case WIFI_STATE_BACKOFF:
+            if (now - stateSince >= backoffMs) {
+                backoffMs *= 2;
+                if (backoffMs > WIFI_BACKOFF_MAX_MS) backoffMs = WIFI_BACKOFF_MAX_MS;
+                startConnect();
+            }
+            break;
+
+        case WIFI_STATE_CONNECTED:
+            // Evento perdido: o status do driver é a referência
+            if (WiFi.status() != WL_CONNECTED) {
+                evDisconnected = true;
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+bool wifiIsConnected() {
+    return wifiState == WIFI_STATE_CONNECTED && WiFi.status() == WL_CONNECTED;
+}
+
+WifiState wifiGetState() {
+    return wifiState;
+}
+
+const char* wifiStateName() {
+    switch (wifiState) {
+        case WIFI_STATE_CONNECTING: return "conectando";
+        case WIFI_STATE_CONNECTED:  return "conectado";
+        case WIFI_STATE_BACKOFF:    return "aguardando";
+        default:                    return "parado";
+    }
+}
+
+unsigned long wifiConnectedSince() {
+    return connectedSince;
+}
+
+uint32_t wifiGetReconnects() {
+    return reconnects;
+}
+
+uint32_t wifiLastOutageSeconds() {
+    return lastOutageSeconds;
+}
+
+uint8_t wifiLastDisconnectReason() {
+    return lastReason;
+}
+
+uint32_t wifiLastReconnectMs() {
+    return lastReconnectMs;
+}
+
+bool wifiLastReconnectFast() {
+    return lastFast;
+}
+
+const char* wifiCurrentSsid() {
+    return WIFI_APS[attemptAp].ssid;
+}
@@ -2,4 +2,57 @@
 #pragma once
 #include <ESP8266WiFi.h>
 
-bool setupWiFi(bool verbose = true);
\ No newline at end of file
+// ========================================
+// MÁQUINA DE ESTADOS DO WIFI
+// ========================================
+// Conexão e reconexão sem bloqueio: WiFi.begin() dispara a associação e os
+// eventos onStationModeGotIP/Disconnected avisam o resultado. wifiLoop()
+// só confere timeouts e backoff, então uma queda longa do roteador não
+// trava o controle, o servidor web nem o OTA.
+//
+// Caminho rápido: o último AP bom (BSSID, canal e concessão de IP) fica
+// na memória RTC (sobrevive a reset) e no Preferences (sobrevive a falta
+// de energia). A reconexão vai direto a esse AP, sem varredura (o IP vem
+// do DHCP, a não ser com WIFI_FAST_REUSE_LEASE). Se falhar em
+// WIFI_FAST_TIMEOUT_MS, a tentativa seguinte faz o caminho completo
+// (varredura + DHCP), passando pelos APs configurados em secrets.h
+// (WIFI_SSID, WIFI_SSID2, WIFI_SSID3).
+
+enum WifiState : uint8_t {
+    WIFI_STATE_IDLE = 0,     // ainda não iniciado
+    WIFI_STATE_CONNECTING,   // WiFi.begin() em andamento
+    WIFI_STATE_CONNECTED,    // com IP
+    WIFI_STATE_BACKOFF       // aguardando para tentar de novo
+};
+
+#define WIFI_CONNECT_TIMEOUT_MS   15000UL   // desiste da tentativa após 15s
+#define WIFI_BACKOFF_MIN_MS       2000UL
+#define WIFI_BACKOFF_MAX_MS       300000UL  // 5 min
+#define WIFI_FAST_TIMEOUT_MS      3000UL    // caminho rápido desiste após 3s
+
+// Reusa o IP do último DHCP como estático no caminho rápido. Desligado:
+// o IP fixo não renova a concessão, e depois que ela expira o roteador pode
+// entregar o mesmo endereço a outro aparelho (conflito de IP). Ligar só com
+// reserva de IP no roteador. Com WIFI_STATIC_IP definido em secrets.h, vale
+// sempre o IP fixo.
+#define WIFI_FAST_REUSE_LEASE     0
+
+// Registra os eventos e dispara a primeira conexão (não bloqueia)
+void wifiBegin();
+
+// Chamar a cada passe do loop(): timeouts e backoff
+void wifiLoop();
+
+// Estado em tempo real (atualizado pelos eventos)
+bool wifiIsConnected();
+WifiState wifiGetState();
+const char* wifiStateName();
+unsigned long wifiConnectedSince();     // millis() do último IP obtido
+uint32_t wifiGetReconnects();           // quedas desde o boot
+uint32_t wifiLastOutageSeconds();       // duração da última queda
+uint8_t wifiLastDisconnectReason();
+
+// Da queda (ou do boot) até obter IP, em ms, e se veio pelo caminho rápido
+uint32_t wifiLastReconnectMs();
+bool wifiLastReconnectFast();
+const char* wifiCurrentSsid();
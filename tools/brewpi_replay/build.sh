@@ -0,0 +1,25 @@
+#!/bin/sh
+# build.sh - Compila o replay do controle BrewPi no host
+# Usa os fontes reais de src/ com os shims de shim/ no lugar do core ESP8266.
+set -e
+cd "$(dirname "$0")"
+
+SRC=../../src
+OUT=.build
+
+# src/ inclui "BrewPiStructs.h", mas o arquivo é Brewpistructs.h
+# (no Windows/macOS o FS ignora a caixa; no Linux não)
+mkdir -p "$OUT/include"
+cp "$SRC/Brewpistructs.h" "$OUT/include/BrewPiStructs.h"
+
+${CXX:-g++} -std=c++17 -O2 -Wall -Wno-unused-variable \
+    -Ishim -I"$OUT/include" -I"$SRC" \
+    replay.cpp \
+    "$SRC/BrewPiTempControl.cpp" \
+    "$SRC/TempSensor.cpp" \
+    "$SRC/BrewPiTicks.cpp" \
+    "$SRC/BrewPiTrace.cpp" \
+    "$SRC/HeaterPwm.cpp" \
+    -o brewpi_replay
+
+echo "✅ brewpi_replay compilado"
@@ -0,0 +1,475 @@
+// replay.cpp - Replay determinístico de traces do controle BrewPi no host
+//
+// Lê um arquivo gravado pelo BrewPiTrace (GET /trace no ESP), restaura o
+// snapshot do controle e alimenta o MESMO código de src/ (BrewPiTempControl,
+// TempSensor, BrewPiTicks) com as leituras brutas e os eventos gravados.
+// Cada decisão de relé (TRACE_REC_OUTPUT) é comparada bit a bit, assim como
+// o agendamento das malhas (tick com ou sem PID da cerveja).
+//
+// Compilação:  ./build.sh
+// Uso:         ./brewpi_replay brewpi_trace.bin [-v] [--slope N]
+//
+// --slope N  roda em paralelo, sobre as mesmas leituras brutas, o filtro de
+//            slope original e a regressão com janela de N amostras, e compara
+//            os dois contra uma referência não causal (regressão centrada).
+//
+// Código de saída: 0 = idêntico, 1 = divergência, 2 = arquivo inválido
+
+#include <stdio.h>
+#include <math.h>
+#include <vector>
+#include <deque>
+
+#include "BrewPiTempControl.h"
+#include "BrewPiTrace.h"
+
+// ========================================
+// AMBIENTE DO HOST
+// ========================================
+
+uint32_t hostMillis = 0;
+HostSerial Serial;
+HostFS LittleFS;
+
+struct PendingProbe {
+    uint8_t index;
+    float tempC;
+};
+
+static std::deque<PendingProbe> pendingProbes;
+static unsigned long probeMismatches = 0;
+
+float DallasTemperature::getTempCByIndex(uint8_t index) {
+    if (pendingProbes.empty()) {
+        probeMismatches++;
+        return DEVICE_DISCONNECTED_C;
+    }
+
+    PendingProbe p = pendingProbes.front();
+    pendingProbes.pop_front();
+
+    if (p.index != index) {
+        probeMismatches++;
+    }
+    return p.tempC;
+}
+
+static DallasTemperature replaySensors;
+static Rele replayCooler = {PINO_COOLER, false, false, "COOLER"};
+static Rele replayHeater = {PINO_HEATER, false, false, "HEATER"};
+
+// ========================================
+// LEITURA DO ARQUIVO
+// ========================================
+
+class TraceReader {
+public:
+    explicit TraceReader(const std::vector<uint8_t>& d) : data(d), pos(0) {}
+
+    bool eof() const { return pos >= data.size(); }
+    size_t offset() const { return pos; }
+
+    bool has(size_t n) const { return pos + n <= data.size(); }
+
+    uint8_t peek() const { return data[pos]; }
+
+    template <typename T>
+    T read() {
+        T v;
+        memcpy(&v, &data[pos], sizeof(T));
+        pos += sizeof(T);
+        return v;
+    }
+
+    const uint8_t* take(size_t n) {
+        const uint8_t* p = &data[pos];
+        pos += n;
+        return p;
+    }
+
+private:
+    const std::vector<uint8_t>& data;
+    size_t pos;
+};
+
+static size_t payloadSize(uint8_t type) {
+    switch (type) {
+        case TRACE_REC_TICK:           return 5;
+        case TRACE_REC_PROBE:          return 5;
+        case TRACE_REC_BEER_SETTING:   return 6;
+        case TRACE_REC_FRIDGE_SETTING: return 6;
+        case TRACE_REC_MODE:           return 6;
+        case TRACE_REC_RESET:          return 4;
+        case TRACE_REC_OUTPUT:         return 4;
+        case TRACE_REC_FEEDFORWARD:    return 6;
+        default:                       return 0;
+    }
+}
+
+static const char* stateName(uint8_t s) {
+    static const char* names[] = {
+        "IDLE", "OFF", "DOOR_OPEN", "HEATING", "COOLING", "WAITING_TO_COOL",
+        "WAITING_TO_HEAT", "WAITING_FOR_PEAK_DETECT", "COOLING_MIN_TIME",
+        "HEATING_MIN_TIME"
+    };
+    return s < NUM_STATES ? names[s] : "?";
+}
+
+// ========================================
+// COMPARAÇÃO DE ESTIMADORES DE SLOPE
+// ========================================
+
+#define SLOPE_REF_HALF_WINDOW 12   // referência: ±12 amostras (~±1 min)
+#define SLOPE_MAX_LAG 120          // busca de atraso até 120 amostras
+
+struct SlopeSeries {
+    const char* name;
+    TempSensor legacy;
+    TempSensor regression;
+    bool configured;
+    std::vector<double> t;      // segundos
+    std::vector<double> raw;    // °C
+    std::vector<double> sLegacy;
+    std::vector<double> sRegression;
+
+    SlopeSeries(const char* n, uint8_t idx)
+        : name(n), legacy(&replaySensors, idx), regression(&replaySensors, idx), configured(false) {}
+
+    void configure(uint8_t fast, uint8_t slow, uint8_t slopeCoeff, uint8_t window) {
+        TempSensor* all[2] = { &legacy, &regression };
+        for (TempSensor* ts : all) {
+            ts->setFastFilterCoefficients(fast);
+            ts->setSlowFilterCoefficients(slow);
+            ts->setSlopeFilterCoefficients(slopeCoeff);
+        }
+        legacy.setSlopeWindow(0);
+        regression.setSlopeWindow(window);
+        configured = true;
+    }
+
+    void feed(float tempC) {
+        legacy.processReading(tempC);
+        regression.processReading(tempC);
+        if (!legacy.isConnected()) return;
+
+        t.push_back(hostMillis / 1000.0);
+        raw.push_back(tempC);
+        sLegacy.push_back(tempToFloat(legacy.readSlope() + C_OFFSET));
+        sRegression.push_back(tempToFloat(regression.readSlope() + C_OFFSET));
+    }
+
+    // Regressão centrada (não causal) sobre as leituras brutas, em °C/h
+    std::vector<double> reference() const {
+        std::vector<double> ref(raw.size(), NAN);
+        for (size_t k = SLOPE_REF_HALF_WINDOW; k + SLOPE_REF_HALF_WINDOW < raw.size(); k++) {
+            double mt = 0, my = 0;
+            size_t a = k - SLOPE_REF_HALF_WINDOW, b = k + SLOPE_REF_HALF_WINDOW;
+            for (size_t i = a; i <= b; i++) { mt += t[i]; my += raw[i]; }
+            mt /= (b - a + 1); my /= (b - a + 1);
+            double sxy = 0, sxx = 0;
+            for (size_t i = a; i <= b; i++) {
+                sxy += (t[i] - mt) * (raw[i] - my);
+                sxx += (t[i] - mt) * (t[i] - mt);
+            }
+            if (sxx > 0) ref[k] = sxy / sxx * 3600.0;
+        }
+        return ref;
+    }
+
+    static void metrics(const std::vector<double>& est, const std::vector<double>& ref,
+                        double dt, double& rms, double& noise, double& lagSeconds) {
+        double se = 0; size_t ne = 0;
+        for (size_t k = 0; k < est.size(); k++) {
+            if (std::isnan(ref[k])) continue;
+            se += (est[k] - ref[k]) * (est[k] - ref[k]);
+            ne++;
+        }
+        rms = ne ? sqrt(se / ne) : 0;
+
+        double sn = 0;
+        for (size_t k = 1; k < est.size(); k++) {
+            sn += (est[k] - est[k - 1]) * (est[k] - est[k - 1]);
+        }
+        noise = est.size() > 1 ? sqrt(sn / (est.size() - 1)) : 0;
+
+        // Atraso: deslocamento que maximiza a correlação estimador × referência
+        double best = -2; int bestLag = 0;
+        for (int lag = 0; lag <= SLOPE_MAX_LAG; lag++) {
+            double sa = 0, sb = 0, saa = 0, sbb = 0, sab = 0; size_t m = 0;
+            for (size_t k = lag; k < est.size(); k++) {
+                double r = ref[k - lag];
+                if (std::isnan(r)) continue;
+                sa += est[k]; sb += r; saa += est[k] * est[k]; sbb += r * r; sab += est[k] * r; m++;
+            }
+            if (m < 10) break;
+            double cov = sab / m - (sa / m) * (sb / m);
+            double va = saa / m - (sa / m) * (sa / m);
+            double vb = sbb / m - (sb / m) * (sb / m);
+            if (va <= 0 || vb <= 0) continue;
+            double corr = cov / sqrt(va * vb);
+            if (corr > best) { best = corr; bestLag = lag; }
+        }
+        lagSeconds = bestLag * dt;
+    }
+
+    void report(uint8_t window) const {
+        if (raw.size() < 2 * SLOPE_REF_HALF_WINDOW + 2) {
+            printf("%-10s amostras insuficientes\n", name);
+            return;
+        }
+        std::vector<double> ref = reference();
+        double dt = (t.back() - t.front()) / (t.size() - 1);
+        double rmsL, noiseL, lagL, rmsR, noiseR, lagR;
+        metrics(sLegacy, ref, dt, rmsL, noiseL, lagL);
+        metrics(sRegression, ref, dt, rmsR, noiseR, lagR);
+        printf("%-10s %-16s erro RMS %7.3f °C/h  ruído %7.3f °C/h  atraso %5.0fs\n",
+               name, "filtro original", rmsL, noiseL, lagL);
+        printf("%-10s regressão N=%-4u erro RMS %7.3f °C/h  ruído %7.3f °C/h  atraso %5.0fs\n",
+               name, window, rmsR, noiseR, lagR);
+    }
+};
+
+// ========================================
+// REPLAY
+// ========================================
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "uso: %s <trace.bin> [-v]\n", argv[0]);
+        return 2;
+    }
+    bool verbose = false;
+    uint8_t slopeWindow = 0;
+    for (int a = 2; a < argc; a++) {
+        if (strcmp(argv[a], "-v") == 0) verbose = true;
+        else if (strcmp(argv[a], "--slope") == 0 && a + 1 < argc) slopeWindow = (uint8_t)atoi(argv[++a]);
+    }
+
+    SlopeSeries beerSlope("cerveja", 1);
+    SlopeSeries fridgeSlope("geladeira", 0);
+
+    FILE* f = fopen(argv[1], "rb");
+    if (!f) {
+        fprintf(stderr, "❌ Não foi possível abrir %s\n", argv[1]);
+        return 2;
+    }
+    std::vector<uint8_t> data;
+    uint8_t buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        data.insert(data.end(), buf, buf + n);
+    }
+    fclose(f);
+
+    TraceReader in(data);
+    if (!in.has(5) || memcmp(in.take(4), BREWPI_TRACE_MAGIC, 4) != 0) {
+        fprintf(stderr, "❌ Cabeçalho inválido\n");
+        return 2;
+    }
+    uint8_t version = in.read<uint8_t>();
+    if (version != BREWPI_TRACE_VERSION) {
+        fprintf(stderr, "❌ Versão de trace %u não suportada (esperado %u)\n",
+                version, BREWPI_TRACE_VERSION);
+        return 2;
+    }
+
+    BrewPiTempControl& ctl = brewPiControl;
+    bool haveSnapshot = false;
+    unsigned long segments = 0, tickCount = 0, outputs = 0, divergences = 0;
+    unsigned long beerLoopTicks = 0, scheduleMismatches = 0;
+    unsigned long events = 0;
+
+    while (!in.eof()) {
+        uint8_t type = in.read<uint8_t>();
+
+        if (type == TRACE_REC_SNAPSHOT) {
+            if (!in.has(2)) break;
+            uint16_t len = in.read<uint16_t>();
+            if (!in.has(len)) break;
+            if (len != sizeof(ControlSnapshot)) {
+                fprintf(stderr, "❌ Snapshot de %u bytes, este build espera %u "
+                        "(trace de outra versão do firmware?)\n",
+                        len, (unsigned)sizeof(ControlSnapshot));
+                return 2;
+            }
+            ControlSnapshot snap;
+            memcpy(&snap, in.take(len), len);
+
+            if (!haveSnapshot) {
+                ctl.setSensors(&replaySensors, 1, 0);
+                ctl.setActuators(&replayCooler, &replayHeater);
+                probeMismatches = 0;  // leituras do init() descartadas
+            }
+            pendingProbes.clear();
+            ctl.restoreSnapshot(snap);
+            haveSnapshot = true;
+
+            if (slopeWindow > 0 && !beerSlope.configured) {
+                beerSlope.configure(snap.cc.beerFastFilter, snap.cc.beerSlowFilter,
+                                    snap.cc.beerSlopeFilter, slopeWindow);
+                fridgeSlope.configure(snap.cc.fridgeFastFilter, snap.cc.fridgeSlowFilter,
+                                      snap.cc.fridgeSlopeFilter, slopeWindow);
+            }
+            segments++;
+            continue;
+        }
+
+        size_t len = payloadSize(type);
+        if (len == 0) {
+            fprintf(stderr, "❌ Registro desconhecido 0x%02x no offset %lu\n",
+                    type, (unsigned long)in.offset() - 1);
+            return 2;
+        }
+        if (!in.has(len)) break;  // registro truncado (queda de energia)
+
+        if (!haveSnapshot) {
+            in.take(len);
+            continue;
+        }
+
+        switch (type) {
+            case TRACE_REC_TICK: {
+                hostMillis = in.read<uint32_t>();
+                uint8_t recLoops = in.read<uint8_t>();
+
+                // Leituras desta execução de update() vêm logo após o tick
+                while (in.has(1 + payloadSize(TRACE_REC_PROBE)) && in.peek() == TRACE_REC_PROBE) {
+                    in.read<uint8_t>();
+                    PendingProbe p;
+                    p.index = in.read<uint8_t>();
+                    p.tempC = in.read<float>();
+                    pendingProbes.push_back(p);
+                }
+
+                if (slopeWindow > 0) {
+                    for (const PendingProbe& p : pendingProbes) {
+                        (p.index == 1 ? beerSlope : fridgeSlope).feed(p.tempC);
+                    }
+                }
+
+                ctl.update();
+                tickCount++;
+
+                bool beerLoop = (recLoops & TRACE_TICK_BEER_LOOP) != 0;
+                if (beerLoop) beerLoopTicks++;
+                if (beerLoop != ctl.lastTickRanBeerLoop()) {
+                    scheduleMismatches++;
+                    if (verbose || scheduleMismatches <= 20) {
+                        printf("⚠️  t=%lus malha da cerveja: gravado=%d replay=%d\n",
+                               (unsigned long)(hostMillis / 1000),
+                               beerLoop ? 1 : 0, ctl.lastTickRanBeerLoop() ? 1 : 0);
+                    }
+                }
+
+                if (!pendingProbes.empty()) {
+                    probeMismatches += pendingProbes.size();
+                    pendingProbes.clear();
+                }
+                break;
+            }
+
+            case TRACE_REC_BEER_SETTING: {
+                hostMillis = in.read<uint32_t>();
+                ctl.setBeerTemp(in.read<int16_t>());
+                events++;
+                break;
+            }
+
+            case TRACE_REC_FRIDGE_SETTING: {
+                hostMillis = in.read<uint32_t>();
+                ctl.setFridgeTemp(in.read<int16_t>());
+                events++;
+                break;
+            }
+
+            case TRACE_REC_MODE: {
+                hostMillis = in.read<uint32_t>();
+                char mode = (char)in.read<uint8_t>();
+                bool force = in.read<uint8_t>() != 0;
+                ctl.setMode(mode, force);
+                events++;
+                break;
+            }
+
+            case TRACE_REC_RESET: {
+                hostMillis = in.read<uint32_t>();
+                ctl.reset();
+                events++;
+                break;
+            }
+
+            case TRACE_REC_FEEDFORWARD: {
+                hostMillis = in.read<uint32_t>();
+                ctl.setGravityDropRate(in.read<int16_t>());
+                events++;
+                break;
+            }
+
+            case TRACE_REC_PROBE: {
+                // Leitura fora de update() (ex.: init de sensor)
+                in.take(len);
+                break;
+            }
+
+            case TRACE_REC_OUTPUT: {
+                uint8_t recState = in.read<uint8_t>();
+                uint8_t recFlags = in.read<uint8_t>();
+                uint16_t recDuty = in.read<uint16_t>();
+                uint8_t flags = (ctl.stateIsCooling() ? TRACE_OUT_COOLER : 0) |
+                                (ctl.stateIsHeating() ? TRACE_OUT_HEATER : 0);
+                uint16_t duty = ctl.getHeaterDuty();
+                outputs++;
+
+                if (recState != ctl.getState() || recFlags != flags || recDuty != duty) {
+                    divergences++;
+                    if (verbose || divergences <= 20) {
+                        printf("⚠️  t=%lus gravado=%s c%d h%d d%u  replay=%s c%d h%d d%u\n",
+                               (unsigned long)(hostMillis / 1000),
+                               stateName(recState),
+                               (recFlags & TRACE_OUT_COOLER) ? 1 : 0,
+                               (recFlags & TRACE_OUT_HEATER) ? 1 : 0,
+                               recDuty,
+                               stateName(ctl.getState()),
+                               (flags & TRACE_OUT_COOLER) ? 1 : 0,
+                               (flags & TRACE_OUT_HEATER) ? 1 : 0,
+                               duty);
+                    }
+                } else if (verbose) {
+                    printf("   t=%lus %s c%d h%d d%u  beer=%.3f fridge=%.3f set=%.3f\n",
+                           (unsigned long)(hostMillis / 1000),
+                           stateName(recState),
+                           (recFlags & TRACE_OUT_COOLER) ? 1 : 0,
+                           (recFlags & TRACE_OUT_HEATER) ? 1 : 0,
+                           recDuty,
+                           tempToFloat(ctl.getBeerTemp()),
+                           tempToFloat(ctl.getFridgeTemp()),
+                           tempToFloat(ctl.getFridgeSetting()));
+                }
+                break;
+            }
+        }
+    }
+
+    printf("\n━━━━━━━━ REPLAY ━━━━━━━━\n");
+    printf("Trechos:       %lu\n", segments);
+    printf("Ticks:         %lu (PID cerveja: %lu)\n", tickCount, beerLoopTicks);
+    printf("Eventos:       %lu\n", events);
+    printf("Saídas:        %lu\n", outputs);
+    printf("Leituras fora de ordem: %lu\n", probeMismatches);
+    printf("Divergências:  %lu\n", divergences);
+    printf("Agendamento:   %lu divergências\n", scheduleMismatches);
+    printf("━━━━━━━━━━━━━━━━━━━━━━━━\n");
+
+    if (slopeWindow > 0) {
+        printf("\n━━━━━━━━ SLOPE ━━━━━━━━\n");
+        beerSlope.report(slopeWindow);
+        fridgeSlope.report(slopeWindow);
+        printf("━━━━━━━━━━━━━━━━━━━━━━━━\n");
+    }
+
+    if (!haveSnapshot) {
+        fprintf(stderr, "❌ Nenhum snapshot encontrado\n");
+        return 2;
+    }
+    return (divergences == 0 && probeMismatches == 0 && scheduleMismatches == 0) ? 0 : 1;
+}
@@ -0,0 +1,79 @@
+// Arduino.h - Shim mínimo para compilar o controle BrewPi no host (replay)
+#pragma once
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+#include <string>
+#include <type_traits>
+
+// ========================================
+// TEMPO (controlado pelo replay)
+// ========================================
+
+extern uint32_t hostMillis;
+
+inline unsigned long millis() { return hostMillis; }
+inline unsigned long micros() { return hostMillis * 1000UL; }
+inline void delay(unsigned long) {}
+inline void delayMicroseconds(unsigned int) {}
+inline void yield() {}
+
+// ========================================
+// GPIO
+// ========================================
+
+#define HIGH 1
+#define LOW 0
+#define OUTPUT 1
+#define INPUT 0
+#define D5 14
+#define D6 12
+#define D7 13
+
+inline void pinMode(uint8_t, uint8_t) {}
+inline void digitalWrite(uint8_t, uint8_t) {}
+
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type min(A a, B b) { return a < b ? a : b; }
+template <typename A, typename B>
+inline typename std::common_type<A, B>::type max(A a, B b) { return a > b ? a : b; }
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+// ========================================
+// STRING / SERIAL
+// ========================================
+
+class __FlashStringHelper;
+#define F(s) (s)
+
+class String {
+public:
+    String() {}
+    String(const char* s) : str(s ? s : "") {}
+    String(const std::string& s) : str(s) {}
+    String(int v) : str(std::to_string(v)) {}
+    String(unsigned long v) : str(std::to_string(v)) {}
+    const char* c_str() const { return str.c_str(); }
+    unsigned int length() const { return str.length(); }
+    bool isEmpty() const { return str.empty(); }
+    String& operator+=(const String& o) { str += o.str; return *this; }
+    bool operator==(const String& o) const { return str == o.str; }
+    bool operator!=(const String& o) const { return str != o.str; }
+private:
+    std::string str;
+};
+
+class HostSerial {
+public:
+    void begin(unsigned long) {}
+    template <typename T> void print(const T&) {}
+    template <typename T> void println(const T&) {}
+    void println() {}
+    int printf(const char*, ...) { return 0; }
+};
+
+extern HostSerial Serial;
@@ -0,0 +1,17 @@
+// DallasTemperature.h - Shim para replay no host
+// As leituras vêm dos registros TRACE_REC_PROBE do arquivo de trace.
+#pragma once
+
+#include <Arduino.h>
+#include <OneWire.h>
+
+#define DEVICE_DISCONNECTED_C -127
+
+class DallasTemperature {
+public:
+    DallasTemperature() {}
+    explicit DallasTemperature(OneWire*) {}
+
+    // Implementada em replay.cpp
+    float getTempCByIndex(uint8_t index);
+};
@@ -0,0 +1,24 @@
+// LittleFS.h - Shim para replay no host (sem sistema de arquivos)
+#pragma once
+
+#include <Arduino.h>
+
+class File {
+public:
+    explicit operator bool() const { return false; }
+    size_t write(const uint8_t*, size_t) { return 0; }
+    size_t read(uint8_t*, size_t) { return 0; }
+    size_t size() const { return 0; }
+    void flush() {}
+    void close() {}
+};
+
+class HostFS {
+public:
+    File open(const char*, const char*) { return File(); }
+    bool exists(const char*) { return false; }
+    bool remove(const char*) { return false; }
+    bool rename(const char*, const char*) { return false; }
+};
+
+extern HostFS LittleFS;
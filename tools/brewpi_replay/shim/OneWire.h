@@ -0,0 +1,10 @@
+// OneWire.h - Shim para replay no host
+#pragma once
+
+#include <Arduino.h>
+
+class OneWire {
+public:
+    OneWire() {}
+    explicit OneWire(uint8_t) {}
+};
@@ -0,0 +1,11 @@
+// Ticker.h - Shim para replay no host (o timer nunca dispara)
+#pragma once
+
+#include <Arduino.h>
+
+class Ticker {
+public:
+    template <typename TArg>
+    void attach_ms(uint32_t, void (*)(TArg), TArg) {}
+    void detach() {}
+};
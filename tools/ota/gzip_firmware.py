@@ -0,0 +1,53 @@
+# gzip_firmware.py - Gera a imagem OTA comprimida após o build (PlatformIO)
+#
+# Registrado em platformio.ini (extra_scripts = post:tools/ota/gzip_firmware.py).
+# Ao lado de .pio/build/<env>/firmware.bin grava:
+#
+#   firmware.bin.gz   imagem para o OTA (o Updater do core ESP8266 aceita
+#                     gzip e o bootloader descomprime ao instalar)
+#   firmware.md5      md5 do .bin (é o que GET /version mostra depois do boot)
+#   firmware.gz.md5   md5 do .gz (parâmetro hash do /ota/start)
+#
+# Envio: tools/ota/ota_upload.py
+
+Import("env")
+
+import gzip
+import hashlib
+import os
+
+
+def md5_of(path):
+    h = hashlib.md5()
+    with open(path, "rb") as f:
+        for chunk in iter(lambda: f.read(65536), b""):
+            h.update(chunk)
+    return h.hexdigest()
+
+
+def gzip_firmware(source, target, env):
+    bin_path = str(target[0])
+    gz_path = bin_path + ".gz"
+    base = os.path.splitext(bin_path)[0]
+
+    with open(bin_path, "rb") as f_in:
+        data = f_in.read()
+
+    # mtime fixo: o mesmo .bin gera sempre o mesmo .gz (e o mesmo md5)
+    with open(gz_path, "wb") as f_out:
+        with gzip.GzipFile(filename="", mode="wb", compresslevel=9,
+                           fileobj=f_out, mtime=0) as gz:
+            gz.write(data)
+
+    with open(base + ".md5", "w") as f:
+        f.write(md5_of(bin_path) + "\n")
+    with open(base + ".gz.md5", "w") as f:
+        f.write(md5_of(gz_path) + "\n")
+
+    bin_size = os.path.getsize(bin_path)
+    gz_size = os.path.getsize(gz_path)
+    print("OTA gzip: %s (%d -> %d bytes, %.0f%%)"
+          % (os.path.basename(gz_path), bin_size, gz_size, 100.0 * gz_size / bin_size))
+
+
+env.AddPostAction("$BUILD_DIR/${PROGNAME}.bin", gzip_firmware)
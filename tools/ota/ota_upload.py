@@ -0,0 +1,128 @@
+#!/usr/bin/env python3
+# ota_upload.py - Envia firmware comprimido pelo ElegantOTA e confere o boot
+#
+# Uso:
+#   python3 tools/ota/ota_upload.py 192.168.0.50
+#   python3 tools/ota/ota_upload.py 192.168.0.50 --bin .pio/build/d1_mini/firmware.bin
+#
+# 1. GET  /ota/start?mode=fr&hash=<md5 do .gz>   (o Updater confere o md5)
+# 2. POST /ota/upload com o firmware.bin.gz       (mede bytes e tempo)
+# 3. Espera o reboot e compara o md5 de GET /version com o md5 do .bin
+#
+# Sem o .gz (build sem o extra_script), comprime o .bin na hora.
+# Código de saída: 0 = firmware novo rodando, 1 = falha
+
+import argparse
+import gzip
+import hashlib
+import json
+import os
+import sys
+import time
+import urllib.error
+import urllib.request
+import uuid
+
+DEFAULT_BIN = ".pio/build/d1_mini/firmware.bin"
+
+
+def md5_hex(data):
+    return hashlib.md5(data).hexdigest()
+
+
+def http_get(url, timeout):
+    with urllib.request.urlopen(url, timeout=timeout) as r:
+        return r.status, r.read()
+
+
+def upload(host, payload, timeout):
+    boundary = uuid.uuid4().hex
+    head = ("--%s\r\n"
+            "Content-Disposition: form-data; name=\"file\"; filename=\"firmware.bin.gz\"\r\n"
+            "Content-Type: application/octet-stream\r\n\r\n" % boundary).encode()
+    tail = ("\r\n--%s--\r\n" % boundary).encode()
+    body = head + payload + tail
+
+    req = urllib.request.Request("http://%s/ota/upload" % host, data=body, method="POST")
+    req.add_header("Content-Type", "multipart/form-data; boundary=%s" % boundary)
+    req.add_header("Content-Length", str(len(body)))
+
+    with urllib.request.urlopen(req, timeout=timeout) as r:
+        return r.status, r.read().decode(errors="replace")
+
+
+def wait_version(host, expected_md5, timeout):
+    deadline = time.time() + timeout
+    last = None
+    while time.time() < deadline:
+        time.sleep(3)
+        try:
+            _, body = http_get("http://%s/version" % host, 5)
+            info = json.loads(body)
+            last = info.get("md5")
+            if last == expected_md5:
+                return True, info
+        except (urllib.error.URLError, OSError, ValueError):
+            pass  # ainda reiniciando
+    return False, {"md5": last}
+
+
+def main():
+    ap = argparse.ArgumentParser(description="OTA comprimido (gzip) para o fermentador")
+    ap.add_argument("host", help="IP ou nome do ESP")
+    ap.add_argument("--bin", default=DEFAULT_BIN, help="firmware.bin (o .gz ao lado é usado se existir)")
+    ap.add_argument("--timeout", type=int, default=180, help="segundos para upload e para o reboot")
+    args = ap.parse_args()
+
+    with open(args.bin, "rb") as f:
+        raw = f.read()
+
+    gz_path = args.bin + ".gz"
+    if os.path.exists(gz_path) and os.path.getmtime(gz_path) >= os.path.getmtime(args.bin):
+        with open(gz_path, "rb") as f:
+            payload = f.read()
+    else:
+        payload = gzip.compress(raw, compresslevel=9, mtime=0)
+
+    raw_md5 = md5_hex(raw)
+    gz_md5 = md5_hex(payload)
+
+    print("📦 Firmware: %d bytes, gzip: %d bytes (%.0f%%)"
+          % (len(raw), len(payload), 100.0 * len(payload) / len(raw)))
+
+    try:
+        status, body = http_get("http://%s/ota/start?mode=fr&hash=%s" % (args.host, gz_md5), 10)
+        if status != 200:
+            print("❌ /ota/start: HTTP %d %s" % (status, body))
+            return 1
+
+        t0 = time.time()
+        status, body = upload(args.host, payload, args.timeout)
+        elapsed = time.time() - t0
+    except urllib.error.HTTPError as e:
+        print("❌ OTA recusado: HTTP %d %s" % (e.code, e.read().decode(errors="replace")))
+        return 1
+    except (urllib.error.URLError, OSError) as e:
+        print("❌ Falha de rede: %s" % e)
+        return 1
+
+    print("📤 Enviados %d bytes em %.1fs (%.1f kB/s)"
+          % (len(payload), elapsed, len(payload) / 1024.0 / max(elapsed, 0.001)))
+    print("   Sem compressão seriam ~%.1fs" % (elapsed * len(raw) / len(payload)))
+
+    if status != 200:
+        print("❌ Upload: HTTP %d %s" % (status, body))
+        return 1
+
+    print("🔄 Aguardando reboot...")
+    ok, info = wait_version(args.host, raw_md5, args.timeout)
+    if not ok:
+        print("❌ md5 em /version (%s) difere do .bin (%s)" % (info.get("md5"), raw_md5))
+        return 1
+
+    print("✅ Firmware %s rodando (md5 %s)" % (info.get("version", "?"), raw_md5))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
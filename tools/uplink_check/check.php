@@ -0,0 +1,72 @@
+<?php
+// check.php - Confere o lote gerado por uplink_check com o decodificador do servidor
+//
+// Decodifica uplink_batch.msgpack com msgpackDecodePhp() (o mesmo código do
+// api.php quando a extensão msgpack não está instalada) e compara campo a
+// campo com uplink_batch.json. Floats vêm em float32: tolerância relativa.
+//
+// Código de saída: 0 = igual, 1 = divergência ou MessagePack inválido
+
+require_once __DIR__ . '/../../data/classes/MsgPack.php';
+
+function compareValues($path, $expected, $actual, &$errors) {
+    if (is_array($expected)) {
+        if (!is_array($actual)) {
+            $errors[] = "$path: esperado array/objeto, veio " . gettype($actual);
+            return;
+        }
+        if (count($expected) !== count($actual)) {
+            $errors[] = "$path: " . count($expected) . " itens no JSON, " . count($actual) . " no MessagePack";
+        }
+        foreach ($expected as $key => $value) {
+            if (!array_key_exists($key, $actual)) {
+                $errors[] = "$path.$key: ausente no MessagePack";
+                continue;
+            }
+            compareValues("$path.$key", $value, $actual[$key], $errors);
+        }
+        return;
+    }
+
+    if (is_float($expected) || is_float($actual)) {
+        if (!is_numeric($actual) || !is_numeric($expected)) {
+            $errors[] = "$path: esperado número, veio " . var_export($actual, true);
+            return;
+        }
+        $scale = max(1.0, abs((float)$expected));
+        if (abs((float)$expected - (float)$actual) > 1e-5 * $scale) {
+            $errors[] = "$path: $expected != $actual";
+        }
+        return;
+    }
+
+    if ($expected !== $actual) {
+        $errors[] = "$path: " . var_export($expected, true) . " != " . var_export($actual, true);
+    }
+}
+
+$packed = file_get_contents('uplink_batch.msgpack');
+$json = json_decode(file_get_contents('uplink_batch.json'), true);
+if ($packed === false || $json === null) {
+    fwrite(STDERR, "❌ Rode uplink_check antes (arquivos do lote ausentes)\n");
+    exit(1);
+}
+
+try {
+    $decoded = msgpackDecodePhp($packed);
+} catch (InvalidArgumentException $e) {
+    fwrite(STDERR, "❌ MessagePack inválido: " . $e->getMessage() . "\n");
+    exit(1);
+}
+
+$errors = [];
+compareValues('batch', $json, $decoded, $errors);
+
+if ($errors) {
+    foreach ($errors as $error) fwrite(STDERR, "❌ $error\n");
+    exit(1);
+}
+
+$sections = array_diff(array_keys($decoded), ['seq']);
+echo "✅ Lote decodificado igual ao JSON (" . implode(', ', $sections) . ")\n";
+exit(0);
@@ -0,0 +1,30 @@
+#!/bin/sh
+# check.sh - Confere no host o uplink em MessagePack (esp/batch)
+#
+# 1. Audita os fontes que montam documentos do lote: serialized() grava texto
+#    cru, que no MessagePack vira bytes soltos e o servidor recusa o lote.
+# 2. Compila uplink_check com o ArduinoJson do PlatformIO e gera o lote.
+# 3. Decodifica com o decodificador PHP do servidor e compara com o JSON.
+#
+# ARDUINOJSON aponta para o src/ da biblioteca (padrão: .pio/libdeps)
+set -e
+cd "$(dirname "$0")"
+
+SRC=../../src
+ARDUINOJSON=${ARDUINOJSON:-../../.pio/libdeps/d1_mini/ArduinoJson/src}
+
+# Tudo que passa por addToBatch()/packBody()
+UPLINK="http_client.cpp mysql_sender.cpp telemetry_queue.cpp ispindel_envio.cpp controle_fermentacao.cpp"
+
+found=0
+for f in $UPLINK; do
+    if grep -n "serialized(" "$SRC/$f"; then
+        echo "❌ $f: serialized() em documento que pode ir em MessagePack"
+        found=1
+    fi
+done
+[ "$found" -eq 0 ] || exit 1
+
+${CXX:-g++} -std=c++17 -O2 -Wall -I"$ARDUINOJSON" uplink_check.cpp -o uplink_check
+./uplink_check
+${PHP:-php} check.php
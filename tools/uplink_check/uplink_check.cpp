@@ -0,0 +1,169 @@
+// uplink_check.cpp - Gera um esp/batch de exemplo em MessagePack e em JSON
+//
+// Monta, com o ArduinoJson do firmware, um lote com as mesmas seções, nomes
+// e tipos que o ESP envia (heartbeat com control_status completo, estado
+// em delta, controle, leituras da fila offline e iSpindel) e grava:
+//
+//   uplink_batch.msgpack   corpo como o packBody() envia
+//   uplink_batch.json      o mesmo documento em JSON (referência)
+//
+// check.php decodifica o .msgpack com o decodificador do servidor
+// (data/classes/MsgPack.php) e compara com o .json.
+//
+// Uso: ./check.sh (audita src/, compila, gera e confere)
+
+#include <stdio.h>
+#include <math.h>
+#include <string>
+
+#include <ArduinoJson.h>
+
+static bool writeFile(const char* path, const std::string& data) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return false;
+    size_t n = fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    return n == data.size();
+}
+
+// http_client.cpp: sendHeartbeat()
+static void addHeartbeat(JsonDocument& batch) {
+    JsonObject doc = batch["heartbeat"].add<JsonObject>();
+    doc["config_id"] = 15;
+    doc["uptime"] = 86400;
+    doc["free_heap"] = 23840;
+    doc["temp_fermenter"] = 18.4375f;
+    doc["temp_fridge"] = 12.0625f;
+    doc["cooler_active"] = 1;
+    doc["heater_active"] = 0;
+
+    JsonObject ctrl = doc["control_status"].to<JsonObject>();
+    ctrl["state"] = "Cooling";
+    ctrl["is_waiting"] = false;
+    ctrl["heater_duty"] = 125 / 10.0f;
+    ctrl["ff"] = -0.35f;
+    ctrl["estimated_peak"] = 17.9f;
+
+    JsonObject wifi = ctrl["wifi"].to<JsonObject>();
+    wifi["rssi"] = -67;
+    wifi["reconnects"] = 2;
+    wifi["reconnect_ms"] = 1830;
+    wifi["fast"] = true;
+    wifi["last_outage_s"] = 42;
+    wifi["last_reason"] = 200;
+
+    JsonObject http = ctrl["http"].to<JsonObject>();
+    http["reuse_pct"] = 96;
+    http["connects"] = 12;
+    http["sent"] = 2880;
+    http["fail"] = 3;
+    http["avg_ms"] = 182;
+    http["pack_bytes"] = 1254330UL;
+    http["json_bytes"] = 1730112UL;
+    http["pack_us"] = 640;
+    http["heap_min"] = 17112;
+    http["block_min"] = 9208;
+    http["frag_max"] = 31;
+    http["parse_us"] = 910;
+    http["not_modified"] = 2870;
+
+    JsonObject boot = ctrl["boot"].to<JsonObject>();
+    boot["first_tick_ms"] = 412;
+    boot["wifi_ms"] = 3120;
+    boot["sync_ms"] = 19450;
+
+    JsonObject ota = ctrl["ota"].to<JsonObject>();
+    ota["state"] = "confirmed";
+    ota["backup"] = true;
+
+    // Mesma expressão do firmware para o drift
+    float driftPpm = 38.47f;
+    JsonObject clk = ctrl["clock"].to<JsonObject>();
+    clk["synced"] = true;
+    clk["err_ms"] = 135;
+    clk["drift_ppm"] = roundf(driftPpm * 10) / 10.0f;
+}
+
+// mysql_sender.cpp: sendStateUpdate() (delta)
+static void addStateDelta(JsonDocument& batch) {
+    JsonObject rec = batch["state"].add<JsonObject>();
+    rec["config_id"] = "15";
+    rec["seq"] = 48213UL;
+    rec["base"] = 48190UL;
+    rec["status"] = "running";
+    rec["message"] = nullptr;   // campo removido desde a base
+
+    JsonObject timeRemaining = rec["timeRemaining"].to<JsonObject>();
+    timeRemaining["value"] = 3.25f;
+    timeRemaining["unit"] = "days";
+    timeRemaining["status"] = "running";
+}
+
+// http_client.cpp: updateControlState()
+static void addControl(JsonDocument& batch) {
+    JsonObject rec = batch["control"].add<JsonObject>();
+    rec["config_id"] = "15";
+    rec["setpoint"] = 18.0f;
+    rec["cooling"] = true;
+    rec["heating"] = false;
+}
+
+// telemetry_queue.cpp: telemetryQueueLoop() (seq e dt de cada registro)
+static void addQueuedReadings(JsonDocument& batch) {
+    for (int i = 0; i < 3; i++) {
+        JsonObject rec = batch["readings"].add<JsonObject>();
+        rec["cid"] = "15";
+        rec["tf"] = 11.9375f + i * 0.0625f;
+        rec["tb"] = 18.5f;
+        rec["tt"] = 18.0f;
+        rec["seq"] = 4294000000UL + i;
+        rec["dt"] = 1769500800UL + i * 60;
+    }
+
+    JsonObject err = batch["readings"].add<JsonObject>();
+    err["cid"] = "15";
+    err["sensor_error"] = true;
+    err["tt"] = 18.0f;
+}
+
+// ispindel_envio.cpp
+static void addIspindel(JsonDocument& batch) {
+    JsonObject rec = batch["ispindel"].add<JsonObject>();
+    rec["name"] = "iSpindel-Fermentação";
+    rec["temperature"] = 18.25f;
+    rec["gravity"] = 1.0125f;
+    rec["angle"] = 42.817f;
+    rec["battery"] = 3.91f;
+    rec["seq"] = 4294000003UL;
+}
+
+int main() {
+    JsonDocument batch;
+    batch["seq"] = 2918340121UL;   // época da sequência (telemetryQueueEpoch)
+
+    addHeartbeat(batch);
+    addStateDelta(batch);
+    addControl(batch);
+    addQueuedReadings(batch);
+    addIspindel(batch);
+
+    std::string packed;
+    serializeMsgPack(batch, packed);
+
+    std::string json;
+    serializeJson(batch, json);
+
+    if (packed.size() != measureMsgPack(batch)) {
+        fprintf(stderr, "❌ MessagePack com tamanho diferente do medido\n");
+        return 1;
+    }
+
+    if (!writeFile("uplink_batch.msgpack", packed) || !writeFile("uplink_batch.json", json)) {
+        fprintf(stderr, "❌ Falha ao gravar os arquivos do lote\n");
+        return 1;
+    }
+
+    printf("Lote: %u bytes MessagePack, %u bytes JSON\n",
+           (unsigned)packed.size(), (unsigned)json.size());
+    return 0;
+}